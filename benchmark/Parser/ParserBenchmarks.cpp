@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include "../../src/Parser/Parser.h"
+#include "../../src/Scanner/Scanner.h"
+
+#include <string>
+#include <vector>
+
+using namespace jlang;
+
+namespace
+{
+
+// About 1 MiB of functions with nested control flow and expression-heavy statements
+std::string LargeProgram()
+{
+    const char *function = "fn mix(seed: i32, count: i32) -> i32\n"
+                           "{\n"
+                           "    var total: i32 = seed;\n"
+                           "    for (var i: i32 = 0; i < count; i++)\n"
+                           "    {\n"
+                           "        if (total % 2 == 0 && i > 3)\n"
+                           "        {\n"
+                           "            total = total * 31 + i * 4 - total / 2;\n"
+                           "        }\n"
+                           "        else\n"
+                           "        {\n"
+                           "            total += i ^ 7;\n"
+                           "        }\n"
+                           "    }\n"
+                           "    return total;\n"
+                           "}\n"
+                           "\n";
+
+    std::string source;
+    while (source.size() < (1u << 20))
+    {
+        source += function;
+    }
+    return source;
+}
+
+} // namespace
+
+static void BM_ParseLargeProgram(benchmark::State &state)
+{
+    std::string source = LargeProgram();
+    Scanner scanner(source);
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    for (auto _ : state)
+    {
+        AstArena arena;
+        Parser parser(tokens, arena);
+        std::vector<AstNode *> program = parser.Parse();
+        benchmark::DoNotOptimize(program.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * tokens.size());
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_ParseLargeProgram)->Unit(benchmark::kMillisecond);
+
+namespace
+{
+
+// return (1 + (2 * (3 - (4 / ... )))); every level is a grouped binary expression
+std::string NestedExpression(int depth)
+{
+    const char *ops[] = {" + ", " * ", " - ", " / "};
+    std::string open;
+    std::string close;
+    for (int i = 0; i < depth; ++i)
+    {
+        open += "(" + std::to_string(i) + ops[i % 4];
+        close += ")";
+    }
+    return "fn f() -> i32 { return " + open + "0" + close + "; }";
+}
+
+// return a + b * c - d << e ...; one flat expression cycling through every precedence level
+std::string WideExpression(int terms)
+{
+    const char *ops[] = {" + ", " * ", " - ", " << ", " & ", " == ", " | ", " < ", " && ", " || ", " % "};
+    std::string expression = "0";
+    for (int i = 1; i < terms; ++i)
+    {
+        expression += ops[i % 11];
+        expression += "v" + std::to_string(i % 97);
+    }
+    return "fn f() -> i32 { return " + expression + "; }";
+}
+
+void ParseSource(benchmark::State &state, const std::string &source)
+{
+    Scanner scanner(source);
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    for (auto _ : state)
+    {
+        AstArena arena;
+        Parser parser(tokens, arena);
+        std::vector<AstNode *> program = parser.Parse();
+        benchmark::DoNotOptimize(program.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * tokens.size());
+}
+
+} // namespace
+
+static void BM_ParseNestedExpression(benchmark::State &state)
+{
+    ParseSource(state, NestedExpression(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_ParseNestedExpression)->Arg(64)->Arg(1024);
+
+static void BM_ParseWideExpression(benchmark::State &state)
+{
+    ParseSource(state, WideExpression(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_ParseWideExpression)->Arg(1024)->Arg(65536);
@@ -0,0 +1,165 @@
+#include <benchmark/benchmark.h>
+
+#include "../../src/Scanner/Keywords.h"
+#include "../../src/Scanner/Scanner.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace jlang;
+
+namespace
+{
+
+// A realistic mix: roughly one in three words is a keyword, the rest are user identifiers
+const std::vector<std::string> &IdentifierMix()
+{
+    static const std::vector<std::string> words = [] {
+        std::vector<std::string> result;
+        const char *samples[] = {"var",    "counter", "i32",     "while", "index",     "return",
+                                 "person", "Name",    "fn",      "total", "interface", "buffer_size",
+                                 "if",     "value",   "checksum", "null", "alloc",     "nodeCount"};
+        for (int i = 0; i < 1024; ++i)
+        {
+            result.emplace_back(samples[i % (sizeof(samples) / sizeof(samples[0]))]);
+        }
+        return result;
+    }();
+    return words;
+}
+
+std::string IdentifierSource()
+{
+    std::string source;
+    for (const auto &word : IdentifierMix())
+    {
+        source += word;
+        source += ' ';
+    }
+    return source;
+}
+
+} // namespace
+
+// The lookup the scanner used before: a std::string per identifier plus a node-based hash map
+static void BM_KeywordLookupUnorderedMap(benchmark::State &state)
+{
+    std::unordered_map<std::string, TokenType> keywordMap;
+    for (const Keyword &keyword : s_Keywords)
+    {
+        keywordMap.emplace(std::string(keyword.text), keyword.type);
+    }
+
+    const std::vector<std::string> &words = IdentifierMix();
+    std::vector<std::string_view> views(words.begin(), words.end());
+
+    for (auto _ : state)
+    {
+        for (std::string_view word : views)
+        {
+            auto it = keywordMap.find(std::string(word));
+            benchmark::DoNotOptimize(it != keywordMap.end() ? it->second : TokenType::Identifier);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * views.size());
+}
+BENCHMARK(BM_KeywordLookupUnorderedMap);
+
+static void BM_KeywordLookupPerfectHash(benchmark::State &state)
+{
+    const std::vector<std::string> &words = IdentifierMix();
+    std::vector<std::string_view> views(words.begin(), words.end());
+
+    for (auto _ : state)
+    {
+        for (std::string_view word : views)
+        {
+            benchmark::DoNotOptimize(LookupKeyword(word));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * views.size());
+}
+BENCHMARK(BM_KeywordLookupPerfectHash);
+
+static void BM_ScanIdentifiers(benchmark::State &state)
+{
+    std::string source = IdentifierSource();
+
+    for (auto _ : state)
+    {
+        Scanner scanner(source);
+        std::vector<Token> tokens = scanner.Tokenize();
+        benchmark::DoNotOptimize(tokens.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * IdentifierMix().size());
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_ScanIdentifiers);
+
+namespace
+{
+
+// About 1 MiB of indented, commented code, the shape that whitespace and comment skipping see in practice
+std::string LargeSource()
+{
+    const char *function = "/*\n"
+                           " * Computes the running checksum of a buffer. The comment is long on purpose,\n"
+                           " * documentation headers like this one are common in real sources.\n"
+                           " */\n"
+                           "fn checksum(buffer: *i32, length: i32) -> i32\n"
+                           "{\n"
+                           "    var total: i32 = 0;            // accumulated value\n"
+                           "    var index: i32 = 0;\n"
+                           "\n"
+                           "    while (index < length)\n"
+                           "    {\n"
+                           "        total = total * 31 + index; // mix in the position\n"
+                           "        index++;\n"
+                           "    }\n"
+                           "\n"
+                           "    return total;\n"
+                           "}\n"
+                           "\n";
+
+    std::string source;
+    while (source.size() < (1u << 20))
+    {
+        source += function;
+    }
+    return source;
+}
+
+} // namespace
+
+static void BM_ScanLargeSource(benchmark::State &state)
+{
+    std::string source = LargeSource();
+
+    for (auto _ : state)
+    {
+        Scanner scanner(source);
+        std::vector<Token> tokens = scanner.Tokenize();
+        benchmark::DoNotOptimize(tokens.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_ScanLargeSource);
+
+static void BM_BuildLineTable(benchmark::State &state)
+{
+    std::string source = LargeSource();
+
+    for (auto _ : state)
+    {
+        LineTable lineTable(source);
+        benchmark::DoNotOptimize(lineTable.GetLocation(static_cast<uint32_t>(source.size() - 1)));
+    }
+
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_BuildLineTable);
@@ -3,13 +3,21 @@
 #include "../CodeGen/AstVisitor.h"
 #include "../Enums/NodeTypes.h"
 
-#include <memory>
 #include <string>
 #include <vector>
 
 namespace jlang
 {
 
+// Source attribute, written #[name] or #[name(arg, ...)] in front of the construct it annotates.
+// Arguments keep their source spelling, what they mean is up to the code that reads them.
+struct Attribute
+{
+    std::string name;
+    std::vector<std::string> args;
+};
+
+// Nodes are owned by the AstArena of the compilation unit, pointers to them are non-owning
 struct AstNode
 {
     NodeType type;
@@ -19,6 +27,4 @@ struct AstNode
     virtual void Accept(AstVisitor &visitor) = 0;
 };
 
-using AstNodePtr = std::shared_ptr<AstNode>;
-
 } // namespace jlang
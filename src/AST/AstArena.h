@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jlang
+{
+
+// Bump-pointer arena that owns every AST node of one compilation unit. Nodes are placed back to
+// back in large blocks and referenced by raw pointer, the whole tree is released at once when the
+// arena goes away. Nodes that own heap memory (strings, child vectors) get their destructors run,
+// in reverse order of allocation; trivially destructible types are just dropped with the blocks.
+class AstArena
+{
+  public:
+    AstArena() = default;
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    ~AstArena()
+    {
+        for (auto it = m_Destructors.rbegin(); it != m_Destructors.rend(); ++it)
+        {
+            it->destroy(it->object);
+        }
+    }
+
+    template <typename T, typename... Args> T *Make(Args &&...args)
+    {
+        T *object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            m_Destructors.push_back({object, [](void *p) { static_cast<T *>(p)->~T(); }});
+        }
+
+        return object;
+    }
+
+    // Bytes handed out so far, not counting block slack
+    size_t GetBytesAllocated() const { return m_BytesAllocated; }
+
+  private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    void *Allocate(size_t size, size_t alignment)
+    {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(m_Cursor) % alignment) % alignment;
+
+        if (m_Cursor == nullptr || padding + size > static_cast<size_t>(m_End - m_Cursor))
+        {
+            // Requests larger than a block get a block of their own
+            size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+            m_Blocks.push_back(std::make_unique<std::byte[]>(blockSize));
+            m_Cursor = m_Blocks.back().get();
+            m_End = m_Cursor + blockSize;
+            padding = (alignment - reinterpret_cast<uintptr_t>(m_Cursor) % alignment) % alignment;
+        }
+
+        void *result = m_Cursor + padding;
+        m_Cursor += padding + size;
+        m_BytesAllocated += size;
+        return result;
+    }
+
+    struct Destructor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> m_Blocks;
+    std::vector<Destructor> m_Destructors;
+
+    std::byte *m_Cursor = nullptr;
+    std::byte *m_End = nullptr;
+    size_t m_BytesAllocated = 0;
+};
+
+} // namespace jlang
@@ -1,30 +1,43 @@
 #pragma once
 
+#include "../../Enums/OperatorTypes.h"
 #include "../Ast.h"
 #include "../TopLevelDecl/TopLevelDecl.h"
 
+#include <optional>
+
 namespace jlang
 {
 
 struct Expression : public AstNode
 {
+    TypeRef resolvedType; // Exact jlang type, filled in by the TypeAnnotator before codegen
 };
 
 struct CallExpr : public Expression
 {
     std::string callee;
-    std::vector<std::shared_ptr<AstNode>> arguments;
+    std::vector<AstNode *> arguments;
 
     CallExpr() { type = NodeType::CallExpr; }
 
     void Accept(AstVisitor &visitor) override { visitor.VisitCallExpr(*this); }
 };
 
+// SIMD builtins are calls the TypeAnnotator and the code generator handle themselves. Their names are
+// reserved, a function cannot be declared with one of them.
+inline bool IsVectorBuiltin(const std::string &name)
+{
+    return name == "splat" || name == "load" || name == "load_aligned" || name == "store" ||
+           name == "store_aligned" || name == "shuffle" || name == "reduce_add" || name == "reduce_mul" ||
+           name == "reduce_min" || name == "reduce_max";
+}
+
 struct BinaryExpr : public Expression
 {
-    std::string op;
-    std::shared_ptr<AstNode> left;
-    std::shared_ptr<AstNode> right;
+    BinaryOp op = BinaryOp::Add;
+    AstNode *left = nullptr;
+    AstNode *right = nullptr;
 
     BinaryExpr() { type = NodeType::BinaryExpr; }
 
@@ -33,8 +46,8 @@ struct BinaryExpr : public Expression
 
 struct UnaryExpr : public Expression
 {
-    std::string op;
-    std::shared_ptr<AstNode> operand;
+    UnaryOp op = UnaryOp::Not;
+    AstNode *operand = nullptr;
 
     UnaryExpr() { type = NodeType::UnaryExpr; }
 
@@ -62,7 +75,7 @@ struct LiteralExpr : public Expression
 struct CastExpr : public Expression
 {
     TypeRef targetType;
-    std::shared_ptr<AstNode> expr;
+    AstNode *expr = nullptr;
 
     CastExpr() { type = NodeType::CastExpr; }
 
@@ -81,7 +94,7 @@ struct AllocExpr : public Expression
 struct AssignExpr : public Expression
 {
     std::string name;
-    std::shared_ptr<AstNode> value;
+    AstNode *value = nullptr;
 
     AssignExpr() { type = NodeType::AssignExpr; }
 
@@ -90,7 +103,7 @@ struct AssignExpr : public Expression
 
 struct MemberAccessExpr : public Expression
 {
-    std::shared_ptr<AstNode> object;
+    AstNode *object = nullptr;
     std::string memberName;
 
     MemberAccessExpr() { type = NodeType::MemberAccessExpr; }
@@ -100,8 +113,8 @@ struct MemberAccessExpr : public Expression
 
 struct PrefixExpr : public Expression
 {
-    std::string op; // "++" or "--"
-    std::shared_ptr<AstNode> operand;
+    UnaryOp op = UnaryOp::Increment; // Increment or Decrement
+    AstNode *operand = nullptr;
 
     PrefixExpr() { type = NodeType::PrefixExpr; }
 
@@ -110,12 +123,64 @@ struct PrefixExpr : public Expression
 
 struct PostfixExpr : public Expression
 {
-    std::string op; // "++" or "--"
-    std::shared_ptr<AstNode> operand;
+    UnaryOp op = UnaryOp::Increment; // Increment or Decrement
+    AstNode *operand = nullptr;
 
     PostfixExpr() { type = NodeType::PostfixExpr; }
 
     void Accept(AstVisitor &visitor) override { visitor.VisitPostfixExpr(*this); }
 };
 
+// a[i] on an array, slice or pointer
+struct IndexExpr : public Expression
+{
+    AstNode *object = nullptr;
+    AstNode *index = nullptr;
+
+    IndexExpr() { type = NodeType::IndexExpr; }
+
+    void Accept(AstVisitor &visitor) override { visitor.VisitIndexExpr(*this); }
+};
+
+// a[i] = value, or a[i] op= value with the element read and written through one address
+struct IndexAssignExpr : public Expression
+{
+    IndexExpr *target = nullptr;
+    AstNode *value = nullptr;
+    std::optional<BinaryOp> compoundOp;
+
+    IndexAssignExpr() { type = NodeType::IndexAssignExpr; }
+
+    void Accept(AstVisitor &visitor) override { visitor.VisitIndexAssignExpr(*this); }
+};
+
+// p.Field = value, or p.Field op= value with the field read and written through one address
+struct MemberAssignExpr : public Expression
+{
+    MemberAccessExpr *target = nullptr;
+    AstNode *value = nullptr;
+    std::optional<BinaryOp> compoundOp;
+
+    MemberAssignExpr() { type = NodeType::MemberAssignExpr; }
+
+    void Accept(AstVisitor &visitor) override { visitor.VisitMemberAssignExpr(*this); }
+};
+
+struct FieldInitializer
+{
+    std::string name;
+    AstNode *value = nullptr;
+};
+
+// Point{X: 1, Y: 2}, a struct value. Fields left out are zero.
+struct StructLiteralExpr : public Expression
+{
+    std::string structName;
+    std::vector<FieldInitializer> fields;
+
+    StructLiteralExpr() { type = NodeType::StructLiteralExpr; }
+
+    void Accept(AstVisitor &visitor) override { visitor.VisitStructLiteralExpr(*this); }
+};
+
 } // namespace jlang
@@ -11,9 +11,9 @@ struct Statement : public AstNode
 
 struct IfStatement : public Statement
 {
-    std::shared_ptr<AstNode> condition;
-    std::shared_ptr<AstNode> thenBranch;
-    std::shared_ptr<AstNode> elseBranch;
+    AstNode *condition = nullptr;
+    AstNode *thenBranch = nullptr;
+    AstNode *elseBranch = nullptr;
 
     IfStatement() { type = NodeType::IfStatement; }
 
@@ -22,8 +22,9 @@ struct IfStatement : public Statement
 
 struct WhileStatement : public Statement
 {
-    std::shared_ptr<AstNode> condition;
-    std::shared_ptr<AstNode> body;
+    AstNode *condition = nullptr;
+    AstNode *body = nullptr;
+    std::vector<Attribute> attributes; // Loop hints such as #[unroll(4)]
 
     WhileStatement() { type = NodeType::WhileStatement; }
 
@@ -32,10 +33,11 @@ struct WhileStatement : public Statement
 
 struct ForStatement : public Statement
 {
-    std::shared_ptr<AstNode> init;
-    std::shared_ptr<AstNode> condition;
-    std::shared_ptr<AstNode> update;
-    std::shared_ptr<AstNode> body;
+    AstNode *init = nullptr;
+    AstNode *condition = nullptr;
+    AstNode *update = nullptr;
+    AstNode *body = nullptr;
+    std::vector<Attribute> attributes; // Loop hints such as #[unroll(4)]
 
     ForStatement() { type = NodeType::ForStatement; }
 
@@ -44,7 +46,7 @@ struct ForStatement : public Statement
 
 struct BlockStatement : public Statement
 {
-    std::vector<std::shared_ptr<AstNode>> statements;
+    std::vector<AstNode *> statements;
 
     BlockStatement() { type = NodeType::BlockStatement; }
 
@@ -53,7 +55,7 @@ struct BlockStatement : public Statement
 
 struct ExprStatement : public Statement
 {
-    std::shared_ptr<AstNode> expression;
+    AstNode *expression = nullptr;
 
     ExprStatement() { type = NodeType::ExprStatement; }
 
@@ -62,11 +64,37 @@ struct ExprStatement : public Statement
 
 struct ReturnStatement : public Statement
 {
-    std::shared_ptr<AstNode> value;
+    AstNode *value = nullptr;
 
     ReturnStatement() { type = NodeType::ReturnStatement; }
 
     void Accept(AstVisitor &visitor) override { visitor.VisitReturnStatement(*this); }
 };
 
+// A constant, or a range of constants: low..high excludes high, low..=high includes it
+struct MatchPattern
+{
+    AstNode *low = nullptr;
+    AstNode *high = nullptr; // nullptr for a single value
+    bool isInclusive = false;
+};
+
+struct MatchArm
+{
+    std::vector<MatchPattern> patterns; // Alternatives separated by '|'
+    bool isWildcard = false;            // The '_' arm, taken when no other arm matches
+    AstNode *body = nullptr;
+};
+
+// match (value) { 1 | 2 => ...; 'a'..='z' => ...; _ => ... }
+struct MatchStatement : public Statement
+{
+    AstNode *value = nullptr;
+    std::vector<MatchArm> arms;
+
+    MatchStatement() { type = NodeType::MatchStatement; }
+
+    void Accept(AstVisitor &visitor) override { visitor.VisitMatchStatement(*this); }
+};
+
 } // namespace jlang
@@ -2,6 +2,8 @@
 
 #include "../Ast.h"
 
+#include <cstdint>
+
 namespace jlang
 {
 
@@ -10,6 +12,84 @@ struct TypeRef
     std::string name;
     bool isPointer = false;
     bool isNullable = false;
+
+    // [N]T and []T. The element type is described by the fields above.
+    uint64_t arraySize = 0; // N of a fixed-size array, 0 otherwise
+    bool isSlice = false;   // Pointer to the first element plus a length
+
+    bool IsArray() const { return arraySize > 0; }
+
+    // Single value of the named type, not a pointer, array or slice
+    bool IsScalar() const { return !isPointer && !IsArray() && !isSlice; }
+
+    bool IsUnsignedInteger() const
+    {
+        return IsScalar() && (name == "u8" || name == "u16" || name == "u32" || name == "u64");
+    }
+
+    // char is signed, as it is for C on the targets we support
+    bool IsSignedInteger() const
+    {
+        return IsScalar() &&
+               (name == "i8" || name == "i16" || name == "i32" || name == "i64" || name == "char");
+    }
+
+    bool IsInteger() const { return IsSignedInteger() || IsUnsignedInteger(); }
+    bool IsFloat() const { return IsScalar() && (name == "f32" || name == "f64"); }
+    bool IsKnown() const { return !name.empty(); }
+
+    // SIMD vectors are spelled <lane type>x<lanes> and fill a 128 or 256-bit register: f32x4, u8x32, ...
+    bool IsVector() const { return IsScalar() && VectorLanes() > 0; }
+
+    // Lane count of a vector type name, 0 for anything else
+    unsigned VectorLanes() const
+    {
+        size_t split = name.find('x');
+        if (split == std::string::npos || split + 1 == name.size())
+        {
+            return 0;
+        }
+
+        TypeRef lane{name.substr(0, split)};
+        if (!(lane.IsInteger() || lane.IsFloat()) || lane.name == "char")
+        {
+            return 0;
+        }
+
+        unsigned lanes = 0;
+        for (size_t i = split + 1; i < name.size(); ++i)
+        {
+            if (name[i] < '0' || name[i] > '9' || lanes > 64)
+            {
+                return 0;
+            }
+            lanes = lanes * 10 + static_cast<unsigned>(name[i] - '0');
+        }
+
+        unsigned laneBits = static_cast<unsigned>(std::stoul(lane.name.substr(1)));
+        return lanes * laneBits == 128 || lanes * laneBits == 256 ? lanes : 0;
+    }
+
+    // Type of a[i]: the element of an array or slice, the pointee of a pointer, the lane of a vector
+    TypeRef ElementType() const
+    {
+        if (IsArray() || isSlice)
+        {
+            return TypeRef{name, isPointer, isNullable};
+        }
+        if (IsVector())
+        {
+            return TypeRef{name.substr(0, name.find('x'))};
+        }
+        return TypeRef{name};
+    }
+
+    // The type as written in source: [4]Node*?, []u8, f32x8
+    std::string Spelling() const
+    {
+        std::string prefix = IsArray() ? "[" + std::to_string(arraySize) + "]" : (isSlice ? "[]" : "");
+        return prefix + name + (isPointer ? "*" : "") + (isNullable ? "?" : "");
+    }
 };
 
 struct InterfaceDecl : public AstNode
@@ -27,6 +107,7 @@ struct StructField
     std::string name;
     TypeRef type;
     bool isPublic = false; // lowercase = private, Uppercase = public
+    std::vector<Attribute> attributes; // #[align(N)]
 };
 
 struct StructDecl : public AstNode
@@ -34,6 +115,7 @@ struct StructDecl : public AstNode
     std::string name;
     std::string interfaceImplemented;
     std::vector<StructField> fields;
+    std::vector<Attribute> attributes; // #[repr(C)], #[align(N)], #[packed]
 
     StructDecl() { type = NodeType::StructDecl; }
 
@@ -51,7 +133,10 @@ struct FunctionDecl : public AstNode
     std::string name;
     std::vector<Parameter> params;
     TypeRef returnType;
-    std::shared_ptr<AstNode> body;
+    AstNode *body = nullptr;
+    bool isPublic = false;             // lowercase = internal to the file, Uppercase = exported
+    bool isInline = false;             // 'inline fn', a hint for the inliner
+    std::vector<Attribute> attributes; // #[always_inline], #[noinline], #[flatten]
 
     FunctionDecl() { type = NodeType::FunctionDecl; }
 
@@ -62,7 +147,7 @@ struct VariableDecl : public AstNode
 {
     std::string name;
     TypeRef varType;
-    std::shared_ptr<AstNode> initializer;
+    AstNode *initializer = nullptr;
     bool isMutable = true;
 
     VariableDecl() { type = NodeType::VariableDecl; }
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <llvm/Support/Alignment.h>
+
+namespace jlang
+{
+
+// What malloc guarantees on the 64-bit targets we support, alignof(max_align_t). alloc<T>() takes
+// aligned_alloc for stricter structs, and a heap allocation moved to the stack keeps at least this.
+inline const llvm::Align kMallocAlignment(16);
+
+} // namespace jlang
@@ -14,6 +14,7 @@ struct ForStatement;
 struct BlockStatement;
 struct ExprStatement;
 struct ReturnStatement;
+struct MatchStatement;
 struct CallExpr;
 struct BinaryExpr;
 struct UnaryExpr;
@@ -25,6 +26,10 @@ struct AssignExpr;
 struct MemberAccessExpr;
 struct PrefixExpr;
 struct PostfixExpr;
+struct IndexExpr;
+struct IndexAssignExpr;
+struct MemberAssignExpr;
+struct StructLiteralExpr;
 
 class AstVisitor
 {
@@ -42,6 +47,7 @@ class AstVisitor
     virtual void VisitBlockStatement(BlockStatement &) = 0;
     virtual void VisitExprStatement(ExprStatement &) = 0;
     virtual void VisitReturnStatement(ReturnStatement &) = 0;
+    virtual void VisitMatchStatement(MatchStatement &) = 0;
 
     virtual void VisitCallExpr(CallExpr &) = 0;
     virtual void VisitBinaryExpr(BinaryExpr &) = 0;
@@ -54,5 +60,9 @@ class AstVisitor
     virtual void VisitMemberAccessExpr(MemberAccessExpr &) = 0;
     virtual void VisitPrefixExpr(PrefixExpr &) = 0;
     virtual void VisitPostfixExpr(PostfixExpr &) = 0;
+    virtual void VisitIndexExpr(IndexExpr &) = 0;
+    virtual void VisitIndexAssignExpr(IndexAssignExpr &) = 0;
+    virtual void VisitMemberAssignExpr(MemberAssignExpr &) = 0;
+    virtual void VisitStructLiteralExpr(StructLiteralExpr &) = 0;
 };
 } // namespace jlang
\ No newline at end of file
@@ -1,29 +1,107 @@
 #include "CodeGen.h"
+#include "Allocation.h"
+#include "HeapToStack.h"
 
 #include "../Common/Logger.h"
 
 #include <algorithm>
 #include <iostream>
-#include <optional>
+#include <mutex>
+#include <numeric>
 #include <unordered_map>
+#include <unordered_set>
 
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/Triple.h>
+
+#include <llvm/Bitcode/BitcodeWriter.h>
+
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Metadata.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/IR/PassTimingInfo.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
 
 namespace jlang
 {
 
-CodeGenerator::CodeGenerator()
-    : m_Module(std::make_unique<llvm::Module>("JlangModule", m_Context)), m_IRBuilder(m_Context)
+static TypeRef ResolvedTypeOf(AstNode *node)
+{
+    auto *expression = dynamic_cast<Expression *>(node);
+    return expression ? expression->resolvedType : TypeRef();
+}
+
+CodeGenerator::CodeGenerator(llvm::LLVMContext &context)
+    : m_Context(context), m_Module(std::make_unique<llvm::Module>("JlangModule", m_Context)),
+      m_IRBuilder(m_Context)
+{
+    CreateTargetMachine();
+}
+
+void CodeGenerator::CreateTargetMachine()
 {
+    // Target registration mutates global registries, so do it exactly once per process
+    static std::once_flag s_TargetsInitialized;
+    std::call_once(s_TargetsInitialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
+
+    std::string targetTriple = llvm::sys::getDefaultTargetTriple();
+
+    std::string error;
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+    if (!target)
+    {
+        JLANG_ERROR(STR("Cannot find native target: %s", error.c_str()));
+        return;
+    }
+
+    // Tune for the CPU we run on, so f32x8 and friends get AVX registers and the cost models of the
+    // vectorizer and unroller match the hardware, like clang's -march=native
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> hostFeatures;
+    if (llvm::sys::getHostCPUFeatures(hostFeatures))
+    {
+        for (const llvm::StringMapEntry<bool> &feature : hostFeatures)
+        {
+            features.AddFeature(feature.getKey(), feature.getValue());
+        }
+    }
+
+    llvm::TargetOptions targetOptions;
+    std::string cpu = llvm::sys::getHostCPUName().str();
+    m_TargetMachine.reset(target->createTargetMachine(targetTriple, cpu, features.getString(), targetOptions,
+                                                      llvm::Reloc::PIC_));
+
+    // Sizes computed from the DataLayout (e.g. alloc<T>()) must match what the backend will emit
+    m_Module->setTargetTriple(targetTriple);
+    m_Module->setDataLayout(m_TargetMachine->createDataLayout());
 }
 
-void CodeGenerator::Generate(const std::vector<std::shared_ptr<AstNode>> &program)
+void CodeGenerator::Generate(const std::vector<AstNode *> &program)
 {
     DeclareExternalFunctions();
 
@@ -55,732 +133,2116 @@ void CodeGenerator::DeclareExternalFunctions()
     llvm::Function::Create(freeType, llvm::Function::ExternalLinkage, "free", m_Module.get());
 }
 
-void CodeGenerator::DumpIR()
-{
-    m_Module->print(llvm::outs(), nullptr);
-}
-
-void CodeGenerator::VisitFunctionDecl(FunctionDecl &node)
+bool CodeGenerator::Optimize(OptimizationLevel level, bool timePasses)
 {
-    // Clear tracking for new function scope
-    m_currentFunctionVariables.clear();
-
-    std::vector<llvm::Type *> paramTypes;
-    paramTypes.reserve(node.params.size());
-    std::transform(node.params.begin(), node.params.end(), std::back_inserter(paramTypes),
-                   [this](const Parameter &param) { return MapType(param.type); });
-
-    llvm::FunctionType *funcType = llvm::FunctionType::get(MapType(node.returnType), paramTypes, false);
-
-    llvm::Function *function =
-        llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, node.name, m_Module.get());
-
-    llvm::BasicBlock *entry = llvm::BasicBlock::Create(m_Context, "entry", function);
-    m_IRBuilder.SetInsertPoint(entry);
-
-    unsigned paramIndex = 0;
-    for (auto &arg : function->args())
+    // Never hand a broken module to the pass pipeline, the passes assume valid IR
+    if (llvm::verifyModule(*m_Module, &llvm::errs()))
     {
-        const std::string &paramName = node.params[paramIndex].name;
-        arg.setName(paramName);
-        m_variables[paramName] = VariableInfo{&arg, node.params[paramIndex].type, false};
-        m_currentFunctionVariables.insert(paramName);
-        ++paramIndex;
+        JLANG_ERROR("Module verification failed");
+        return false;
     }
 
-    if (node.body)
-    {
-        node.body->Accept(*this);
+    // Analysis managers must be declared in this order so they are destroyed in reverse
+    llvm::LoopAnalysisManager loopAnalysisManager;
+    llvm::FunctionAnalysisManager functionAnalysisManager;
+    llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+    llvm::ModuleAnalysisManager moduleAnalysisManager;
+
+    llvm::PassInstrumentationCallbacks instrumentation;
+    llvm::TimePassesHandler passTimer(timePasses);
+    passTimer.registerCallbacks(instrumentation);
+
+    llvm::PassBuilder passBuilder(m_TargetMachine.get(), llvm::PipelineTuningOptions(), llvm::None,
+                                  &instrumentation);
+
+    passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+    passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+    passBuilder.registerLoopAnalyses(loopAnalysisManager);
+    passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager,
+                                     moduleAnalysisManager);
+
+    // Late in the function simplification pipeline the callees have been inlined, so fewer allocations
+    // escape through calls. The new slots are byte arrays behind a cast, SROA splits them into registers.
+    // The O0 pipeline runs extension point callbacks too, it gets the pass after promotion instead.
+    if (level != OptimizationLevel::O0)
+    {
+        passBuilder.registerScalarOptimizerLateEPCallback(
+            [this](llvm::FunctionPassManager &functionPassManager, llvm::OptimizationLevel) {
+                functionPassManager.addPass(HeapToStackPass(&m_StackAllocations));
+                functionPassManager.addPass(llvm::SROAPass());
+            });
+    }
+
+    llvm::ModulePassManager modulePassManager;
+    llvm::CodeGenOpt::Level codeGenLevel = llvm::CodeGenOpt::Default;
+
+    switch (level)
+    {
+    case OptimizationLevel::O0:
+        modulePassManager = passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+        // Locals are always promoted to SSA registers, even unoptimized code should not spill
+        // every variable to the stack. The other levels already run SROA early on.
+        modulePassManager.addPass(llvm::createModuleToFunctionPassAdaptor(llvm::PromotePass()));
+        // The escape analysis follows SSA values, so it runs once the locals are promoted
+        modulePassManager.addPass(
+            llvm::createModuleToFunctionPassAdaptor(HeapToStackPass(&m_StackAllocations)));
+        codeGenLevel = llvm::CodeGenOpt::None;
+        break;
+    case OptimizationLevel::O1:
+        modulePassManager = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1);
+        codeGenLevel = llvm::CodeGenOpt::Less;
+        break;
+    case OptimizationLevel::O2:
+        modulePassManager = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+        break;
+    case OptimizationLevel::O3:
+        modulePassManager = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+        codeGenLevel = llvm::CodeGenOpt::Aggressive;
+        break;
+    case OptimizationLevel::Os:
+        modulePassManager = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::Os);
+        break;
+    }
+
+    if (m_TargetMachine)
+    {
+        m_TargetMachine->setOptLevel(codeGenLevel);
+    }
+
+    modulePassManager.run(*m_Module, moduleAnalysisManager);
+
+    // Promotion deletes the lifetime markers of every promoted local, don't leave their declarations
+    // behind in unoptimized output
+    for (llvm::Function &function : llvm::make_early_inc_range(*m_Module))
+    {
+        if (function.isIntrinsic() && function.use_empty())
+        {
+            function.eraseFromParent();
+        }
     }
 
-    // Check for unused variables before finalizing the function
-    CheckUnusedVariables();
-
-    if (node.returnType.name == "void")
-    {
-        m_IRBuilder.CreateRetVoid();
-    }
+    // Report now rather than from the handler's destructor so the summary precedes any output
+    passTimer.print();
+    return true;
+}
 
-    llvm::verifyFunction(*function);
+void CodeGenerator::DumpIR()
+{
+    m_Module->print(llvm::outs(), nullptr);
+}
 
-    // Clean up function-local variables
-    for (const auto &varName : m_currentFunctionVariables)
+void CodeGenerator::PrintEscapeReport(llvm::raw_ostream &out) const
+{
+    for (const std::string &remark : m_StackAllocations)
     {
-        m_variables.erase(varName);
+        out << remark << "\n";
     }
-    m_currentFunctionVariables.clear();
 }
 
-void CodeGenerator::VisitInterfaceDecl(InterfaceDecl &) {}
-
-void CodeGenerator::VisitStructDecl(StructDecl &node)
+void CodeGenerator::PrintLayoutReport(llvm::raw_ostream &out) const
 {
-    // Create LLVM struct type
-    std::vector<llvm::Type *> fieldTypes;
-    fieldTypes.reserve(node.fields.size());
+    static constexpr uint64_t kCacheLineSize = 64;
 
-    StructInfo structInfo;
+    const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
 
-    for (unsigned i = 0; i < node.fields.size(); ++i)
+    for (const std::string &name : m_StructOrder)
     {
-        const auto &field = node.fields[i];
-        llvm::Type *fieldType = MapType(field.type);
-        fieldTypes.push_back(fieldType);
+        const StructInfo &structInfo = m_structTypes.at(name);
+        const llvm::StructLayout *layout = dataLayout.getStructLayout(structInfo.llvmType);
+        uint64_t size = layout->getSizeInBytes();
 
-        structInfo.fields[field.name] = FieldInfo{i, field.type, field.isPublic};
-    }
-
-    llvm::StructType *structType = llvm::StructType::create(m_Context, fieldTypes, node.name);
-    structInfo.llvmType = structType;
-
-    m_structTypes[node.name] = structInfo;
-}
-
-void CodeGenerator::VisitVariableDecl(VariableDecl &node)
-{
-    llvm::Type *varType = nullptr;
-    TypeRef inferredType = node.varType;
+        // Field names in memory order
+        std::vector<std::string> memoryOrder = structInfo.declarationOrder;
+        std::sort(memoryOrder.begin(), memoryOrder.end(), [&](const std::string &a, const std::string &b) {
+            return structInfo.fields.at(a).index < structInfo.fields.at(b).index;
+        });
 
-    // Check if type inference is needed (empty type name)
-    if (node.varType.name.empty())
-    {
-        if (!node.initializer)
+        out << "struct " << name << ": " << size << " bytes, align " << structInfo.alignment.value();
+        if (structInfo.isReprC)
         {
-            JLANG_ERROR(STR("Type inference requires an initializer for variable: %s", node.name.c_str()));
-            return;
+            out << ", #[repr(C)]";
         }
-
-        // Evaluate initializer first to get its type
-        node.initializer->Accept(*this);
-        if (!m_LastValue)
+        if (structInfo.isPacked)
         {
-            JLANG_ERROR(STR("Invalid initializer for variable: %s", node.name.c_str()));
-            return;
+            out << ", #[packed]";
         }
+        if (structInfo.isSoa)
+        {
+            out << ", #[soa] (arrays of it are stored one column per field)";
+        }
+        if (memoryOrder != structInfo.declarationOrder)
+        {
+            out << ", reordered (" << structInfo.declaredSize << " bytes as declared)";
+        }
+        out << "\n  offset   size  field\n";
 
-        varType = m_LastValue->getType();
-        inferredType = InferTypeRef(varType);
-
-        // Create alloca and store the already-computed value
-        llvm::AllocaInst *alloca = m_IRBuilder.CreateAlloca(varType, nullptr, node.name);
-        m_IRBuilder.CreateStore(m_LastValue, alloca);
-
-        // Track variable with inferred type
-        m_variables[node.name] = VariableInfo{alloca, inferredType, false, node.isMutable};
-        m_currentFunctionVariables.insert(node.name);
-        return;
-    }
-
-    // Explicit type - use existing logic
-    varType = MapType(node.varType);
-
-    // Null safety: non-nullable pointers must be initialized
-    if (node.varType.isPointer && !node.varType.isNullable && !node.initializer)
-    {
-        JLANG_ERROR(STR("Non-nullable pointer '%s' must be initialized.", node.name.c_str()));
-        return;
-    }
-
-    llvm::AllocaInst *alloca = m_IRBuilder.CreateAlloca(varType, nullptr, node.name);
+        uint64_t end = 0;
+        uint64_t padding = 0;
+        uint64_t cacheLine = 0;
 
-    if (node.initializer)
-    {
-        node.initializer->Accept(*this);
-        if (m_LastValue)
-        {
-            // Null safety: cannot assign null to non-nullable pointer
-            if (node.varType.isPointer && !node.varType.isNullable &&
-                llvm::isa<llvm::ConstantPointerNull>(m_LastValue))
+        // One row per field or padding hole, with a marker wherever a row starts on a new cache line
+        auto printRow = [&](uint64_t offset, uint64_t rowSize) {
+            if (offset / kCacheLineSize > cacheLine)
             {
-                JLANG_ERROR(
-                    STR("Cannot assign null to non-nullable pointer type '%s*'. Use '%s*?' to allow null.",
-                        node.varType.name.c_str(), node.varType.name.c_str()));
-                return;
+                cacheLine = offset / kCacheLineSize;
+                out << "  ---- cache line " << cacheLine << " ----\n";
             }
+            out << llvm::format("  %6llu %6llu  ", static_cast<unsigned long long>(offset),
+                                static_cast<unsigned long long>(rowSize));
+        };
+        auto printHole = [&](uint64_t from, uint64_t to) {
+            if (to > from)
+            {
+                printRow(from, to - from);
+                out << "(padding)\n";
+                padding += to - from;
+            }
+        };
 
-            if (m_LastValue->getType() != varType && varType->isPointerTy() &&
-                m_LastValue->getType()->isPointerTy())
+        for (const std::string &fieldName : memoryOrder)
+        {
+            const FieldInfo &field = structInfo.fields.at(fieldName);
+            uint64_t offset = layout->getElementOffset(field.index);
+            llvm::Type *fieldType = structInfo.llvmType->getElementType(field.index);
+            uint64_t fieldSize = dataLayout.getTypeAllocSize(fieldType).getFixedSize();
+
+            printHole(end, offset);
+            printRow(offset, fieldSize);
+            out << fieldName << ": " << field.type.Spelling();
+            if (fieldSize > 0 && offset / kCacheLineSize != (offset + fieldSize - 1) / kCacheLineSize)
             {
-                m_LastValue = m_IRBuilder.CreateBitCast(m_LastValue, varType, "cast");
+                out << "  (straddles a cache line)";
             }
-            m_IRBuilder.CreateStore(m_LastValue, alloca);
+            out << "\n";
+
+            end = offset + fieldSize;
         }
-    }
+        printHole(end, size);
 
-    // Track variable with usage info (initially unused)
-    m_variables[node.name] = VariableInfo{alloca, node.varType, false, node.isMutable};
-    m_currentFunctionVariables.insert(node.name);
+        out << "  " << padding << " bytes of padding\n";
+    }
 }
 
-void CodeGenerator::VisitIfStatement(IfStatement &node)
+std::unique_ptr<llvm::Module> CodeGenerator::TakeModule()
 {
-    node.condition->Accept(*this);
-    llvm::Value *conditionValue = m_LastValue;
+    return std::move(m_Module);
+}
 
-    if (!conditionValue)
+bool CodeGenerator::Emit(EmitKind kind, const std::string &outputPath)
+{
+    if (kind == EmitKind::Executable)
     {
-        JLANG_ERROR("Invalid condition in if statement");
-        return;
+        JLANG_ERROR("Executables are produced by linking an emitted object file");
+        return false;
     }
 
-    if (conditionValue->getType()->isIntegerTy(32))
+    std::error_code errorCode;
+    bool isTextual = kind == EmitKind::LLVM || kind == EmitKind::Assembly;
+    llvm::sys::fs::OpenFlags flags = isTextual ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None;
+    llvm::raw_fd_ostream out(outputPath, errorCode, flags);
+
+    if (errorCode)
     {
-        conditionValue = m_IRBuilder.CreateICmpNE(
-            conditionValue, llvm::ConstantInt::get(conditionValue->getType(), 0), "ifcond");
+        JLANG_ERROR(
+            STR("Cannot open output file '%s': %s", outputPath.c_str(), errorCode.message().c_str()));
+        return false;
     }
 
-    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
-
-    llvm::BasicBlock *thenBlock = llvm::BasicBlock::Create(m_Context, "then", parentFunction);
-    llvm::BasicBlock *elseBlock = llvm::BasicBlock::Create(m_Context, "else");
-    llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "ifcont");
-
-    m_IRBuilder.CreateCondBr(conditionValue, thenBlock, elseBlock);
-
-    m_IRBuilder.SetInsertPoint(thenBlock);
-    node.thenBranch->Accept(*this);
-    m_IRBuilder.CreateBr(mergeBlock);
-
-    elseBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(elseBlock);
-    if (node.elseBranch)
+    if (kind == EmitKind::LLVM)
     {
-        node.elseBranch->Accept(*this);
+        m_Module->print(out, nullptr);
+        return true;
     }
-    m_IRBuilder.CreateBr(mergeBlock);
-
-    mergeBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(mergeBlock);
-}
-
-void CodeGenerator::VisitWhileStatement(WhileStatement &node)
-{
-    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
-
-    llvm::BasicBlock *condBlock = llvm::BasicBlock::Create(m_Context, "while.cond", parentFunction);
-    llvm::BasicBlock *bodyBlock = llvm::BasicBlock::Create(m_Context, "while.body");
-    llvm::BasicBlock *exitBlock = llvm::BasicBlock::Create(m_Context, "while.exit");
-
-    // Branch to condition block
-    m_IRBuilder.CreateBr(condBlock);
 
-    // Condition block
-    m_IRBuilder.SetInsertPoint(condBlock);
-    node.condition->Accept(*this);
-    llvm::Value *condValue = m_LastValue;
-
-    if (!condValue)
+    if (kind == EmitKind::Bitcode)
     {
-        JLANG_ERROR("Invalid condition in while statement");
-        return;
+        llvm::WriteBitcodeToFile(*m_Module, out);
+        return true;
     }
 
-    // Convert i32 to i1 if necessary
-    if (condValue->getType()->isIntegerTy(32))
+    if (!m_TargetMachine)
     {
-        condValue =
-            m_IRBuilder.CreateICmpNE(condValue, llvm::ConstantInt::get(condValue->getType(), 0), "whilecond");
+        JLANG_ERROR("No target machine available for native code emission");
+        return false;
     }
 
-    m_IRBuilder.CreateCondBr(condValue, bodyBlock, exitBlock);
+    llvm::CodeGenFileType fileType =
+        kind == EmitKind::Assembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
 
-    // Body block
-    bodyBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(bodyBlock);
-    node.body->Accept(*this);
-    m_IRBuilder.CreateBr(condBlock);
+    llvm::legacy::PassManager codeGenPasses;
+    if (m_TargetMachine->addPassesToEmitFile(codeGenPasses, out, nullptr, fileType))
+    {
+        JLANG_ERROR("Target machine cannot emit a file of this type");
+        return false;
+    }
 
-    // Exit block
-    exitBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(exitBlock);
+    codeGenPasses.run(*m_Module);
+    out.flush();
+
+    return true;
 }
 
-std::optional<CodeGenerator::LoopUnrollInfo> CodeGenerator::AnalyzeForUnroll(ForStatement &node)
+void CodeGenerator::VisitFunctionDecl(FunctionDecl &node)
 {
-    // 1. Init must be a VariableDecl with a LiteralExpr integer initializer
-    if (!node.init || !node.condition || !node.update || !node.body)
-        return std::nullopt;
+    if (IsVectorBuiltin(node.name))
+    {
+        JLANG_ERROR(STR("'%s' is a builtin and cannot be declared as a function", node.name.c_str()));
+        return;
+    }
 
-    auto *varDecl = dynamic_cast<VariableDecl *>(node.init.get());
-    if (!varDecl || !varDecl->initializer)
-        return std::nullopt;
+    m_LastEntryAlloca = nullptr;
 
-    auto *initLiteral = dynamic_cast<LiteralExpr *>(varDecl->initializer.get());
-    if (!initLiteral)
-        return std::nullopt;
+    // Registered before the body, so that the function can call itself
+    const FunctionAbi &abi = m_Functions[node.name] = LowerSignature(node);
+    llvm::FunctionType *funcType = abi.type;
 
-    int64_t startVal;
-    try
+    // Same rule as struct fields: only Uppercase functions are visible outside the file, main being the
+    // exception as the entry point. Internal functions use fastcc, and since LLVM sees every caller it
+    // is free to inline, specialize, rewrite their signature or drop them once unused.
+    bool isExported = node.isPublic || node.name == "main";
+    llvm::Function::LinkageTypes linkage =
+        isExported ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+    llvm::Function *function = llvm::Function::Create(funcType, linkage, node.name, m_Module.get());
+    function->setAttributes(abi.attributes);
+    if (!isExported)
     {
-        startVal = std::stoll(initLiteral->value);
+        function->setCallingConv(llvm::CallingConv::Fast);
     }
-    catch (...)
+    else
     {
-        return std::nullopt;
+        WarnAboutReorderedStructs(node);
     }
 
-    std::string varName = varDecl->name;
-
-    // 2. Condition must be BinaryExpr comparing the loop variable to a literal
-    auto *condExpr = dynamic_cast<BinaryExpr *>(node.condition.get());
-    if (!condExpr)
-        return std::nullopt;
-
-    std::string compareOp = condExpr->op;
-    if (compareOp != "<" && compareOp != "<=" && compareOp != ">" && compareOp != ">=")
-        return std::nullopt;
-
-    // Check that one side is the loop variable and the other is a literal
-    auto *leftVar = dynamic_cast<VarExpr *>(condExpr->left.get());
-    auto *rightLit = dynamic_cast<LiteralExpr *>(condExpr->right.get());
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(m_Context, "entry", function);
+    m_IRBuilder.SetInsertPoint(entry);
+    m_CurrentFunction = &abi;
 
-    if (!leftVar || leftVar->name != varName || !rightLit)
-        return std::nullopt;
+    // Parameters live in their own scope around the body
+    PushScope();
 
-    int64_t endVal;
-    try
+    auto arg = function->arg_begin();
+    if (abi.result.isIndirect)
     {
-        endVal = std::stoll(rightLit->value);
-    }
-    catch (...)
-    {
-        return std::nullopt;
+        (arg++)->setName("result");
     }
 
-    // 3. Update must be PostfixExpr or PrefixExpr with ++ or -- on the loop variable
-    int64_t step = 0;
-    if (auto *postfix = dynamic_cast<PostfixExpr *>(node.update.get()))
-    {
-        auto *operandVar = dynamic_cast<VarExpr *>(postfix->operand.get());
-        if (!operandVar || operandVar->name != varName)
-            return std::nullopt;
-        if (postfix->op == "++")
-            step = 1;
-        else if (postfix->op == "--")
-            step = -1;
-        else
-            return std::nullopt;
-    }
-    else if (auto *prefix = dynamic_cast<PrefixExpr *>(node.update.get()))
+    for (size_t i = 0; i < node.params.size(); ++i)
     {
-        auto *operandVar = dynamic_cast<VarExpr *>(prefix->operand.get());
-        if (!operandVar || operandVar->name != varName)
-            return std::nullopt;
-        if (prefix->op == "++")
-            step = 1;
-        else if (prefix->op == "--")
-            step = -1;
+        const Parameter &param = node.params[i];
+        if (!IsStructValue(param.type))
+        {
+            arg->setName(param.name);
+            DeclareVariable(param.name, VariableInfo{&*arg++, param.type, false});
+            continue;
+        }
+
+        // A struct parameter is the callee's own copy, kept in a local so its fields can be addressed
+        llvm::Type *structType = MapType(param.type);
+        llvm::Value *value = nullptr;
+        if (abi.params[i].isIndirect)
+        {
+            arg->setName(param.name + ".byval");
+            value = m_IRBuilder.CreateAlignedLoad(structType, &*arg++, ByValAlignment(param.type, structType),
+                                                  param.name);
+        }
         else
-            return std::nullopt;
-    }
-    else
-    {
-        return std::nullopt;
+        {
+            std::vector<llvm::Value *> parts;
+            for (size_t part = 0; part < abi.params[i].registerTypes.size(); ++part)
+            {
+                arg->setName(param.name + ".part" + std::to_string(part));
+                parts.push_back(&*arg++);
+            }
+            value = EmitFromRegisterParts(parts, structType, abi.params[i]);
+        }
+
+        llvm::AllocaInst *alloca =
+            CreateEntryBlockAlloca(structType, param.name, TypeAlignment(param.type, structType));
+        m_IRBuilder.CreateStore(value, alloca);
+        DeclareVariable(param.name, VariableInfo{alloca, param.type, false});
     }
 
-    // 4. Compute trip count
-    int64_t tripCount = 0;
-    if (step == 1)
+    if (node.body)
     {
-        if (compareOp == "<")
-            tripCount = endVal - startVal;
-        else if (compareOp == "<=")
-            tripCount = endVal - startVal + 1;
-        else
-            return std::nullopt; // step=+1 with > or >= makes no sense
+        node.body->Accept(*this);
     }
-    else // step == -1
+
+    PopScope();
+    m_CurrentFunction = nullptr;
+
+    // A body that ends in a return leaves nothing to terminate. After a match whose arms all return, the
+    // insert block is the match.end block nothing branches to.
+    llvm::BasicBlock *lastBlock = m_IRBuilder.GetInsertBlock();
+    if (!lastBlock->getTerminator())
     {
-        if (compareOp == ">")
-            tripCount = startVal - endVal;
-        else if (compareOp == ">=")
-            tripCount = startVal - endVal + 1;
+        bool isDead = lastBlock != &function->getEntryBlock() && llvm::pred_empty(lastBlock);
+        if (node.returnType.name == "void")
+        {
+            m_IRBuilder.CreateRetVoid();
+        }
+        else if (isDead)
+        {
+            m_IRBuilder.CreateUnreachable();
+        }
         else
-            return std::nullopt; // step=-1 with < or <= makes no sense
+        {
+            // Left without a terminator, the verifier then rejects the module and nothing is emitted
+            JLANG_ERROR(STR("Function '%s' must return a value", node.name.c_str()));
+        }
     }
 
-    if (tripCount < 1 || tripCount > MAX_UNROLL_COUNT)
-        return std::nullopt;
+    ApplyInliningAttributes(*function, node);
 
-    return LoopUnrollInfo{varName, startVal, endVal, step, compareOp};
+    llvm::verifyFunction(*function);
 }
 
-bool CodeGenerator::BodyModifiesVar(const std::shared_ptr<AstNode> &node, const std::string &varName)
+void CodeGenerator::ApplyInliningAttributes(llvm::Function &function, const FunctionDecl &node)
 {
-    if (!node)
-        return false;
-
-    // Check AssignExpr
-    if (auto *assign = dynamic_cast<AssignExpr *>(node.get()))
-    {
-        if (assign->name == varName)
-            return true;
-        return BodyModifiesVar(assign->value, varName);
-    }
+    bool isAlwaysInline = false;
+    bool isNoInline = false;
+    bool isFlatten = false;
 
-    // Check PrefixExpr (++/-- on the variable)
-    if (auto *prefix = dynamic_cast<PrefixExpr *>(node.get()))
+    for (const Attribute &attribute : node.attributes)
     {
-        if (auto *varExpr = dynamic_cast<VarExpr *>(prefix->operand.get()))
+        if (!attribute.args.empty())
         {
-            if (varExpr->name == varName)
-                return true;
+            JLANG_ERROR(STR("Function attribute '%s' takes no arguments", attribute.name.c_str()));
+            continue;
         }
-        return BodyModifiesVar(prefix->operand, varName);
-    }
 
-    // Check PostfixExpr (++/-- on the variable)
-    if (auto *postfix = dynamic_cast<PostfixExpr *>(node.get()))
-    {
-        if (auto *varExpr = dynamic_cast<VarExpr *>(postfix->operand.get()))
+        if (attribute.name == "always_inline")
         {
-            if (varExpr->name == varName)
-                return true;
+            isAlwaysInline = true;
         }
-        return BodyModifiesVar(postfix->operand, varName);
-    }
-
-    // Recurse into compound statements
-    if (auto *block = dynamic_cast<BlockStatement *>(node.get()))
-    {
-        for (auto &stmt : block->statements)
+        else if (attribute.name == "noinline")
         {
-            if (BodyModifiesVar(stmt, varName))
-                return true;
+            isNoInline = true;
+        }
+        else if (attribute.name == "flatten")
+        {
+            isFlatten = true;
+        }
+        else
+        {
+            JLANG_ERROR(STR("Unknown function attribute: %s", attribute.name.c_str()));
         }
-        return false;
     }
 
-    if (auto *exprStmt = dynamic_cast<ExprStatement *>(node.get()))
+    if (isAlwaysInline && isNoInline)
     {
-        return BodyModifiesVar(exprStmt->expression, varName);
+        JLANG_ERROR(STR("Function '%s' cannot be both #[always_inline] and #[noinline]", node.name.c_str()));
+        return;
     }
 
-    if (auto *ifStmt = dynamic_cast<IfStatement *>(node.get()))
+    // always_inline is honored at every level, -O0 included, since even the O0 pipeline runs the
+    // AlwaysInliner. 'inline' only makes the cost model more generous, noinline overrides it.
+    if (isAlwaysInline)
     {
-        return BodyModifiesVar(ifStmt->condition, varName) || BodyModifiesVar(ifStmt->thenBranch, varName) ||
-               BodyModifiesVar(ifStmt->elseBranch, varName);
+        function.addFnAttr(llvm::Attribute::AlwaysInline);
     }
-
-    if (auto *whileStmt = dynamic_cast<WhileStatement *>(node.get()))
+    else if (isNoInline)
     {
-        return BodyModifiesVar(whileStmt->condition, varName) || BodyModifiesVar(whileStmt->body, varName);
+        function.addFnAttr(llvm::Attribute::NoInline);
     }
-
-    if (auto *forStmt = dynamic_cast<ForStatement *>(node.get()))
+    else if (node.isInline)
     {
-        return BodyModifiesVar(forStmt->init, varName) || BodyModifiesVar(forStmt->condition, varName) ||
-               BodyModifiesVar(forStmt->update, varName) || BodyModifiesVar(forStmt->body, varName);
+        function.addFnAttr(llvm::Attribute::InlineHint);
     }
 
-    if (auto *callExpr = dynamic_cast<CallExpr *>(node.get()))
+    if (!isFlatten)
     {
-        for (auto &arg : callExpr->arguments)
-        {
-            if (BodyModifiesVar(arg, varName))
-                return true;
-        }
-        return false;
+        return;
     }
 
-    if (auto *binExpr = dynamic_cast<BinaryExpr *>(node.get()))
+    // #[flatten] inlines the calls made directly in the body, the way clang does it: every call site
+    // gets alwaysinline, the callees themselves are left alone for their other callers
+    for (llvm::BasicBlock &block : function)
     {
-        return BodyModifiesVar(binExpr->left, varName) || BodyModifiesVar(binExpr->right, varName);
-    }
-
-    if (auto *unaryExpr = dynamic_cast<UnaryExpr *>(node.get()))
-    {
-        return BodyModifiesVar(unaryExpr->operand, varName);
+        for (llvm::Instruction &instruction : block)
+        {
+            auto *call = llvm::dyn_cast<llvm::CallInst>(&instruction);
+            llvm::Function *callee = call ? call->getCalledFunction() : nullptr;
+            if (callee && !callee->isDeclaration() && callee != &function &&
+                !callee->hasFnAttribute(llvm::Attribute::NoInline))
+            {
+                call->addFnAttr(llvm::Attribute::AlwaysInline);
+            }
+        }
     }
+}
 
-    if (auto *castExpr = dynamic_cast<CastExpr *>(node.get()))
+void CodeGenerator::WarnAboutReorderedStructs(const FunctionDecl &node)
+{
+    std::vector<TypeRef> types = {node.returnType};
+    for (const Parameter &param : node.params)
     {
-        return BodyModifiesVar(castExpr->expr, varName);
+        types.push_back(param.type);
     }
 
-    if (auto *retStmt = dynamic_cast<ReturnStatement *>(node.get()))
+    // C code calling an exported function lays the struct out in declaration order
+    std::unordered_set<std::string> reported;
+    for (const TypeRef &type : types)
     {
-        return BodyModifiesVar(retStmt->value, varName);
+        auto structIt = m_structTypes.find(type.name);
+        bool isReordered = structIt != m_structTypes.end() && structIt->second.isReordered;
+        if (isReordered && reported.insert(type.name).second)
+        {
+            JLANG_WARNING(STR("Exported function '%s' uses struct '%s', whose fields were reordered. Add "
+                              "#[repr(C)] to '%s' if C code calls it.",
+                              node.name.c_str(), type.name.c_str(), type.name.c_str()));
+        }
     }
-
-    // VarExpr, LiteralExpr, etc. don't modify anything
-    return false;
 }
 
-void CodeGenerator::VisitForStatement(ForStatement &node)
+CodeGenerator::FunctionAbi CodeGenerator::LowerSignature(const FunctionDecl &node)
 {
-    // Try loop unrolling optimization
-    auto unrollInfo = AnalyzeForUnroll(node);
-    if (unrollInfo && !BodyModifiesVar(node.body, unrollInfo->varName))
-    {
-        // Emit the init (creates the alloca and stores the start value)
-        node.init->Accept(*this);
+    FunctionAbi abi;
+    abi.returnType = node.returnType;
 
-        // Find the loop variable's alloca
-        auto it = m_variables.find(unrollInfo->varName);
-        if (it == m_variables.end())
-        {
-            JLANG_ERROR(STR("Loop unroll: variable '%s' not found after init", unrollInfo->varName.c_str()));
-            return;
-        }
+    // rdi, rsi, rdx, rcx, r8, r9 and xmm0-xmm7. A struct that no longer fits goes on the stack whole.
+    unsigned integerRegisters = 6;
+    unsigned sseRegisters = 8;
+
+    std::vector<llvm::Type *> paramTypes;
+    llvm::Type *returnType = MapType(node.returnType);
 
-        llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(it->second.value);
-        if (!alloca)
+    if (IsStructValue(node.returnType))
+    {
+        abi.result = ClassifyStruct(node.returnType);
+        if (abi.result.isIndirect)
         {
-            JLANG_ERROR("Loop unroll: variable is not an alloca");
-            return;
+            // The caller passes the memory for the result as a hidden first parameter
+            abi.attributes = abi.attributes.addParamAttribute(
+                m_Context, 0, llvm::Attribute::getWithStructRetType(m_Context, returnType));
+            abi.attributes = abi.attributes.addParamAttribute(m_Context, 0, llvm::Attribute::NoAlias);
+            abi.attributes = abi.attributes.addParamAttribute(
+                m_Context, 0,
+                llvm::Attribute::getWithAlignment(m_Context, TypeAlignment(node.returnType, returnType)));
+            paramTypes.push_back(returnType->getPointerTo());
+            returnType = m_IRBuilder.getVoidTy();
+            --integerRegisters;
         }
-
-        // Compute trip count
-        int64_t tripCount = 0;
-        if (unrollInfo->step == 1)
+        else if (abi.result.registerTypes.size() == 2)
         {
-            if (unrollInfo->compareOp == "<")
-                tripCount = unrollInfo->end - unrollInfo->start;
-            else
-                tripCount = unrollInfo->end - unrollInfo->start + 1;
+            returnType = llvm::StructType::get(m_Context, abi.result.registerTypes);
         }
         else
         {
-            if (unrollInfo->compareOp == ">")
-                tripCount = unrollInfo->start - unrollInfo->end;
-            else
-                tripCount = unrollInfo->start - unrollInfo->end + 1;
+            bool isEmpty = abi.result.registerTypes.empty();
+            returnType = isEmpty ? m_IRBuilder.getVoidTy() : abi.result.registerTypes[0];
         }
+    }
+
+    for (const Parameter &param : node.params)
+    {
+        abi.paramTypes.push_back(param.type);
+        llvm::Type *type = MapType(param.type);
 
-        // Emit the body N times, storing each iteration value
-        for (int64_t i = 0; i < tripCount; ++i)
+        if (!IsStructValue(param.type))
         {
-            int64_t iterVal = unrollInfo->start + i * unrollInfo->step;
-            llvm::Value *val = llvm::ConstantInt::get(alloca->getAllocatedType(), iterVal);
-            m_IRBuilder.CreateStore(val, alloca);
-            node.body->Accept(*this);
+            // Slices are a pointer and a length, two integer registers
+            unsigned &registers = type->isFPOrFPVectorTy() ? sseRegisters : integerRegisters;
+            registers -= std::min(registers, type->isStructTy() ? 2u : 1u);
+            paramTypes.push_back(type);
+            abi.params.emplace_back();
+            continue;
         }
 
-        return;
-    }
+        AbiLowering lowering = ClassifyStruct(param.type);
+        const std::vector<llvm::Type *> &parts = lowering.registerTypes;
+        unsigned integerParts =
+            std::count_if(parts.begin(), parts.end(), [](llvm::Type *part) { return part->isIntegerTy(); });
+        unsigned sseParts = parts.size() - integerParts;
 
-    // Fall through to normal loop codegen
-    // Execute initializer (if present)
-    if (node.init)
-    {
-        node.init->Accept(*this);
+        if (!lowering.isIndirect && integerParts <= integerRegisters && sseParts <= sseRegisters)
+        {
+            integerRegisters -= integerParts;
+            sseRegisters -= sseParts;
+            paramTypes.insert(paramTypes.end(), parts.begin(), parts.end());
+        }
+        else
+        {
+            lowering = AbiLowering::Indirect();
+            unsigned index = paramTypes.size();
+            llvm::Align alignment = ByValAlignment(param.type, type);
+            abi.attributes = abi.attributes.addParamAttribute(
+                m_Context, index, llvm::Attribute::getWithByValType(m_Context, type));
+            abi.attributes = abi.attributes.addParamAttribute(
+                m_Context, index, llvm::Attribute::getWithAlignment(m_Context, alignment));
+            paramTypes.push_back(type->getPointerTo());
+        }
+        abi.params.push_back(lowering);
     }
 
-    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+    abi.type = llvm::FunctionType::get(returnType, paramTypes, false);
+    return abi;
+}
 
-    llvm::BasicBlock *condBlock = llvm::BasicBlock::Create(m_Context, "for.cond", parentFunction);
-    llvm::BasicBlock *bodyBlock = llvm::BasicBlock::Create(m_Context, "for.body");
-    llvm::BasicBlock *updateBlock = llvm::BasicBlock::Create(m_Context, "for.update");
-    llvm::BasicBlock *exitBlock = llvm::BasicBlock::Create(m_Context, "for.exit");
+CodeGenerator::AbiLowering CodeGenerator::ClassifyStruct(const TypeRef &structType)
+{
+    AbiLowering lowering = AbiLowering::Indirect();
 
-    // Branch to condition block
-    m_IRBuilder.CreateBr(condBlock);
+    llvm::Triple triple(m_Module->getTargetTriple());
+    llvm::Type *type = MapType(structType);
+    if (triple.getArch() != llvm::Triple::x86_64 || triple.isOSWindows() ||
+        m_Module->getDataLayout().getTypeAllocSize(type) > 16)
+    {
+        return lowering;
+    }
 
-    // Condition block
-    m_IRBuilder.SetInsertPoint(condBlock);
-    if (node.condition)
+    std::vector<Eightbyte> eightbytes(2);
+    if (!ClassifyEightbytes(structType, 0, eightbytes))
     {
-        node.condition->Accept(*this);
-        llvm::Value *condValue = m_LastValue;
+        return lowering;
+    }
 
-        if (!condValue)
+    lowering.isIndirect = false;
+    for (unsigned i = 0; i < eightbytes.size(); ++i)
+    {
+        // An eightbyte of nothing but padding is not passed at all
+        const Eightbyte &eightbyte = eightbytes[i];
+        if (eightbyte.kind == EightbyteClass::None)
         {
-            JLANG_ERROR("Invalid condition in for statement");
-            return;
+            continue;
         }
 
-        // Convert i32 to i1 if necessary
-        if (condValue->getType()->isIntegerTy(32))
+        llvm::Type *registerType = nullptr;
+        if (eightbyte.kind == EightbyteClass::Integer)
         {
-            condValue = m_IRBuilder.CreateICmpNE(condValue, llvm::ConstantInt::get(condValue->getType(), 0),
-                                                 "forcond");
+            registerType = m_IRBuilder.getIntNTy(8 * llvm::PowerOf2Ceil(eightbyte.dataEnd));
+        }
+        else if (eightbyte.hasDouble)
+        {
+            registerType = m_IRBuilder.getDoubleTy();
+        }
+        else
+        {
+            registerType = eightbyte.dataEnd <= 4 ? m_IRBuilder.getFloatTy()
+                                                  : llvm::FixedVectorType::get(m_IRBuilder.getFloatTy(), 2);
         }
 
-        m_IRBuilder.CreateCondBr(condValue, bodyBlock, exitBlock);
+        lowering.registerTypes.push_back(registerType);
+        lowering.registerOffsets.push_back(8 * i);
     }
-    else
+
+    return lowering;
+}
+
+bool CodeGenerator::ClassifyEightbytes(const TypeRef &type, uint64_t offset,
+                                       std::vector<Eightbyte> &eightbytes)
+{
+    const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+
+    if (IsStructValue(type))
     {
-        // No condition = infinite loop
-        m_IRBuilder.CreateBr(bodyBlock);
+        const StructInfo &structInfo = m_structTypes.at(type.name);
+        const llvm::StructLayout *layout = dataLayout.getStructLayout(structInfo.llvmType);
+        for (const auto &[name, field] : structInfo.fields)
+        {
+            if (!ClassifyEightbytes(field.type, offset + layout->getElementOffset(field.index), eightbytes))
+            {
+                return false;
+            }
+        }
+        return true;
     }
 
-    // Body block
-    bodyBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(bodyBlock);
-    node.body->Accept(*this);
-    m_IRBuilder.CreateBr(updateBlock);
+    if (type.IsArray() && !IsSoaArray(type))
+    {
+        TypeRef elementType = type.ElementType();
+        uint64_t stride = dataLayout.getTypeAllocSize(MapType(elementType));
+        for (uint64_t i = 0; i < type.arraySize; ++i)
+        {
+            if (!ClassifyEightbytes(elementType, offset + i * stride, eightbytes))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
 
-    // Update block
-    updateBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(updateBlock);
-    if (node.update)
+    // Left to memory rather than given the SSEUP class of __m128 and friends
+    llvm::Type *llvmType = MapType(type);
+    if (llvmType->isVectorTy() || IsSoaArray(type))
     {
-        node.update->Accept(*this);
+        return false;
     }
-    m_IRBuilder.CreateBr(condBlock);
 
-    // Exit block
-    exitBlock->insertInto(parentFunction);
-    m_IRBuilder.SetInsertPoint(exitBlock);
-}
+    // Slices, like any field, are made of scalars of at most eight bytes
+    std::vector<llvm::Type *> scalars = {llvmType};
+    if (type.isSlice)
+    {
+        scalars = {llvmType->getStructElementType(0), llvmType->getStructElementType(1)};
+    }
 
-void CodeGenerator::VisitBlockStatement(BlockStatement &node)
-{
-    for (auto &statement : node.statements)
+    for (llvm::Type *scalar : scalars)
     {
-        if (statement)
+        // An unaligned field, found in #[packed] structs, sends the whole struct to memory
+        uint64_t size = dataLayout.getTypeStoreSize(scalar);
+        if (offset % dataLayout.getABITypeAlign(scalar).value() != 0)
         {
-            statement->Accept(*this);
+            return false;
         }
+
+        Eightbyte &eightbyte = eightbytes[offset / 8];
+        bool isInteger = !scalar->isFloatingPointTy();
+        eightbyte.kind = isInteger || eightbyte.kind == EightbyteClass::Integer ? EightbyteClass::Integer
+                                                                                 : EightbyteClass::Sse;
+        eightbyte.dataEnd = std::max(eightbyte.dataEnd, offset % 8 + size);
+        eightbyte.hasDouble |= scalar->isDoubleTy();
+        offset += size;
     }
+
+    return true;
 }
 
-void CodeGenerator::VisitExprStatement(ExprStatement &node)
+llvm::Align CodeGenerator::ByValAlignment(const TypeRef &typeRef, llvm::Type *type) const
 {
-    if (node.expression)
-    {
-        node.expression->Accept(*this);
-    }
+    return std::max(llvm::Align(8), TypeAlignment(typeRef, type));
 }
 
-void CodeGenerator::VisitReturnStatement(ReturnStatement &node)
+llvm::AllocaInst *CodeGenerator::CreateCoercionSlot(llvm::Type *structType, const AbiLowering &lowering)
 {
-    if (node.value)
+    // A register can be wider than the bytes it carries, a 3-byte struct travels as an i32
+    const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+    uint64_t size = dataLayout.getTypeAllocSize(structType);
+    for (size_t i = 0; i < lowering.registerTypes.size(); ++i)
     {
-        node.value->Accept(*this);
-        m_IRBuilder.CreateRet(m_LastValue);
+        uint64_t registerSize = dataLayout.getTypeAllocSize(lowering.registerTypes[i]);
+        size = std::max(size, lowering.registerOffsets[i] + registerSize);
     }
-    else
+
+    // Register structs are at most 16 bytes and 16-byte aligned
+    llvm::Type *bytesType = llvm::ArrayType::get(m_IRBuilder.getInt8Ty(), size);
+    return CreateEntryBlockAlloca(bytesType, "coerce", llvm::Align(16));
+}
+
+std::vector<llvm::Value *> CodeGenerator::EmitRegisterParts(llvm::Value *value, const AbiLowering &lowering)
+{
+    llvm::AllocaInst *slot = CreateCoercionSlot(value->getType(), lowering);
+    m_IRBuilder.CreateStore(value, m_IRBuilder.CreateBitCast(slot, value->getType()->getPointerTo()));
+
+    std::vector<llvm::Value *> parts;
+    for (size_t i = 0; i < lowering.registerTypes.size(); ++i)
     {
-        m_IRBuilder.CreateRetVoid();
+        llvm::Value *partPtr = m_IRBuilder.CreateConstInBoundsGEP2_64(slot->getAllocatedType(),
+                                                                      slot, 0, lowering.registerOffsets[i]);
+        partPtr = m_IRBuilder.CreateBitCast(partPtr, lowering.registerTypes[i]->getPointerTo());
+        parts.push_back(m_IRBuilder.CreateLoad(lowering.registerTypes[i], partPtr, "part"));
     }
+    return parts;
 }
 
-void CodeGenerator::VisitCallExpr(CallExpr &node)
+llvm::Value *CodeGenerator::EmitFromRegisterParts(const std::vector<llvm::Value *> &parts,
+                                                  llvm::Type *structType, const AbiLowering &lowering)
 {
-    llvm::Function *callee = m_Module->getFunction(node.callee);
-
-    if (!callee)
+    llvm::AllocaInst *slot = CreateCoercionSlot(structType, lowering);
+    for (size_t i = 0; i < parts.size(); ++i)
     {
-        JLANG_ERROR(STR("Unknown function: %s", node.callee.c_str()));
+        llvm::Value *partPtr = m_IRBuilder.CreateConstInBoundsGEP2_64(slot->getAllocatedType(),
+                                                                      slot, 0, lowering.registerOffsets[i]);
+        partPtr = m_IRBuilder.CreateBitCast(partPtr, parts[i]->getType()->getPointerTo());
+        m_IRBuilder.CreateStore(parts[i], partPtr);
     }
 
-    std::vector<llvm::Value *> args;
+    return m_IRBuilder.CreateLoad(structType, m_IRBuilder.CreateBitCast(slot, structType->getPointerTo()));
+}
 
-    for (auto &arg : node.arguments)
-    {
-        arg->Accept(*this);
+void CodeGenerator::VisitInterfaceDecl(InterfaceDecl &) {}
 
-        if (!m_LastValue)
-        {
-            JLANG_ERROR(STR("Invalid argument in call to %s", node.callee.c_str()));
-        }
-        args.push_back(m_LastValue);
+// #[align(N)] with N a power of two, 0 when the attribute is malformed
+static uint64_t ParseAlignAttribute(const Attribute &attribute)
+{
+    const std::string &value = attribute.args.size() == 1 ? attribute.args[0] : "";
+    if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 10)
+    {
+        return 0;
     }
 
-    m_LastValue = m_IRBuilder.CreateCall(callee, args, node.callee + "_call");
+    uint64_t alignment = std::stoull(value);
+    return llvm::isPowerOf2_64(alignment) && alignment <= llvm::Value::MaximumAlignment ? alignment : 0;
 }
 
-void CodeGenerator::VisitBinaryExpr(BinaryExpr &node)
+void CodeGenerator::VisitStructDecl(StructDecl &node)
 {
-    // Handle short-circuit operators separately - they must not evaluate RHS eagerly
-    if (node.op == "&&")
-    {
-        // Short-circuit AND: if left is false, result is false; otherwise evaluate right
-        node.left->Accept(*this);
-        llvm::Value *leftVal = m_LastValue;
+    StructInfo structInfo;
+    llvm::Align structAlignment;
 
-        if (!leftVal)
+    for (const Attribute &attribute : node.attributes)
+    {
+        if (attribute.name == "repr" && attribute.args.size() == 1 && attribute.args[0] == "C")
         {
-            JLANG_ERROR("Invalid left operand in && expression");
-            return;
+            structInfo.isReprC = true;
         }
-
-        llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
-
-        llvm::BasicBlock *rhsBlock = llvm::BasicBlock::Create(m_Context, "and.rhs", parentFunction);
-        llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "and.merge");
-
-        // Convert left to i1 if needed
-        llvm::Value *leftBool = leftVal;
-        if (!leftVal->getType()->isIntegerTy(1))
+        else if (attribute.name == "repr")
         {
-            leftBool =
-                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+            JLANG_ERROR(STR("Struct '%s': repr only supports #[repr(C)]", node.name.c_str()));
+        }
+        else if (attribute.name == "packed" && attribute.args.empty())
+        {
+            structInfo.isPacked = true;
+        }
+        else if (attribute.name == "soa" && attribute.args.empty())
+        {
+            structInfo.isSoa = true;
+        }
+        else if (attribute.name == "align" && ParseAlignAttribute(attribute))
+        {
+            structAlignment = std::max(structAlignment, llvm::Align(ParseAlignAttribute(attribute)));
+        }
+        else if (attribute.name == "packed" || attribute.name == "align")
+        {
+            JLANG_ERROR(STR("Struct '%s': expected #[packed] or #[align(N)] with N a power of two",
+                            node.name.c_str()));
         }
+        else
+        {
+            JLANG_ERROR(STR("Unknown struct attribute '%s'", attribute.name.c_str()));
+        }
+    }
 
-        llvm::BasicBlock *entryBlock = m_IRBuilder.GetInsertBlock();
-        m_IRBuilder.CreateCondBr(leftBool, rhsBlock, mergeBlock);
+    std::vector<llvm::Type *> declaredTypes;
+    std::vector<llvm::Align> declaredAlignments; // Minimum alignment from #[align(N)] on the field
+    for (const StructField &field : node.fields)
+    {
+        // A column is an array of the field type, and there are no arrays of arrays or slices
+        if (structInfo.isSoa && (field.type.IsArray() || field.type.isSlice))
+        {
+            JLANG_ERROR(STR("#[soa] struct '%s': field '%s' cannot be an array or a slice", node.name.c_str(),
+                            field.name.c_str()));
+        }
 
-        // RHS block - only now evaluate the right operand
-        m_IRBuilder.SetInsertPoint(rhsBlock);
-        node.right->Accept(*this);
-        llvm::Value *rightVal = m_LastValue;
+        declaredTypes.push_back(MapType(field.type));
+        declaredAlignments.push_back(llvm::Align());
 
-        if (!rightVal)
+        for (const Attribute &attribute : field.attributes)
         {
-            JLANG_ERROR("Invalid right operand in && expression");
-            return;
+            if (attribute.name == "align" && ParseAlignAttribute(attribute))
+            {
+                declaredAlignments.back() =
+                    std::max(declaredAlignments.back(), llvm::Align(ParseAlignAttribute(attribute)));
+            }
+            else
+            {
+                JLANG_ERROR(STR("Field '%s': only #[align(N)] with N a power of two is allowed on fields",
+                                field.name.c_str()));
+            }
         }
+    }
 
-        llvm::Value *rightBool = rightVal;
-        if (!rightVal->getType()->isIntegerTy(1))
+    // A #[packed] struct only aligns the fields that ask for it
+    for (size_t i = 0; i < node.fields.size(); ++i)
+    {
+        if (!structInfo.isPacked)
         {
-            rightBool =
-                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
+            declaredAlignments[i] =
+                std::max(declaredAlignments[i], TypeAlignment(node.fields[i].type, declaredTypes[i]));
         }
-        llvm::BasicBlock *rhsEndBlock = m_IRBuilder.GetInsertBlock();
-        m_IRBuilder.CreateBr(mergeBlock);
+    }
 
-        // Merge block
-        mergeBlock->insertInto(parentFunction);
-        m_IRBuilder.SetInsertPoint(mergeBlock);
+    // Every LLVM type's size is a multiple of its alignment, so laying fields out from the strictest
+    // alignment down leaves no holes between them, only tail padding. Equally aligned fields keep
+    // their declaration order. #[repr(C)] keeps the declared layout for C interop and hand-tuned structs,
+    // #[packed] has no holes to remove and keeps it too.
+    std::vector<unsigned> order(node.fields.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!structInfo.isReprC && !structInfo.isPacked)
+    {
+        std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+            return declaredAlignments[a] > declaredAlignments[b];
+        });
+    }
 
-        llvm::PHINode *phi = m_IRBuilder.CreatePHI(llvm::Type::getInt1Ty(m_Context), 2, "and.result");
-        phi->addIncoming(llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 0), entryBlock);
-        phi->addIncoming(rightBool, rhsEndBlock);
+    std::vector<llvm::Type *> fieldTypes;
+    std::vector<llvm::Align> fieldAlignments;
+    for (unsigned i : order)
+    {
+        fieldTypes.push_back(declaredTypes[i]);
+        fieldAlignments.push_back(declaredAlignments[i]);
+    }
 
-        m_LastValue = phi;
-        return;
+    structInfo.isReordered = !std::is_sorted(order.begin(), order.end());
+
+    StructLayoutPlan plan = PlanStructLayout(fieldTypes, fieldAlignments, structAlignment);
+    structInfo.declaredSize = PlanStructLayout(declaredTypes, declaredAlignments, structAlignment).size;
+
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        const auto &field = node.fields[order[i]];
+        structInfo.fields[field.name] =
+            FieldInfo{plan.fieldIndices[i], field.type, field.isPublic, plan.fieldAlignments[i], order[i]};
     }
 
-    if (node.op == "||")
+    for (const auto &field : node.fields)
     {
-        // Short-circuit OR: if left is true, result is true; otherwise evaluate right
-        node.left->Accept(*this);
-        llvm::Value *leftVal = m_LastValue;
+        structInfo.declarationOrder.push_back(field.name);
+    }
 
-        if (!leftVal)
-        {
-            JLANG_ERROR("Invalid left operand in || expression");
-            return;
-        }
+    structInfo.llvmType = llvm::StructType::create(m_Context, plan.elements, node.name, plan.isExplicit);
+    structInfo.alignment = plan.alignment;
 
-        llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+    m_structTypes[node.name] = structInfo;
+    m_StructOrder.push_back(node.name);
+}
 
-        llvm::BasicBlock *rhsBlock = llvm::BasicBlock::Create(m_Context, "or.rhs", parentFunction);
-        llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "or.merge");
+CodeGenerator::StructLayoutPlan CodeGenerator::PlanStructLayout(const std::vector<llvm::Type *> &types,
+                                                                const std::vector<llvm::Align> &alignments,
+                                                                llvm::Align structAlignment) const
+{
+    const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+    StructLayoutPlan plan;
 
-        // Convert left to i1 if needed
-        llvm::Value *leftBool = leftVal;
-        if (!leftVal->getType()->isIntegerTy(1))
+    bool isNatural = structAlignment == llvm::Align();
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        isNatural = isNatural && alignments[i] == dataLayout.getABITypeAlign(types[i]);
+    }
+
+    if (isNatural)
+    {
+        plan.elements = types;
+        const llvm::StructLayout *layout =
+            dataLayout.getStructLayout(llvm::StructType::get(m_Context, plan.elements));
+        plan.size = layout->getSizeInBytes();
+        plan.alignment = layout->getAlignment();
+        for (unsigned i = 0; i < types.size(); ++i)
         {
-            leftBool =
-                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+            plan.fieldIndices.push_back(i);
+            uint64_t offset = layout->getElementOffset(i);
+            plan.fieldAlignments.push_back(llvm::commonAlignment(plan.alignment, offset));
         }
+        return plan;
+    }
 
-        llvm::BasicBlock *entryBlock = m_IRBuilder.GetInsertBlock();
-        m_IRBuilder.CreateCondBr(leftBool, mergeBlock, rhsBlock);
-
-        // RHS block - only now evaluate the right operand
-        m_IRBuilder.SetInsertPoint(rhsBlock);
-        node.right->Accept(*this);
-        llvm::Value *rightVal = m_LastValue;
+    plan.isExplicit = true;
+    plan.alignment = structAlignment;
 
-        if (!rightVal)
+    std::vector<uint64_t> offsets;
+    auto padTo = [&](uint64_t offset) {
+        if (offset > plan.size)
         {
-            JLANG_ERROR("Invalid right operand in || expression");
+            llvm::Type *byteType = llvm::Type::getInt8Ty(m_Context);
+            plan.elements.push_back(llvm::ArrayType::get(byteType, offset - plan.size));
+            plan.size = offset;
+        }
+    };
+
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        llvm::Align fieldAlignment = alignments[i];
+        padTo(llvm::alignTo(plan.size, fieldAlignment));
+
+        offsets.push_back(plan.size);
+        plan.fieldIndices.push_back(static_cast<unsigned>(plan.elements.size()));
+        plan.elements.push_back(types[i]);
+        plan.size += dataLayout.getTypeAllocSize(types[i]).getFixedSize();
+        plan.alignment = std::max(plan.alignment, fieldAlignment);
+    }
+
+    // Tail padding keeps every element of an array of the struct aligned
+    padTo(llvm::alignTo(plan.size, plan.alignment));
+
+    for (uint64_t offset : offsets)
+    {
+        plan.fieldAlignments.push_back(llvm::commonAlignment(plan.alignment, offset));
+    }
+
+    return plan;
+}
+
+llvm::Align CodeGenerator::TypeAlignment(const TypeRef &typeRef, llvm::Type *type) const
+{
+    // Also covers arrays of structs, which are as aligned as their elements
+    if (!typeRef.isPointer && !typeRef.isSlice)
+    {
+        auto structIt = m_structTypes.find(typeRef.name);
+        if (structIt != m_structTypes.end() && IsSoaArray(typeRef))
+        {
+            // A #[soa] array starts as aligned as the struct asks, #[align(32)] suits f32x8 scans
+            return std::max(structIt->second.alignment, m_Module->getDataLayout().getABITypeAlign(type));
+        }
+        if (structIt != m_structTypes.end())
+        {
+            return structIt->second.alignment;
+        }
+    }
+
+    return m_Module->getDataLayout().getABITypeAlign(type);
+}
+
+llvm::Align CodeGenerator::AccessAlignment(AstNode *node, llvm::Type *type) const
+{
+    llvm::Align alignment = m_Module->getDataLayout().getABITypeAlign(type);
+
+    // An element of an array field is no better aligned than the field
+    if (auto *index = dynamic_cast<IndexExpr *>(node); index && ResolvedTypeOf(index->object).IsArray())
+    {
+        node = index->object;
+    }
+
+    auto *member = dynamic_cast<MemberAccessExpr *>(node);
+    auto structIt = member ? m_structTypes.find(ResolvedTypeOf(member->object).name) : m_structTypes.end();
+    if (structIt == m_structTypes.end())
+    {
+        return alignment;
+    }
+
+    const auto &fields = structIt->second.fields;
+    auto fieldIt = fields.find(member->memberName);
+    return fieldIt != fields.end() ? std::min(alignment, fieldIt->second.alignment) : alignment;
+}
+
+void CodeGenerator::VisitVariableDecl(VariableDecl &node)
+{
+    llvm::Type *varType = nullptr;
+    TypeRef inferredType = node.varType;
+
+    // Check if type inference is needed (empty type name)
+    if (node.varType.name.empty())
+    {
+        if (!node.initializer)
+        {
+            JLANG_ERROR(STR("Type inference requires an initializer for variable: %s", node.name.c_str()));
+            return;
+        }
+
+        // Evaluate initializer first to get its type
+        node.initializer->Accept(*this);
+        if (!m_LastValue)
+        {
+            JLANG_ERROR(STR("Invalid initializer for variable: %s", node.name.c_str()));
+            return;
+        }
+
+        varType = m_LastValue->getType();
+        inferredType = ResolvedTypeOf(node.initializer);
+        if (!inferredType.IsKnown())
+        {
+            inferredType = InferTypeRef(varType);
+        }
+
+        // Create alloca and store the already-computed value
+        llvm::AllocaInst *alloca =
+            CreateEntryBlockAlloca(varType, node.name, TypeAlignment(inferredType, varType));
+        StartLifetime(alloca);
+        m_IRBuilder.CreateStore(m_LastValue, alloca);
+
+        // Track variable with inferred type
+        DeclareVariable(node.name, VariableInfo{alloca, inferredType, false, node.isMutable});
+        return;
+    }
+
+    // Explicit type - use existing logic
+    varType = MapType(node.varType);
+
+    // Null safety: non-nullable pointers must be initialized
+    if (node.varType.isPointer && !node.varType.isNullable && !node.varType.IsArray() && !node.initializer)
+    {
+        JLANG_ERROR(STR("Non-nullable pointer '%s' must be initialized.", node.name.c_str()));
+        return;
+    }
+
+    llvm::AllocaInst *alloca =
+        CreateEntryBlockAlloca(varType, node.name, TypeAlignment(node.varType, varType));
+    StartLifetime(alloca);
+
+    if (node.initializer)
+    {
+        m_LastValue = EmitValueFor(node.initializer, node.varType);
+        if (m_LastValue && IsStructValue(node.varType) && m_LastValue->getType() != varType)
+        {
+            JLANG_ERROR(STR("Cannot initialize '%s' of type '%s' with a value of another type",
+                            node.name.c_str(), node.varType.Spelling().c_str()));
+            return;
+        }
+
+        if (m_LastValue)
+        {
+            // Null safety: cannot assign null to non-nullable pointer
+            if (node.varType.isPointer && !node.varType.isNullable &&
+                llvm::isa<llvm::ConstantPointerNull>(m_LastValue))
+            {
+                JLANG_ERROR(
+                    STR("Cannot assign null to non-nullable pointer type '%s*'. Use '%s*?' to allow null.",
+                        node.varType.name.c_str(), node.varType.name.c_str()));
+                return;
+            }
+
+            if (m_LastValue->getType() != varType && varType->isPointerTy() &&
+                m_LastValue->getType()->isPointerTy())
+            {
+                m_LastValue = m_IRBuilder.CreateBitCast(m_LastValue, varType, "cast");
+            }
+            m_IRBuilder.CreateStore(m_LastValue, alloca);
+        }
+    }
+
+    // Track variable with usage info (initially unused)
+    DeclareVariable(node.name, VariableInfo{alloca, node.varType, false, node.isMutable});
+}
+
+void CodeGenerator::VisitIfStatement(IfStatement &node)
+{
+    node.condition->Accept(*this);
+    llvm::Value *conditionValue = m_LastValue;
+
+    if (!conditionValue)
+    {
+        JLANG_ERROR("Invalid condition in if statement");
+        return;
+    }
+
+    if (conditionValue->getType()->isIntegerTy(32))
+    {
+        conditionValue = m_IRBuilder.CreateICmpNE(
+            conditionValue, llvm::ConstantInt::get(conditionValue->getType(), 0), "ifcond");
+    }
+
+    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+
+    llvm::BasicBlock *thenBlock = llvm::BasicBlock::Create(m_Context, "then", parentFunction);
+    llvm::BasicBlock *elseBlock = llvm::BasicBlock::Create(m_Context, "else");
+    llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "ifcont");
+
+    m_IRBuilder.CreateCondBr(conditionValue, thenBlock, elseBlock);
+
+    m_IRBuilder.SetInsertPoint(thenBlock);
+    node.thenBranch->Accept(*this);
+
+    // A branch that returns already ends its block
+    if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+    {
+        m_IRBuilder.CreateBr(mergeBlock);
+    }
+
+    elseBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(elseBlock);
+    if (node.elseBranch)
+    {
+        node.elseBranch->Accept(*this);
+    }
+    if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+    {
+        m_IRBuilder.CreateBr(mergeBlock);
+    }
+
+    mergeBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(mergeBlock);
+}
+
+void CodeGenerator::VisitWhileStatement(WhileStatement &node)
+{
+    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+
+    llvm::BasicBlock *condBlock = llvm::BasicBlock::Create(m_Context, "while.cond", parentFunction);
+    llvm::BasicBlock *bodyBlock = llvm::BasicBlock::Create(m_Context, "while.body");
+    llvm::BasicBlock *exitBlock = llvm::BasicBlock::Create(m_Context, "while.exit");
+
+    // Branch to condition block
+    m_IRBuilder.CreateBr(condBlock);
+
+    // Condition block
+    m_IRBuilder.SetInsertPoint(condBlock);
+    node.condition->Accept(*this);
+    llvm::Value *condValue = m_LastValue;
+
+    if (!condValue)
+    {
+        JLANG_ERROR("Invalid condition in while statement");
+        return;
+    }
+
+    // Convert i32 to i1 if necessary
+    if (condValue->getType()->isIntegerTy(32))
+    {
+        condValue =
+            m_IRBuilder.CreateICmpNE(condValue, llvm::ConstantInt::get(condValue->getType(), 0), "whilecond");
+    }
+
+    m_IRBuilder.CreateCondBr(condValue, bodyBlock, exitBlock);
+
+    // Body block
+    bodyBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(bodyBlock);
+    node.body->Accept(*this);
+
+    // A body that returns has no back edge to carry the loop hints
+    if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+    {
+        llvm::BranchInst *backEdge = m_IRBuilder.CreateBr(condBlock);
+        if (llvm::MDNode *loopID = CreateLoopMetadata(node.attributes))
+        {
+            backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+        }
+    }
+
+    // Exit block
+    exitBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(exitBlock);
+}
+
+void CodeGenerator::VisitForStatement(ForStatement &node)
+{
+    // The loop variable is only visible inside the loop
+    PushScope();
+    EmitForStatement(node);
+    PopScope();
+}
+
+void CodeGenerator::EmitForStatement(ForStatement &node)
+{
+    // Execute initializer (if present)
+    if (node.init)
+    {
+        node.init->Accept(*this);
+    }
+
+    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+
+    llvm::BasicBlock *condBlock = llvm::BasicBlock::Create(m_Context, "for.cond", parentFunction);
+    llvm::BasicBlock *bodyBlock = llvm::BasicBlock::Create(m_Context, "for.body");
+    llvm::BasicBlock *updateBlock = llvm::BasicBlock::Create(m_Context, "for.update");
+    llvm::BasicBlock *exitBlock = llvm::BasicBlock::Create(m_Context, "for.exit");
+
+    // Branch to condition block
+    m_IRBuilder.CreateBr(condBlock);
+
+    // Condition block
+    m_IRBuilder.SetInsertPoint(condBlock);
+    if (node.condition)
+    {
+        node.condition->Accept(*this);
+        llvm::Value *condValue = m_LastValue;
+
+        if (!condValue)
+        {
+            JLANG_ERROR("Invalid condition in for statement");
+            return;
+        }
+
+        // Convert i32 to i1 if necessary
+        if (condValue->getType()->isIntegerTy(32))
+        {
+            condValue = m_IRBuilder.CreateICmpNE(condValue, llvm::ConstantInt::get(condValue->getType(), 0),
+                                                 "forcond");
+        }
+
+        m_IRBuilder.CreateCondBr(condValue, bodyBlock, exitBlock);
+    }
+    else
+    {
+        // No condition = infinite loop
+        m_IRBuilder.CreateBr(bodyBlock);
+    }
+
+    // Body block
+    bodyBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(bodyBlock);
+    node.body->Accept(*this);
+    if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+    {
+        m_IRBuilder.CreateBr(updateBlock);
+    }
+
+    // Update block
+    updateBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(updateBlock);
+    if (node.update)
+    {
+        node.update->Accept(*this);
+    }
+    llvm::BranchInst *backEdge = m_IRBuilder.CreateBr(condBlock);
+    if (llvm::MDNode *loopID = CreateLoopMetadata(node.attributes))
+    {
+        backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+    }
+
+    // Exit block
+    exitBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(exitBlock);
+}
+
+llvm::MDNode *CodeGenerator::CreateLoopMetadata(const std::vector<Attribute> &attributes)
+{
+    // Operand 0 is reserved for the self reference that makes the node a loop ID
+    llvm::SmallVector<llvm::Metadata *, 4> properties{nullptr};
+
+    auto addProperty = [&](const char *name, llvm::Constant *value = nullptr) {
+        llvm::SmallVector<llvm::Metadata *, 2> operands{llvm::MDString::get(m_Context, name)};
+        if (value)
+        {
+            operands.push_back(llvm::ConstantAsMetadata::get(value));
+        }
+        properties.push_back(llvm::MDNode::get(m_Context, operands));
+    };
+    auto i32 = [&](uint64_t value) { return m_IRBuilder.getInt32(static_cast<uint32_t>(value)); };
+
+    for (const Attribute &attribute : attributes)
+    {
+        if (attribute.args.size() > 1)
+        {
+            JLANG_ERROR(STR("Loop attribute '%s' takes at most one argument", attribute.name.c_str()));
+            continue;
+        }
+
+        const std::string argument = attribute.args.empty() ? "" : attribute.args.front();
+        bool isCount = !argument.empty() && std::all_of(argument.begin(), argument.end(), ::isdigit);
+
+        // Ten digits cannot overflow stoull, anything longer is out of range anyway
+        uint64_t count = isCount && argument.size() <= 10 ? std::stoull(argument) : 0;
+        if (isCount && (argument.size() > 10 || count > UINT32_MAX))
+        {
+            JLANG_ERROR(STR("Loop attribute '%s': count %s is out of range, the maximum is %u",
+                            attribute.name.c_str(), argument.c_str(), UINT32_MAX));
+            continue;
+        }
+
+        if (isCount && count == 0)
+        {
+            JLANG_ERROR(STR("Loop attribute '%s' needs a count of at least 1", attribute.name.c_str()));
+            continue;
+        }
+
+        if (attribute.name == "unroll")
+        {
+            // #[unroll] lets the unroller pick the factor, a count unrolls by exactly that much and leaves
+            // a remainder loop when the trip count is not a multiple of it
+            if (argument.empty())
+            {
+                addProperty("llvm.loop.unroll.enable");
+            }
+            else if (argument == "full")
+            {
+                addProperty("llvm.loop.unroll.full");
+            }
+            else if (argument == "disable")
+            {
+                addProperty("llvm.loop.unroll.disable");
+            }
+            else if (isCount)
+            {
+                addProperty("llvm.loop.unroll.count", i32(count));
+            }
+            else
+            {
+                JLANG_ERROR(STR("Invalid argument '%s' for #[unroll], expected a count, 'full' or 'disable'",
+                                argument.c_str()));
+            }
+        }
+        else if (attribute.name == "vectorize")
+        {
+            if (argument == "disable")
+            {
+                addProperty("llvm.loop.vectorize.enable", m_IRBuilder.getFalse());
+            }
+            else if (argument.empty() || isCount)
+            {
+                addProperty("llvm.loop.vectorize.enable", m_IRBuilder.getTrue());
+                if (isCount)
+                {
+                    addProperty("llvm.loop.vectorize.width", i32(count));
+                }
+            }
+            else
+            {
+                JLANG_ERROR(STR("Invalid argument '%s' for #[vectorize], expected a width or 'disable'",
+                                argument.c_str()));
+            }
+        }
+        else if (attribute.name == "interleave")
+        {
+            // An interleave count of 1 is how LLVM spells "do not interleave"
+            if (argument == "disable")
+            {
+                addProperty("llvm.loop.interleave.count", i32(1));
+            }
+            else if (isCount)
+            {
+                addProperty("llvm.loop.interleave.count", i32(count));
+            }
+            else
+            {
+                JLANG_ERROR(STR("Invalid argument '%s' for #[interleave], expected a count or 'disable'",
+                                argument.c_str()));
+            }
+        }
+        else
+        {
+            JLANG_ERROR(STR("Unknown loop attribute: %s", attribute.name.c_str()));
+        }
+    }
+
+    if (properties.size() == 1)
+    {
+        return nullptr;
+    }
+
+    llvm::MDNode *loopID = llvm::MDNode::getDistinct(m_Context, properties);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
+}
+
+void CodeGenerator::VisitBlockStatement(BlockStatement &node)
+{
+    PushScope();
+
+    for (auto &statement : node.statements)
+    {
+        if (statement)
+        {
+            statement->Accept(*this);
+        }
+    }
+
+    PopScope();
+}
+
+void CodeGenerator::VisitExprStatement(ExprStatement &node)
+{
+    if (node.expression)
+    {
+        node.expression->Accept(*this);
+    }
+}
+
+void CodeGenerator::VisitReturnStatement(ReturnStatement &node)
+{
+    if (node.value && m_CurrentFunction && IsStructValue(m_CurrentFunction->returnType))
+    {
+        const TypeRef &returnType = m_CurrentFunction->returnType;
+        llvm::Type *structType = MapType(returnType);
+        llvm::Value *value = EmitValueFor(node.value, returnType);
+        if (!value || value->getType() != structType)
+        {
+            JLANG_ERROR(STR("The function returns a '%s', the value has another type",
+                            returnType.Spelling().c_str()));
+            return;
+        }
+
+        const AbiLowering &result = m_CurrentFunction->result;
+        if (result.isIndirect)
+        {
+            llvm::Value *slot = m_IRBuilder.GetInsertBlock()->getParent()->getArg(0);
+            m_IRBuilder.CreateAlignedStore(value, slot, TypeAlignment(returnType, structType));
+            m_IRBuilder.CreateRetVoid();
+            return;
+        }
+
+        std::vector<llvm::Value *> parts = EmitRegisterParts(value, result);
+        if (parts.size() <= 1)
+        {
+            parts.empty() ? m_IRBuilder.CreateRetVoid() : m_IRBuilder.CreateRet(parts[0]);
+            return;
+        }
+
+        llvm::Value *registers = llvm::UndefValue::get(m_IRBuilder.getCurrentFunctionReturnType());
+        for (unsigned i = 0; i < parts.size(); ++i)
+        {
+            registers = m_IRBuilder.CreateInsertValue(registers, parts[i], i);
+        }
+        m_IRBuilder.CreateRet(registers);
+        return;
+    }
+
+    if (node.value)
+    {
+        node.value->Accept(*this);
+        m_IRBuilder.CreateRet(m_LastValue);
+    }
+    else
+    {
+        m_IRBuilder.CreateRetVoid();
+    }
+}
+
+// Ranges up to this many values become individual switch cases, so the backend can still build a
+// jump table. Wider ones are tested with a subtract and one unsigned compare instead.
+static constexpr uint64_t kMaxRangeCases = 256;
+
+void CodeGenerator::VisitMatchStatement(MatchStatement &node)
+{
+    node.value->Accept(*this);
+    llvm::Value *value = m_LastValue;
+
+    if (!value || !value->getType()->isIntegerTy())
+    {
+        JLANG_ERROR("Match value must be an integer, char or bool");
+        return;
+    }
+
+    bool isSigned = ResolvedTypeOf(node.value).IsSignedInteger();
+
+    struct CaseRange
+    {
+        llvm::APInt low;
+        llvm::APInt high; // Inclusive
+        size_t arm;
+    };
+
+    std::vector<CaseRange> ranges;
+
+    for (size_t armIndex = 0; armIndex < node.arms.size(); ++armIndex)
+    {
+        for (MatchPattern &pattern : node.arms[armIndex].patterns)
+        {
+            llvm::ConstantInt *low = EmitMatchConstant(pattern.low, value->getType());
+            llvm::ConstantInt *high = pattern.high ? EmitMatchConstant(pattern.high, value->getType()) : low;
+            if (!low || !high)
+            {
+                return;
+            }
+
+            llvm::APInt last = high->getValue();
+            bool isEmpty = isSigned ? low->getValue().sgt(last) : low->getValue().ugt(last);
+            if (pattern.high && !pattern.isInclusive)
+            {
+                isEmpty = isEmpty || last == low->getValue();
+                --last;
+            }
+
+            if (isEmpty)
+            {
+                JLANG_ERROR("Match range is empty");
+                return;
+            }
+
+            ranges.push_back(CaseRange{low->getValue(), last, armIndex});
+        }
+    }
+
+    // A value must select exactly one arm, and LLVM rejects duplicate switch cases anyway
+    std::sort(ranges.begin(), ranges.end(), [isSigned](const CaseRange &a, const CaseRange &b)
+              { return isSigned ? a.low.slt(b.low) : a.low.ult(b.low); });
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        const llvm::APInt &previousHigh = ranges[i - 1].high;
+        if (isSigned ? ranges[i].low.sle(previousHigh) : ranges[i].low.ule(previousHigh))
+        {
+            std::string overlap = isSigned ? std::to_string(ranges[i].low.getSExtValue())
+                                           : std::to_string(ranges[i].low.getZExtValue());
+            JLANG_ERROR(STR("Match patterns overlap at %s", overlap.c_str()));
+            return;
+        }
+    }
+
+    llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+    llvm::BasicBlock *defaultBlock = llvm::BasicBlock::Create(m_Context, "match.default");
+    llvm::BasicBlock *endBlock = llvm::BasicBlock::Create(m_Context, "match.end");
+
+    std::vector<llvm::BasicBlock *> armBlocks;
+    AstNode *defaultBody = nullptr;
+    for (MatchArm &arm : node.arms)
+    {
+        defaultBody = arm.isWildcard ? arm.body : defaultBody;
+        armBlocks.push_back(arm.isWildcard ? defaultBlock : llvm::BasicBlock::Create(m_Context, "match.arm"));
+    }
+
+    std::vector<const CaseRange *> wideRanges;
+    for (const CaseRange &range : ranges)
+    {
+        if ((range.high - range.low).uge(kMaxRangeCases))
+        {
+            wideRanges.push_back(&range);
+        }
+    }
+
+    llvm::BasicBlock *rangeBlock = wideRanges.empty()
+                                       ? defaultBlock
+                                       : llvm::BasicBlock::Create(m_Context, "match.range", parentFunction);
+    llvm::SwitchInst *switchInst = m_IRBuilder.CreateSwitch(value, rangeBlock, ranges.size());
+
+    for (const CaseRange &range : ranges)
+    {
+        if ((range.high - range.low).uge(kMaxRangeCases))
+        {
+            continue;
+        }
+
+        for (llvm::APInt caseValue = range.low;; ++caseValue)
+        {
+            switchInst->addCase(llvm::ConstantInt::get(m_Context, caseValue), armBlocks[range.arm]);
+            if (caseValue == range.high)
+            {
+                break;
+            }
+        }
+    }
+
+    // Values outside every case fall through to the wide ranges: value - low <= high - low, unsigned,
+    // holds exactly for low <= value <= high whatever the signedness
+    for (size_t i = 0; i < wideRanges.size(); ++i)
+    {
+        const CaseRange &range = *wideRanges[i];
+        m_IRBuilder.SetInsertPoint(rangeBlock);
+
+        llvm::Value *offset =
+            m_IRBuilder.CreateSub(value, llvm::ConstantInt::get(m_Context, range.low), "match.offset");
+        llvm::Value *inRange = m_IRBuilder.CreateICmpULE(
+            offset, llvm::ConstantInt::get(m_Context, range.high - range.low), "match.inrange");
+
+        llvm::BasicBlock *next = i + 1 < wideRanges.size()
+                                     ? llvm::BasicBlock::Create(m_Context, "match.range", parentFunction)
+                                     : defaultBlock;
+        m_IRBuilder.CreateCondBr(inRange, armBlocks[range.arm], next);
+        rangeBlock = next;
+    }
+
+    for (size_t i = 0; i < node.arms.size(); ++i)
+    {
+        if (node.arms[i].isWildcard)
+        {
+            continue;
+        }
+
+        armBlocks[i]->insertInto(parentFunction);
+        m_IRBuilder.SetInsertPoint(armBlocks[i]);
+        node.arms[i].body->Accept(*this);
+
+        // An arm that returns already ends its block
+        if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+        {
+            m_IRBuilder.CreateBr(endBlock);
+        }
+    }
+
+    defaultBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(defaultBlock);
+    if (defaultBody)
+    {
+        defaultBody->Accept(*this);
+    }
+    if (!m_IRBuilder.GetInsertBlock()->getTerminator())
+    {
+        m_IRBuilder.CreateBr(endBlock);
+    }
+
+    endBlock->insertInto(parentFunction);
+    m_IRBuilder.SetInsertPoint(endBlock);
+}
+
+llvm::ConstantInt *CodeGenerator::EmitMatchConstant(AstNode *node, llvm::Type *valueType)
+{
+    m_LastValue = nullptr;
+    if (node)
+    {
+        node->Accept(*this);
+    }
+
+    auto *constant = llvm::dyn_cast_or_null<llvm::ConstantInt>(m_LastValue);
+    if (!constant)
+    {
+        JLANG_ERROR("Match patterns must be integer, char or bool constants");
+        return nullptr;
+    }
+
+    if (constant->getType() != valueType)
+    {
+        JLANG_ERROR("Match pattern type does not match the matched value");
+        return nullptr;
+    }
+
+    return constant;
+}
+
+void CodeGenerator::VisitCallExpr(CallExpr &node)
+{
+    if (IsVectorBuiltin(node.callee))
+    {
+        EmitVectorBuiltin(node);
+        return;
+    }
+
+    llvm::Function *callee = m_Module->getFunction(node.callee);
+
+    if (!callee)
+    {
+        JLANG_ERROR(STR("Unknown function: %s", node.callee.c_str()));
+        return;
+    }
+
+    // Struct values cross the call as the callee's lowered signature says, externals take none
+    auto abiIt = m_Functions.find(node.callee);
+    const FunctionAbi *abi = abiIt != m_Functions.end() ? &abiIt->second : nullptr;
+
+    std::vector<llvm::Value *> args;
+
+    llvm::Value *resultSlot = nullptr;
+    if (abi && abi->result.isIndirect)
+    {
+        llvm::Type *structType = MapType(abi->returnType);
+        resultSlot = CreateEntryBlockAlloca(structType, "sret", TypeAlignment(abi->returnType, structType));
+        args.push_back(resultSlot);
+    }
+
+    for (size_t argIndex = 0; argIndex < node.arguments.size(); ++argIndex)
+    {
+        AstNode *arg = node.arguments[argIndex];
+
+        if (abi && argIndex < abi->paramTypes.size() && IsStructValue(abi->paramTypes[argIndex]))
+        {
+            const TypeRef &paramType = abi->paramTypes[argIndex];
+            llvm::Type *structType = MapType(paramType);
+            llvm::Value *value = EmitValueFor(arg, paramType);
+            if (!value || value->getType() != structType)
+            {
+                JLANG_ERROR(STR("Argument %zu of %s must be a '%s'", argIndex + 1, node.callee.c_str(),
+                                paramType.Spelling().c_str()));
+                return;
+            }
+
+            const AbiLowering &lowering = abi->params[argIndex];
+            if (lowering.isIndirect)
+            {
+                // byval: the callee gets its own copy of this temporary on the stack
+                llvm::AllocaInst *copy =
+                    CreateEntryBlockAlloca(structType, "byval", ByValAlignment(paramType, structType));
+                m_IRBuilder.CreateAlignedStore(value, copy, copy->getAlign());
+                args.push_back(copy);
+            }
+            else
+            {
+                std::vector<llvm::Value *> parts = EmitRegisterParts(value, lowering);
+                args.insert(args.end(), parts.begin(), parts.end());
+            }
+            continue;
+        }
+
+        // An array handed to a slice parameter is passed as a slice over the whole array. The declared
+        // parameter type is the target, so EmitValueFor can reject a slice of a different element type.
+        TypeRef argType = ResolvedTypeOf(arg);
+        if (argType.IsArray() && abi && argIndex < abi->paramTypes.size() &&
+            abi->paramTypes[argIndex].isSlice)
+        {
+            argType = abi->paramTypes[argIndex];
+        }
+
+        m_LastValue = EmitValueFor(arg, argType);
+
+        if (!m_LastValue)
+        {
+            JLANG_ERROR(STR("Invalid argument in call to %s", node.callee.c_str()));
+            return;
+        }
+
+        // Typed pointers differ per pointee, so a Person* handed to free(i8*) needs a cast
+        size_t index = args.size();
+        if (callee->isVarArg() && index >= callee->arg_size())
+        {
+            // C default argument promotions for the variadic part: f32 -> f64, small integers -> i32
+            llvm::Type *valueType = m_LastValue->getType();
+            if (valueType->isFloatTy())
+            {
+                m_LastValue = m_IRBuilder.CreateFPExt(m_LastValue, m_IRBuilder.getDoubleTy(), "promote");
+            }
+            else if (valueType->isIntegerTy() && valueType->getIntegerBitWidth() < 32)
+            {
+                bool isSigned = ResolvedTypeOf(arg).IsSignedInteger();
+                m_LastValue =
+                    m_IRBuilder.CreateIntCast(m_LastValue, m_IRBuilder.getInt32Ty(), isSigned, "promote");
+            }
+        }
+
+        if (index < callee->arg_size() && m_LastValue->getType() != callee->getArg(index)->getType() &&
+            m_LastValue->getType()->isPointerTy() && callee->getArg(index)->getType()->isPointerTy())
+        {
+            m_LastValue = m_IRBuilder.CreateBitCast(m_LastValue, callee->getArg(index)->getType(), "cast");
+        }
+        args.push_back(m_LastValue);
+    }
+
+    // Void results cannot carry a name
+    std::string callName = callee->getReturnType()->isVoidTy() ? "" : node.callee + "_call";
+    llvm::CallInst *call = m_IRBuilder.CreateCall(callee, args, callName);
+
+    // A call whose convention differs from the callee's is undefined behavior
+    call->setCallingConv(callee->getCallingConv());
+    m_LastValue = call;
+
+    if (abi)
+    {
+        call->setAttributes(abi->attributes);
+    }
+
+    if (!abi || !IsStructValue(abi->returnType))
+    {
+        return;
+    }
+
+    llvm::Type *structType = MapType(abi->returnType);
+    if (abi->result.isIndirect)
+    {
+        m_LastValue = m_IRBuilder.CreateAlignedLoad(structType, resultSlot,
+                                                    TypeAlignment(abi->returnType, structType), callName);
+        return;
+    }
+
+    std::vector<llvm::Value *> parts;
+    for (unsigned i = 0; i < abi->result.registerTypes.size(); ++i)
+    {
+        bool isSingle = abi->result.registerTypes.size() == 1;
+        parts.push_back(isSingle ? call : m_IRBuilder.CreateExtractValue(call, i));
+    }
+    m_LastValue = EmitFromRegisterParts(parts, structType, abi->result);
+}
+
+static bool HasArgumentCount(const CallExpr &node, size_t count)
+{
+    if (node.arguments.size() == count)
+    {
+        return true;
+    }
+
+    JLANG_ERROR(STR("%s expects %zu arguments, got %zu", node.callee.c_str(), count, node.arguments.size()));
+    return false;
+}
+
+void CodeGenerator::EmitVectorBuiltin(CallExpr &node)
+{
+    const std::string &name = node.callee;
+    m_LastValue = nullptr;
+
+    if (name == "splat")
+    {
+        if (!HasArgumentCount(node, 1))
+        {
+            return;
+        }
+
+        const TypeRef &vectorType = node.resolvedType;
+        if (!vectorType.IsVector())
+        {
+            JLANG_ERROR("Cannot infer the vector type of splat, give the destination a vector type");
+            return;
+        }
+
+        node.arguments[0]->Accept(*this);
+        llvm::Value *scalar = m_LastValue;
+        if (!scalar || scalar->getType() != MapType(vectorType.ElementType()))
+        {
+            JLANG_ERROR(STR("splat into %s needs a %s value", vectorType.name.c_str(),
+                            vectorType.ElementType().name.c_str()));
+            m_LastValue = nullptr;
+            return;
+        }
+
+        m_LastValue = m_IRBuilder.CreateVectorSplat(vectorType.VectorLanes(), scalar, "splat");
+    }
+    else if (name == "shuffle")
+    {
+        EmitVectorShuffle(node);
+    }
+    else if (name.rfind("reduce_", 0) == 0)
+    {
+        EmitVectorReduction(node);
+    }
+    else
+    {
+        EmitVectorMemoryAccess(node);
+    }
+}
+
+void CodeGenerator::EmitVectorMemoryAccess(CallExpr &node)
+{
+    const std::string &name = node.callee;
+    bool isLoad = name == "load" || name == "load_aligned";
+    bool isAligned = name == "load_aligned" || name == "store_aligned";
+
+    // load(source, index), store(destination, index, vector)
+    if (!HasArgumentCount(node, isLoad ? 2 : 3))
+    {
+        return;
+    }
+
+    TypeRef vectorType = isLoad ? node.resolvedType : ResolvedTypeOf(node.arguments[2]);
+    if (!vectorType.IsVector())
+    {
+        JLANG_ERROR(isLoad ? STR("Cannot infer the vector type of %s, give the destination a vector type",
+                                 name.c_str())
+                           : STR("%s expects a vector as its third argument", name.c_str()));
+        return;
+    }
+
+    TypeRef memoryType = ResolvedTypeOf(node.arguments[0]);
+    TypeRef elementType = memoryType.ElementType();
+    bool isMemory = memoryType.IsArray() || memoryType.isSlice || memoryType.isPointer;
+    if (!isMemory || elementType.isPointer || elementType.name != vectorType.ElementType().name)
+    {
+        JLANG_ERROR(STR("%s of %s needs a pointer, array or slice of %s", name.c_str(),
+                        vectorType.name.c_str(), vectorType.ElementType().name.c_str()));
+        return;
+    }
+
+    llvm::Value *elementPtr = EmitElementAddress(node.arguments[0], node.arguments[1]);
+    if (!elementPtr)
+    {
+        return;
+    }
+
+    llvm::Type *llvmVectorType = MapType(vectorType);
+    llvm::Value *vectorPtr =
+        m_IRBuilder.CreateBitCast(elementPtr, llvm::PointerType::getUnqual(llvmVectorType), "vec_ptr");
+
+    // The plain forms only assume the alignment of a lane. The _aligned forms promise the full vector
+    // width, which lets the backend use aligned moves; handing them a misaligned address is undefined.
+    const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+    llvm::Align alignment = dataLayout.getABITypeAlign(llvmVectorType->getScalarType());
+    if (isAligned)
+    {
+        alignment = llvm::Align(dataLayout.getTypeStoreSize(llvmVectorType).getFixedSize());
+    }
+
+    if (isLoad)
+    {
+        m_LastValue = m_IRBuilder.CreateAlignedLoad(llvmVectorType, vectorPtr, alignment, "vec_load");
+        return;
+    }
+
+    node.arguments[2]->Accept(*this);
+    if (m_LastValue)
+    {
+        m_IRBuilder.CreateAlignedStore(m_LastValue, vectorPtr, alignment);
+    }
+    m_LastValue = nullptr;
+}
+
+void CodeGenerator::EmitVectorShuffle(CallExpr &node)
+{
+    // shuffle(a, lanes...) picks lanes of a, shuffle(a, b, lanes...) of a and b, where b's lanes are
+    // numbered after a's
+    if (node.arguments.size() < 2)
+    {
+        JLANG_ERROR("shuffle expects a vector followed by lane indices");
+        return;
+    }
+
+    node.arguments[0]->Accept(*this);
+    llvm::Value *first = m_LastValue;
+    if (!first || !first->getType()->isVectorTy())
+    {
+        JLANG_ERROR("shuffle expects a vector as its first argument");
+        m_LastValue = nullptr;
+        return;
+    }
+
+    unsigned sourceLanes = llvm::cast<llvm::FixedVectorType>(first->getType())->getNumElements();
+    llvm::Value *second = nullptr;
+    std::vector<int> mask;
+
+    for (size_t i = 1; i < node.arguments.size(); ++i)
+    {
+        node.arguments[i]->Accept(*this);
+        if (!m_LastValue)
+        {
+            return;
+        }
+
+        if (i == 1 && m_LastValue->getType()->isVectorTy())
+        {
+            second = m_LastValue;
+            if (second->getType() != first->getType())
+            {
+                JLANG_ERROR("Both vectors of a shuffle must have the same type");
+                m_LastValue = nullptr;
+                return;
+            }
+            continue;
+        }
+
+        auto *lane = llvm::dyn_cast<llvm::ConstantInt>(m_LastValue);
+        unsigned laneLimit = second ? sourceLanes * 2 : sourceLanes;
+        if (!lane || lane->uge(laneLimit))
+        {
+            JLANG_ERROR(STR("shuffle lane indices must be constants below %u", laneLimit));
+            m_LastValue = nullptr;
+            return;
+        }
+        mask.push_back(static_cast<int>(lane->getZExtValue()));
+    }
+
+    if (!node.resolvedType.IsVector())
+    {
+        JLANG_ERROR(STR("shuffle picks %zu lanes, which is not a vector type's lane count", mask.size()));
+        m_LastValue = nullptr;
+        return;
+    }
+
+    m_LastValue = second ? m_IRBuilder.CreateShuffleVector(first, second, mask, "shuffle")
+                         : m_IRBuilder.CreateShuffleVector(first, mask, "shuffle");
+}
+
+void CodeGenerator::EmitVectorReduction(CallExpr &node)
+{
+    if (!HasArgumentCount(node, 1))
+    {
+        return;
+    }
+
+    TypeRef vectorType = ResolvedTypeOf(node.arguments[0]);
+    node.arguments[0]->Accept(*this);
+    llvm::Value *vector = m_LastValue;
+    if (!vector || !vectorType.IsVector())
+    {
+        JLANG_ERROR(STR("%s expects a vector", node.callee.c_str()));
+        m_LastValue = nullptr;
+        return;
+    }
+
+    TypeRef laneType = vectorType.ElementType();
+    llvm::Type *llvmLaneType = MapType(laneType);
+    bool isFloat = laneType.IsFloat();
+    bool isSigned = laneType.IsSignedInteger();
+    llvm::CallInst *reduction = nullptr;
+
+    const std::string &operation = node.callee;
+    if (isFloat)
+    {
+        if (operation == "reduce_add")
+        {
+            reduction = m_IRBuilder.CreateFAddReduce(llvm::ConstantFP::getNegativeZero(llvmLaneType), vector);
+        }
+        else if (operation == "reduce_mul")
+        {
+            reduction = m_IRBuilder.CreateFMulReduce(llvm::ConstantFP::get(llvmLaneType, 1.0), vector);
+        }
+        else if (operation == "reduce_min")
+        {
+            reduction = m_IRBuilder.CreateFPMinReduce(vector);
+        }
+        else
+        {
+            reduction = m_IRBuilder.CreateFPMaxReduce(vector);
+        }
+    }
+    else
+    {
+        if (operation == "reduce_add")
+        {
+            reduction = m_IRBuilder.CreateAddReduce(vector);
+        }
+        else if (operation == "reduce_mul")
+        {
+            reduction = m_IRBuilder.CreateMulReduce(vector);
+        }
+        else if (operation == "reduce_min")
+        {
+            reduction = m_IRBuilder.CreateIntMinReduce(vector, isSigned);
+        }
+        else
+        {
+            reduction = m_IRBuilder.CreateIntMaxReduce(vector, isSigned);
+        }
+    }
+
+    // Float sums and products are otherwise evaluated strictly lane after lane. Allowing reassociation
+    // turns them into the log2(lanes) shuffle-and-add tree a hand-written horizontal sum would use.
+    if (isFloat)
+    {
+        reduction->setHasAllowReassoc(true);
+    }
+
+    m_LastValue = reduction;
+}
+
+void CodeGenerator::VisitBinaryExpr(BinaryExpr &node)
+{
+    // Handle short-circuit operators separately - they must not evaluate RHS eagerly
+    if (node.op == BinaryOp::LogicalAnd)
+    {
+        // Short-circuit AND: if left is false, result is false; otherwise evaluate right
+        node.left->Accept(*this);
+        llvm::Value *leftVal = m_LastValue;
+
+        if (!leftVal)
+        {
+            JLANG_ERROR("Invalid left operand in && expression");
+            return;
+        }
+
+        llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+
+        llvm::BasicBlock *rhsBlock = llvm::BasicBlock::Create(m_Context, "and.rhs", parentFunction);
+        llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "and.merge");
+
+        // Convert left to i1 if needed
+        llvm::Value *leftBool = leftVal;
+        if (!leftVal->getType()->isIntegerTy(1))
+        {
+            leftBool =
+                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+        }
+
+        llvm::BasicBlock *entryBlock = m_IRBuilder.GetInsertBlock();
+        m_IRBuilder.CreateCondBr(leftBool, rhsBlock, mergeBlock);
+
+        // RHS block - only now evaluate the right operand
+        m_IRBuilder.SetInsertPoint(rhsBlock);
+        node.right->Accept(*this);
+        llvm::Value *rightVal = m_LastValue;
+
+        if (!rightVal)
+        {
+            JLANG_ERROR("Invalid right operand in && expression");
+            return;
+        }
+
+        llvm::Value *rightBool = rightVal;
+        if (!rightVal->getType()->isIntegerTy(1))
+        {
+            rightBool =
+                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
+        }
+        llvm::BasicBlock *rhsEndBlock = m_IRBuilder.GetInsertBlock();
+        m_IRBuilder.CreateBr(mergeBlock);
+
+        // Merge block
+        mergeBlock->insertInto(parentFunction);
+        m_IRBuilder.SetInsertPoint(mergeBlock);
+
+        llvm::PHINode *phi = m_IRBuilder.CreatePHI(llvm::Type::getInt1Ty(m_Context), 2, "and.result");
+        phi->addIncoming(llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 0), entryBlock);
+        phi->addIncoming(rightBool, rhsEndBlock);
+
+        m_LastValue = phi;
+        return;
+    }
+
+    if (node.op == BinaryOp::LogicalOr)
+    {
+        // Short-circuit OR: if left is true, result is true; otherwise evaluate right
+        node.left->Accept(*this);
+        llvm::Value *leftVal = m_LastValue;
+
+        if (!leftVal)
+        {
+            JLANG_ERROR("Invalid left operand in || expression");
+            return;
+        }
+
+        llvm::Function *parentFunction = m_IRBuilder.GetInsertBlock()->getParent();
+
+        llvm::BasicBlock *rhsBlock = llvm::BasicBlock::Create(m_Context, "or.rhs", parentFunction);
+        llvm::BasicBlock *mergeBlock = llvm::BasicBlock::Create(m_Context, "or.merge");
+
+        // Convert left to i1 if needed
+        llvm::Value *leftBool = leftVal;
+        if (!leftVal->getType()->isIntegerTy(1))
+        {
+            leftBool =
+                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+        }
+
+        llvm::BasicBlock *entryBlock = m_IRBuilder.GetInsertBlock();
+        m_IRBuilder.CreateCondBr(leftBool, mergeBlock, rhsBlock);
+
+        // RHS block - only now evaluate the right operand
+        m_IRBuilder.SetInsertPoint(rhsBlock);
+        node.right->Accept(*this);
+        llvm::Value *rightVal = m_LastValue;
+
+        if (!rightVal)
+        {
+            JLANG_ERROR("Invalid right operand in || expression");
             return;
         }
 
@@ -790,596 +2252,1465 @@ void CodeGenerator::VisitBinaryExpr(BinaryExpr &node)
             rightBool =
                 m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
         }
-        llvm::BasicBlock *rhsEndBlock = m_IRBuilder.GetInsertBlock();
-        m_IRBuilder.CreateBr(mergeBlock);
+        llvm::BasicBlock *rhsEndBlock = m_IRBuilder.GetInsertBlock();
+        m_IRBuilder.CreateBr(mergeBlock);
+
+        // Merge block
+        mergeBlock->insertInto(parentFunction);
+        m_IRBuilder.SetInsertPoint(mergeBlock);
+
+        llvm::PHINode *phi = m_IRBuilder.CreatePHI(llvm::Type::getInt1Ty(m_Context), 2, "or.result");
+        phi->addIncoming(llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1), entryBlock);
+        phi->addIncoming(rightBool, rhsEndBlock);
+
+        m_LastValue = phi;
+        return;
+    }
+
+    // All other binary operators evaluate both sides
+    node.left->Accept(*this);
+    llvm::Value *leftVal = m_LastValue;
+
+    node.right->Accept(*this);
+    llvm::Value *rightVal = m_LastValue;
+
+    if (!leftVal || !rightVal)
+    {
+        JLANG_ERROR("Invalid operands in binary expression");
+        return;
+    }
+
+    m_LastValue = EmitBinaryOperation(node.op, leftVal, rightVal, ResolvedTypeOf(node.left));
+}
+
+llvm::Value *CodeGenerator::EmitBinaryOperation(BinaryOp op, llvm::Value *leftVal, llvm::Value *rightVal,
+                                                const TypeRef &operandType)
+{
+    if (leftVal->getType()->isStructTy() || rightVal->getType()->isStructTy())
+    {
+        JLANG_ERROR("Structs and slices have no operators, use their fields");
+        return nullptr;
+    }
+
+    // Vector operations work lane by lane, a scalar operand is broadcast to every lane first
+    bool isVector = leftVal->getType()->isVectorTy() || rightVal->getType()->isVectorTy();
+    if (isVector)
+    {
+        switch (op)
+        {
+        case BinaryOp::Equal:
+        case BinaryOp::NotEqual:
+        case BinaryOp::Less:
+        case BinaryOp::LessEqual:
+        case BinaryOp::Greater:
+        case BinaryOp::GreaterEqual:
+        case BinaryOp::EagerAnd:
+        case BinaryOp::EagerOr:
+            JLANG_ERROR("Vectors only support arithmetic and bitwise operators");
+            return nullptr;
+        default:
+            break;
+        }
+
+        if (!leftVal->getType()->isVectorTy())
+        {
+            auto *vectorType = llvm::cast<llvm::FixedVectorType>(rightVal->getType());
+            leftVal = m_IRBuilder.CreateVectorSplat(vectorType->getNumElements(), leftVal, "splat");
+        }
+        else if (!rightVal->getType()->isVectorTy())
+        {
+            auto *vectorType = llvm::cast<llvm::FixedVectorType>(leftVal->getType());
+            rightVal = m_IRBuilder.CreateVectorSplat(vectorType->getNumElements(), rightVal, "splat");
+        }
+
+        if (leftVal->getType() != rightVal->getType())
+        {
+            JLANG_ERROR("Operands of a vector operation must have the same lane type and count");
+            return nullptr;
+        }
+    }
+
+    // LLVM integers carry no sign, so it comes from the jlang type (of the lanes, for vectors). Both
+    // operands were given the same type by the TypeAnnotator. Signed overflow is undefined as in C, which
+    // earns add/sub/mul the nsw flag; unsigned arithmetic wraps, so nuw is never set.
+    TypeRef laneType = operandType.IsVector() ? operandType.ElementType() : operandType;
+    bool isUnsigned = laneType.IsUnsignedInteger();
+    bool isSigned = laneType.IsSignedInteger();
+    bool isFloat = leftVal->getType()->isFPOrFPVectorTy();
+
+    llvm::Value *result = nullptr;
+    switch (op)
+    {
+    case BinaryOp::Equal:
+        if (leftVal->getType()->isPointerTy() && rightVal->getType()->isPointerTy())
+        {
+            result = m_IRBuilder.CreateICmpEQ(leftVal, rightVal, "ptreq");
+        }
+        else if (leftVal->getType()->isIntegerTy() && rightVal->getType()->isIntegerTy())
+        {
+            result = m_IRBuilder.CreateICmpEQ(leftVal, rightVal, "eq");
+        }
+        else if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpOEQ(leftVal, rightVal, "eq");
+        }
+        else
+        {
+            JLANG_ERROR("Unsupported types for == comparison");
+        }
+        break;
+    case BinaryOp::NotEqual:
+        if (leftVal->getType()->isPointerTy() && rightVal->getType()->isPointerTy())
+        {
+            result = m_IRBuilder.CreateICmpNE(leftVal, rightVal, "ptrne");
+        }
+        else if (leftVal->getType()->isIntegerTy() && rightVal->getType()->isIntegerTy())
+        {
+            result = m_IRBuilder.CreateICmpNE(leftVal, rightVal, "ne");
+        }
+        else if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpUNE(leftVal, rightVal, "ne");
+        }
+        else
+        {
+            JLANG_ERROR("Unsupported types for != comparison");
+        }
+        break;
+    case BinaryOp::Less:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpOLT(leftVal, rightVal, "lt");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateICmpULT(leftVal, rightVal, "lt");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateICmpSLT(leftVal, rightVal, "lt");
+        }
+        break;
+    case BinaryOp::LessEqual:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpOLE(leftVal, rightVal, "le");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateICmpULE(leftVal, rightVal, "le");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateICmpSLE(leftVal, rightVal, "le");
+        }
+        break;
+    case BinaryOp::Greater:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpOGT(leftVal, rightVal, "gt");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateICmpUGT(leftVal, rightVal, "gt");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateICmpSGT(leftVal, rightVal, "gt");
+        }
+        break;
+    case BinaryOp::GreaterEqual:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFCmpOGE(leftVal, rightVal, "ge");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateICmpUGE(leftVal, rightVal, "ge");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateICmpSGE(leftVal, rightVal, "ge");
+        }
+        break;
+    case BinaryOp::Add:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFAdd(leftVal, rightVal, "add");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateAdd(leftVal, rightVal, "add", false, isSigned);
+        }
+        break;
+    case BinaryOp::Sub:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFSub(leftVal, rightVal, "sub");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateSub(leftVal, rightVal, "sub", false, isSigned);
+        }
+        break;
+    case BinaryOp::Mul:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFMul(leftVal, rightVal, "mul");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateMul(leftVal, rightVal, "mul", false, isSigned);
+        }
+        break;
+    case BinaryOp::Div:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFDiv(leftVal, rightVal, "div");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateUDiv(leftVal, rightVal, "div");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateSDiv(leftVal, rightVal, "div");
+        }
+        break;
+    case BinaryOp::Mod:
+        if (isFloat)
+        {
+            result = m_IRBuilder.CreateFRem(leftVal, rightVal, "mod");
+        }
+        else if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateURem(leftVal, rightVal, "mod");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateSRem(leftVal, rightVal, "mod");
+        }
+        break;
+    case BinaryOp::BitAnd:
+        result = m_IRBuilder.CreateAnd(leftVal, rightVal, "bitand");
+        break;
+    case BinaryOp::BitOr:
+        result = m_IRBuilder.CreateOr(leftVal, rightVal, "bitor");
+        break;
+    case BinaryOp::BitXor:
+        result = m_IRBuilder.CreateXor(leftVal, rightVal, "bitxor");
+        break;
+    case BinaryOp::Shl:
+        result = m_IRBuilder.CreateShl(leftVal, rightVal, "shl");
+        break;
+    case BinaryOp::Shr:
+        if (isUnsigned)
+        {
+            result = m_IRBuilder.CreateLShr(leftVal, rightVal, "shr");
+        }
+        else
+        {
+            result = m_IRBuilder.CreateAShr(leftVal, rightVal, "shr");
+        }
+        break;
+    case BinaryOp::EagerAnd:
+    {
+        // Non-short-circuit AND: both operands are always evaluated
+        llvm::Value *leftBool = leftVal;
+        if (!leftVal->getType()->isIntegerTy(1))
+        {
+            leftBool =
+                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+        }
+
+        llvm::Value *rightBool = rightVal;
+        if (!rightVal->getType()->isIntegerTy(1))
+        {
+            rightBool =
+                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
+        }
 
-        // Merge block
-        mergeBlock->insertInto(parentFunction);
-        m_IRBuilder.SetInsertPoint(mergeBlock);
+        result = m_IRBuilder.CreateAnd(leftBool, rightBool, "and.result");
+        break;
+    }
+    case BinaryOp::EagerOr:
+    {
+        // Non-short-circuit OR: both operands are always evaluated
+        llvm::Value *leftBool = leftVal;
+        if (!leftVal->getType()->isIntegerTy(1))
+        {
+            leftBool =
+                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+        }
 
-        llvm::PHINode *phi = m_IRBuilder.CreatePHI(llvm::Type::getInt1Ty(m_Context), 2, "or.result");
-        phi->addIncoming(llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1), entryBlock);
-        phi->addIncoming(rightBool, rhsEndBlock);
+        llvm::Value *rightBool = rightVal;
+        if (!rightVal->getType()->isIntegerTy(1))
+        {
+            rightBool =
+                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
+        }
 
-        m_LastValue = phi;
-        return;
+        result = m_IRBuilder.CreateOr(leftBool, rightBool, "or.result");
+        break;
+    }
+    default:
+        JLANG_ERROR(STR("Unknown binary operator: %d", static_cast<int>(op)));
+        break;
     }
 
-    // All other binary operators evaluate both sides
-    node.left->Accept(*this);
-    llvm::Value *leftVal = m_LastValue;
+    return result;
+}
 
-    node.right->Accept(*this);
-    llvm::Value *rightVal = m_LastValue;
+void CodeGenerator::VisitUnaryExpr(UnaryExpr &node)
+{
+    node.operand->Accept(*this);
+    llvm::Value *operandVal = m_LastValue;
 
-    if (!leftVal || !rightVal)
+    if (!operandVal)
     {
-        JLANG_ERROR("Invalid operands in binary expression");
+        JLANG_ERROR("Invalid operand in unary expression");
         return;
     }
 
-    if (node.op == "==")
+    switch (node.op)
     {
-        if (leftVal->getType()->isPointerTy() && rightVal->getType()->isPointerTy())
+    case UnaryOp::Not:
+    {
+        // Logical NOT
+        llvm::Value *boolVal = operandVal;
+        if (!operandVal->getType()->isIntegerTy(1))
         {
-            m_LastValue = m_IRBuilder.CreateICmpEQ(leftVal, rightVal, "ptreq");
+            boolVal = m_IRBuilder.CreateICmpNE(operandVal, llvm::ConstantInt::get(operandVal->getType(), 0),
+                                               "tobool");
         }
-        else if (leftVal->getType()->isIntegerTy() && rightVal->getType()->isIntegerTy())
+        m_LastValue = m_IRBuilder.CreateXor(
+            boolVal, llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1), "not");
+        break;
+    }
+    case UnaryOp::BitNot:
+        // Bitwise NOT (flip all bits)
+        m_LastValue = m_IRBuilder.CreateNot(operandVal, "bitnot");
+        break;
+    default:
+        JLANG_ERROR(STR("Unknown unary operator: %d", static_cast<int>(node.op)));
+        break;
+    }
+}
+
+void CodeGenerator::VisitLiteralExpr(LiteralExpr &node)
+{
+    // Numeric literals and null take the type the TypeAnnotator picked from their context. A vector
+    // context gets the constant of the lane type splatted across all lanes.
+    const TypeRef &contextType = node.resolvedType;
+    TypeRef literalType = contextType.IsVector() ? contextType.ElementType() : contextType;
+
+    if (node.value == "NULL" || node.value == "null" || node.value == "nullptr")
+    {
+        llvm::Type *nullType = literalType.isPointer
+                                   ? MapType(literalType)
+                                   : llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(m_Context));
+        m_LastValue = llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(nullType));
+    }
+    else if (node.value == "true")
+    {
+        m_LastValue = llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1);
+    }
+    else if (node.value == "false")
+    {
+        m_LastValue = llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 0);
+    }
+    else if (node.value.front() == '"' && node.value.back() == '"')
+    {
+        // String literal
+        std::string strValue = node.value.substr(1, node.value.size() - 2);
+        m_LastValue = m_IRBuilder.CreateGlobalStringPtr(strValue, "str");
+    }
+    else if (node.value.front() == '\'' && node.value.back() == '\'')
+    {
+        // Character literal - extract the character and create an i8 constant
+        char charValue = node.value[1];
+        m_LastValue =
+            llvm::ConstantInt::get(llvm::Type::getInt8Ty(m_Context), static_cast<uint8_t>(charValue));
+    }
+    else if (node.value.find('.') != std::string::npos)
+    {
+        // Float literal
+        try
         {
-            m_LastValue = m_IRBuilder.CreateICmpEQ(leftVal, rightVal, "eq");
+            double floatValue = std::stod(node.value);
+            llvm::Type *floatType =
+                literalType.IsFloat() ? MapType(literalType) : llvm::Type::getDoubleTy(m_Context);
+            m_LastValue = llvm::ConstantFP::get(floatType, floatValue);
         }
-        else
+        catch (...)
         {
-            JLANG_ERROR("Unsupported types for == comparison");
+            JLANG_ERROR(STR("Invalid float literal: %s", node.value.c_str()));
+        }
+    }
+    else
+    {
+        // Integer literal
+        try
+        {
+            if (literalType.IsFloat())
+            {
+                m_LastValue = llvm::ConstantFP::get(MapType(literalType), std::stod(node.value));
+            }
+            else
+            {
+                // Parsed unsigned so that u64 literals above INT64_MAX survive
+                uint64_t intValue = std::stoull(node.value);
+                llvm::Type *intType =
+                    literalType.IsInteger() ? MapType(literalType) : llvm::Type::getInt32Ty(m_Context);
+                m_LastValue = llvm::ConstantInt::get(intType, intValue);
+            }
+        }
+        catch (...)
+        {
+            JLANG_ERROR(STR("Unknown literal: %s", node.value.c_str()));
         }
     }
-    else if (node.op == "!=")
+
+    if (contextType.IsVector() && llvm::isa_and_nonnull<llvm::Constant>(m_LastValue))
+    {
+        m_LastValue = llvm::ConstantVector::getSplat(llvm::ElementCount::getFixed(contextType.VectorLanes()),
+                                                     llvm::cast<llvm::Constant>(m_LastValue));
+    }
+}
+
+void CodeGenerator::VisitVarExpr(VarExpr &node)
+{
+    VariableInfo *variable = LookupVariable(node.name);
+
+    if (!variable)
+    {
+        JLANG_ERROR(STR("Undefined variable: %s", node.name.c_str()));
+        return;
+    }
+
+    // Mark variable as used
+    variable->used = true;
+
+    llvm::Value *storedValue = variable->value;
+
+    if (llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(storedValue))
+    {
+        m_LastValue = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, node.name);
+    }
+    else
+    {
+        m_LastValue = storedValue;
+    }
+}
+
+void CodeGenerator::VisitCastExpr(CastExpr &node)
+{
+    node.expr->Accept(*this);
+    llvm::Value *valueToCast = m_LastValue;
+
+    if (!valueToCast)
+    {
+        JLANG_ERROR("Invalid expression in cast");
+    }
+
+    llvm::Type *targetLLVMType = MapType(node.targetType);
+
+    if (!targetLLVMType)
+    {
+        JLANG_ERROR("Unknown target type in cast");
+    }
+
+    bool isPointerToPointerCast = valueToCast->getType()->isPointerTy() && targetLLVMType->isPointerTy();
+
+    if (isPointerToPointerCast)
+    {
+        m_LastValue = m_IRBuilder.CreateBitCast(valueToCast, targetLLVMType, "ptrcast");
+    }
+    else
+    {
+        JLANG_ERROR("Unsupported cast");
+    }
+}
+
+void CodeGenerator::VisitAllocExpr(AllocExpr &node)
+{
+    // Get malloc function
+    llvm::Function *mallocFunc = m_Module->getFunction("malloc");
+    if (!mallocFunc)
+    {
+        JLANG_ERROR("malloc not declared");
+        return;
+    }
+
+    // Calculate size based on the type being allocated
+    uint64_t allocSize = 8; // Default size
+    llvm::Align alignment = kMallocAlignment;
+
+    // Check if we're allocating a struct
+    auto structIt = m_structTypes.find(node.allocType.name);
+    if (structIt != m_structTypes.end())
+    {
+        // Get the size of the struct from LLVM's data layout
+        llvm::StructType *structType = structIt->second.llvmType;
+        const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+        allocSize = dataLayout.getTypeAllocSize(structType);
+        alignment = std::max(alignment, structIt->second.alignment);
+    }
+
+    llvm::Value *size = llvm::ConstantInt::get(llvm::Type::getInt64Ty(m_Context), allocSize);
+
+    llvm::CallInst *allocated = nullptr;
+    if (alignment > kMallocAlignment)
+    {
+        // void *aligned_alloc(size_t alignment, size_t size), the size of an #[align(N)] struct is a
+        // multiple of N as C11 asks for. The memory is released with free like any other.
+        llvm::FunctionCallee alignedAlloc = m_Module->getOrInsertFunction(
+            "aligned_alloc", mallocFunc->getReturnType(), m_IRBuilder.getInt64Ty(), m_IRBuilder.getInt64Ty());
+        llvm::Value *alignmentValue = m_IRBuilder.getInt64(alignment.value());
+        allocated = m_IRBuilder.CreateCall(alignedAlloc, {alignmentValue, size}, "alloc");
+    }
+    else
+    {
+        allocated = m_IRBuilder.CreateCall(mallocFunc, {size}, "alloc");
+    }
+
+    // Lets the optimizer use aligned vector loads and stores on the allocation
+    allocated->addRetAttr(llvm::Attribute::getWithAlignment(m_Context, alignment));
+
+    // Cast to the appropriate pointer type
+    llvm::Value *result = allocated;
+    llvm::Type *targetType = MapType(node.allocType);
+    if (result->getType() != targetType)
+    {
+        result = m_IRBuilder.CreateBitCast(result, targetType, "alloc_cast");
+    }
+
+    m_LastValue = result;
+}
+
+void CodeGenerator::VisitAssignExpr(AssignExpr &node)
+{
+    // Find the variable
+    VariableInfo *variable = LookupVariable(node.name);
+    if (!variable)
+    {
+        JLANG_ERROR(STR("Undefined variable in assignment: %s", node.name.c_str()));
+        return;
+    }
+
+    // Evaluate the right-hand side
+    llvm::Value *valueToStore = EmitValueFor(node.value, variable->type);
+
+    if (!valueToStore)
+    {
+        JLANG_ERROR("Invalid value in assignment");
+        return;
+    }
+
+    if (!variable->isMutable)
+    {
+        JLANG_ERROR(STR("Cannot assign to immutable variable '%s' (declared with 'val')", node.name.c_str()));
+        return;
+    }
+
+    // Null safety: cannot assign null to non-nullable pointer
+    if (variable->type.isPointer && !variable->type.isNullable &&
+        llvm::isa<llvm::ConstantPointerNull>(valueToStore))
+    {
+        JLANG_ERROR(STR("Cannot assign null to non-nullable variable '%s'.", node.name.c_str()));
+        return;
+    }
+
+    if (IsStructValue(variable->type) && valueToStore->getType() != MapType(variable->type))
+    {
+        JLANG_ERROR(STR("Cannot assign a value of another type to '%s' of type '%s'", node.name.c_str(),
+                        variable->type.Spelling().c_str()));
+        return;
+    }
+
+    llvm::Value *targetVar = variable->value;
+
+    if (llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(targetVar))
+    {
+        m_IRBuilder.CreateStore(valueToStore, alloca);
+        m_LastValue = valueToStore;
+    }
+    else
+    {
+        JLANG_ERROR("Cannot assign to non-variable");
+    }
+}
+
+void CodeGenerator::VisitMemberAccessExpr(MemberAccessExpr &node)
+{
+    TypeRef objectType = ResolvedTypeOf(node.object);
+    bool isSoaColumn = IsSoaArray(objectType) && node.memberName != "len";
+
+    if ((objectType.IsArray() || objectType.isSlice) && !isSoaColumn)
     {
-        if (leftVal->getType()->isPointerTy() && rightVal->getType()->isPointerTy())
+        if (node.memberName != "len")
         {
-            m_LastValue = m_IRBuilder.CreateICmpNE(leftVal, rightVal, "ptrne");
+            JLANG_ERROR(
+                STR("Unknown member '%s', arrays and slices only have 'len'", node.memberName.c_str()));
+            return;
         }
-        else if (leftVal->getType()->isIntegerTy() && rightVal->getType()->isIntegerTy())
+
+        if (objectType.IsArray())
         {
-            m_LastValue = m_IRBuilder.CreateICmpNE(leftVal, rightVal, "ne");
+            // Known at compile time, the address is only taken to validate the operand
+            if (!EmitArrayAddress(node.object))
+            {
+                return;
+            }
+            m_LastValue = m_IRBuilder.getInt64(objectType.arraySize);
         }
         else
         {
-            JLANG_ERROR("Unsupported types for != comparison");
+            node.object->Accept(*this);
+            m_LastValue = m_LastValue ? m_IRBuilder.CreateExtractValue(m_LastValue, 1, "len") : nullptr;
         }
+        return;
     }
-    else if (node.op == "<")
-    {
-        m_LastValue = m_IRBuilder.CreateICmpSLT(leftVal, rightVal, "lt");
-    }
-    else if (node.op == "<=")
+
+    TypeRef fieldType;
+    llvm::Value *fieldPtr = EmitMemberAddress(node, fieldType);
+    if (!fieldPtr)
     {
-        m_LastValue = m_IRBuilder.CreateICmpSLE(leftVal, rightVal, "le");
+        return;
     }
-    else if (node.op == ">")
+
+    llvm::Type *llvmFieldType = MapType(fieldType);
+    llvm::Align alignment = AccessAlignment(&node, llvmFieldType);
+    m_LastValue = m_IRBuilder.CreateAlignedLoad(llvmFieldType, fieldPtr, alignment, node.memberName);
+}
+
+// A #[soa] array has no element in one piece to load, store or point to
+static bool CheckNotSoaElement(bool isSoaArray)
+{
+    if (isSoaArray)
     {
-        m_LastValue = m_IRBuilder.CreateICmpSGT(leftVal, rightVal, "gt");
+        JLANG_ERROR("The fields of a #[soa] array element are stored apart, access them one by one: "
+                    "a[i].Field");
     }
-    else if (node.op == ">=")
+    return !isSoaArray;
+}
+
+llvm::Value *CodeGenerator::EmitMemberAddress(MemberAccessExpr &node, TypeRef &fieldType)
+{
+    auto *element = dynamic_cast<IndexExpr *>(node.object);
+    if (IsSoaArray(ResolvedTypeOf(element ? element->object : node.object)))
     {
-        m_LastValue = m_IRBuilder.CreateICmpSGE(leftVal, rightVal, "ge");
+        return EmitSoaAddress(node, fieldType);
     }
-    else if (node.op == "+")
+
+    // The object is a pointer to a struct, or a struct value whose storage is used in place
+    TypeRef objectType = ResolvedTypeOf(node.object);
+    if (auto *varExpr = dynamic_cast<VarExpr *>(node.object))
     {
-        m_LastValue = m_IRBuilder.CreateAdd(leftVal, rightVal, "add");
+        VariableInfo *variable = LookupVariable(varExpr->name);
+        objectType = variable ? variable->type : objectType;
     }
-    else if (node.op == "-")
+
+    // Null safety: cannot access member on nullable pointer
+    if (objectType.isNullable)
     {
-        m_LastValue = m_IRBuilder.CreateSub(leftVal, rightVal, "sub");
+        JLANG_ERROR(STR("Cannot access member '%s' on nullable type '%s*?'. Check for null first.",
+                        node.memberName.c_str(), objectType.name.c_str()));
+        return nullptr;
     }
-    else if (node.op == "*")
+
+    if (!objectType.isPointer && !IsStructValue(objectType))
     {
-        m_LastValue = m_IRBuilder.CreateMul(leftVal, rightVal, "mul");
+        JLANG_ERROR(STR("Cannot access member '%s' of a '%s'", node.memberName.c_str(),
+                        objectType.Spelling().c_str()));
+        return nullptr;
     }
-    else if (node.op == "/")
+
+    llvm::Value *objectPtr = nullptr;
+    if (IsStructValue(objectType))
     {
-        m_LastValue = m_IRBuilder.CreateSDiv(leftVal, rightVal, "div");
+        objectPtr = EmitStructAddress(node.object);
     }
-    else if (node.op == "%")
+    else
     {
-        m_LastValue = m_IRBuilder.CreateSRem(leftVal, rightVal, "mod");
+        node.object->Accept(*this);
+        objectPtr = m_LastValue;
     }
-    else if (node.op == "&")
+
+    if (!objectPtr)
     {
-        m_LastValue = m_IRBuilder.CreateAnd(leftVal, rightVal, "bitand");
+        JLANG_ERROR("Invalid object in member access");
+        return nullptr;
     }
-    else if (node.op == "|")
+
+    const std::string &structTypeName = objectType.name;
+
+    const FieldInfo *fieldInfo = LookupField(structTypeName, node.memberName);
+    if (!fieldInfo)
     {
-        m_LastValue = m_IRBuilder.CreateOr(leftVal, rightVal, "bitor");
+        return nullptr;
     }
-    else if (node.op == "^")
+
+    // Generate GEP to access the field
+    fieldType = fieldInfo->type;
+    return m_IRBuilder.CreateStructGEP(m_structTypes.at(structTypeName).llvmType, objectPtr, fieldInfo->index,
+                                       node.memberName + "_ptr");
+}
+
+const CodeGenerator::FieldInfo *CodeGenerator::LookupField(const std::string &structName,
+                                                           const std::string &fieldName)
+{
+    // Find the struct info
+    auto structIt = m_structTypes.find(structName);
+    if (structIt == m_structTypes.end())
     {
-        m_LastValue = m_IRBuilder.CreateXor(leftVal, rightVal, "bitxor");
+        JLANG_ERROR(STR("Unknown struct type: %s", structName.c_str()));
+        return nullptr;
     }
-    else if (node.op == "<<")
+
+    // Find the field
+    auto fieldIt = structIt->second.fields.find(fieldName);
+    if (fieldIt == structIt->second.fields.end())
     {
-        m_LastValue = m_IRBuilder.CreateShl(leftVal, rightVal, "shl");
+        JLANG_ERROR(STR("Unknown field '%s' in struct '%s'", fieldName.c_str(), structName.c_str()));
+        return nullptr;
     }
-    else if (node.op == ">>")
+
+    // Check visibility - private fields (lowercase) can only be accessed from within the struct's methods
+    // For now, we'll allow all access but emit a warning for private fields
+    // A proper implementation would track the current context
+    if (!fieldIt->second.isPublic)
     {
-        m_LastValue = m_IRBuilder.CreateAShr(leftVal, rightVal, "shr");
+        JLANG_ERROR(
+            STR("Cannot access private field '%s' in struct '%s'", fieldName.c_str(), structName.c_str()));
+        return nullptr;
     }
-    else if (node.op == "and")
+
+    return &fieldIt->second;
+}
+
+bool CodeGenerator::IsStructValue(const TypeRef &typeRef) const
+{
+    return !typeRef.isPointer && !typeRef.isSlice && !typeRef.IsArray() &&
+           m_structTypes.find(typeRef.name) != m_structTypes.end();
+}
+
+llvm::Value *CodeGenerator::EmitStructAddress(AstNode *node)
+{
+    if (auto *varExpr = dynamic_cast<VarExpr *>(node))
     {
-        // Non-short-circuit AND: both operands are always evaluated
-        llvm::Value *leftBool = leftVal;
-        if (!leftVal->getType()->isIntegerTy(1))
+        VariableInfo *variable = LookupVariable(varExpr->name);
+        if (!variable)
         {
-            leftBool =
-                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
+            JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
+            return nullptr;
         }
 
-        llvm::Value *rightBool = rightVal;
-        if (!rightVal->getType()->isIntegerTy(1))
-        {
-            rightBool =
-                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
-        }
+        variable->used = true;
+        return variable->value;
+    }
 
-        m_LastValue = m_IRBuilder.CreateAnd(leftBool, rightBool, "and.result");
+    if (auto *memberAccess = dynamic_cast<MemberAccessExpr *>(node))
+    {
+        TypeRef fieldType;
+        return EmitMemberAddress(*memberAccess, fieldType);
     }
-    else if (node.op == "or")
+
+    if (auto *index = dynamic_cast<IndexExpr *>(node))
     {
-        // Non-short-circuit OR: both operands are always evaluated
-        llvm::Value *leftBool = leftVal;
-        if (!leftVal->getType()->isIntegerTy(1))
-        {
-            leftBool =
-                m_IRBuilder.CreateICmpNE(leftVal, llvm::ConstantInt::get(leftVal->getType(), 0), "tobool");
-        }
+        return CheckNotSoaElement(IsSoaArray(ResolvedTypeOf(index->object)))
+                   ? EmitElementAddress(index->object, index->index)
+                   : nullptr;
+    }
 
-        llvm::Value *rightBool = rightVal;
-        if (!rightVal->getType()->isIntegerTy(1))
+    // A call result or a literal has no storage of its own, it gets a temporary
+    node->Accept(*this);
+    if (!m_LastValue)
+    {
+        return nullptr;
+    }
+
+    TypeRef type = ResolvedTypeOf(node);
+    llvm::AllocaInst *temporary =
+        CreateEntryBlockAlloca(m_LastValue->getType(), "tmp", TypeAlignment(type, m_LastValue->getType()));
+    m_IRBuilder.CreateStore(m_LastValue, temporary);
+    return temporary;
+}
+
+bool CodeGenerator::IsSoaArray(const TypeRef &typeRef) const
+{
+    if (!typeRef.IsArray() || typeRef.isPointer)
+    {
+        return false;
+    }
+
+    auto structIt = m_structTypes.find(typeRef.name);
+    return structIt != m_structTypes.end() && structIt->second.isSoa;
+}
+
+llvm::Value *CodeGenerator::EmitSoaAddress(MemberAccessExpr &node, TypeRef &fieldType)
+{
+    auto *element = dynamic_cast<IndexExpr *>(node.object);
+    AstNode *arrayNode = element ? element->object : node.object;
+    TypeRef arrayType = ResolvedTypeOf(arrayNode);
+
+    const FieldInfo *fieldInfo = LookupField(arrayType.name, node.memberName);
+    llvm::Value *base = fieldInfo ? EmitArrayAddress(arrayNode) : nullptr;
+    if (!base)
+    {
+        return nullptr;
+    }
+
+    std::vector<llvm::Value *> indices = {m_IRBuilder.getInt64(0), m_IRBuilder.getInt32(fieldInfo->column)};
+    fieldType = fieldInfo->type;
+
+    if (element)
+    {
+        llvm::Value *index = EmitIndex(element->index);
+        if (!index)
         {
-            rightBool =
-                m_IRBuilder.CreateICmpNE(rightVal, llvm::ConstantInt::get(rightVal->getType(), 0), "tobool");
+            return nullptr;
         }
-
-        m_LastValue = m_IRBuilder.CreateOr(leftBool, rightBool, "or.result");
+        indices.push_back(index);
     }
     else
     {
-        JLANG_ERROR(STR("Unknown binary operator: %s", node.op.c_str()));
+        fieldType.arraySize = arrayType.arraySize;
     }
+
+    // Indexing past the end is undefined, as for any array
+    return m_IRBuilder.CreateInBoundsGEP(MapType(arrayType), base, indices,
+                                         node.memberName + (element ? "_ptr" : "_column"));
 }
 
-void CodeGenerator::VisitUnaryExpr(UnaryExpr &node)
+void CodeGenerator::VisitPrefixExpr(PrefixExpr &node)
 {
-    node.operand->Accept(*this);
-    llvm::Value *operandVal = m_LastValue;
+    // Prefix ++/--: increment/decrement and return the NEW value
+    auto *varExpr = dynamic_cast<VarExpr *>(node.operand);
+    if (!varExpr)
+    {
+        JLANG_ERROR("Prefix increment/decrement requires a variable operand");
+        return;
+    }
 
-    if (!operandVal)
+    VariableInfo *variable = LookupVariable(varExpr->name);
+    if (!variable)
     {
-        JLANG_ERROR("Invalid operand in unary expression");
+        JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
         return;
     }
 
-    if (node.op == "!")
+    if (!variable->isMutable)
     {
-        // Logical NOT
-        llvm::Value *boolVal = operandVal;
-        if (!operandVal->getType()->isIntegerTy(1))
-        {
-            boolVal = m_IRBuilder.CreateICmpNE(operandVal, llvm::ConstantInt::get(operandVal->getType(), 0),
-                                               "tobool");
-        }
-        m_LastValue = m_IRBuilder.CreateXor(
-            boolVal, llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1), "not");
+        JLANG_ERROR(
+            STR("Cannot modify immutable variable '%s' (declared with 'val')", varExpr->name.c_str()));
+        return;
     }
-    else if (node.op == "~")
+
+    // Mark variable as used
+    variable->used = true;
+
+    llvm::Value *varPtr = variable->value;
+    llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(varPtr);
+    if (!alloca)
     {
-        // Bitwise NOT (flip all bits)
-        m_LastValue = m_IRBuilder.CreateNot(operandVal, "bitnot");
+        JLANG_ERROR("Cannot increment/decrement non-variable");
+        return;
+    }
+
+    // Load current value
+    llvm::Value *currentVal = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, "load");
+
+    // Add or subtract 1
+    llvm::Value *one = llvm::ConstantInt::get(currentVal->getType(), 1);
+    bool isSigned = variable->type.IsSignedInteger();
+    llvm::Value *newVal;
+    if (node.op == UnaryOp::Increment)
+    {
+        newVal = m_IRBuilder.CreateAdd(currentVal, one, "inc", false, isSigned);
     }
     else
     {
-        JLANG_ERROR(STR("Unknown unary operator: %s", node.op.c_str()));
+        newVal = m_IRBuilder.CreateSub(currentVal, one, "dec", false, isSigned);
     }
+
+    // Store new value back
+    m_IRBuilder.CreateStore(newVal, alloca);
+
+    // Return the NEW value
+    m_LastValue = newVal;
 }
 
-void CodeGenerator::VisitLiteralExpr(LiteralExpr &node)
+void CodeGenerator::VisitPostfixExpr(PostfixExpr &node)
 {
-    if (node.value == "NULL" || node.value == "null" || node.value == "nullptr")
+    // Postfix ++/--: increment/decrement and return the ORIGINAL value
+    auto *varExpr = dynamic_cast<VarExpr *>(node.operand);
+    if (!varExpr)
     {
-        m_LastValue =
-            llvm::ConstantPointerNull::get(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(m_Context)));
+        JLANG_ERROR("Postfix increment/decrement requires a variable operand");
+        return;
     }
-    else if (node.value == "true")
+
+    VariableInfo *variable = LookupVariable(varExpr->name);
+    if (!variable)
     {
-        m_LastValue = llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 1);
+        JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
+        return;
     }
-    else if (node.value == "false")
+
+    if (!variable->isMutable)
     {
-        m_LastValue = llvm::ConstantInt::get(llvm::Type::getInt1Ty(m_Context), 0);
+        JLANG_ERROR(
+            STR("Cannot modify immutable variable '%s' (declared with 'val')", varExpr->name.c_str()));
+        return;
     }
-    else if (node.value.front() == '"' && node.value.back() == '"')
+
+    // Mark variable as used
+    variable->used = true;
+
+    llvm::Value *varPtr = variable->value;
+    llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(varPtr);
+    if (!alloca)
     {
-        // String literal
-        std::string strValue = node.value.substr(1, node.value.size() - 2);
-        m_LastValue = m_IRBuilder.CreateGlobalStringPtr(strValue, "str");
+        JLANG_ERROR("Cannot increment/decrement non-variable");
+        return;
     }
-    else if (node.value.front() == '\'' && node.value.back() == '\'')
+
+    // Load current value
+    llvm::Value *currentVal = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, "load");
+
+    // Add or subtract 1
+    llvm::Value *one = llvm::ConstantInt::get(currentVal->getType(), 1);
+    bool isSigned = variable->type.IsSignedInteger();
+    llvm::Value *newVal;
+    if (node.op == UnaryOp::Increment)
     {
-        // Character literal - extract the character and create an i8 constant
-        char charValue = node.value[1];
-        m_LastValue =
-            llvm::ConstantInt::get(llvm::Type::getInt8Ty(m_Context), static_cast<uint8_t>(charValue));
+        newVal = m_IRBuilder.CreateAdd(currentVal, one, "inc", false, isSigned);
     }
-    else if (node.value.find('.') != std::string::npos)
+    else
     {
-        // Float literal
-        try
+        newVal = m_IRBuilder.CreateSub(currentVal, one, "dec", false, isSigned);
+    }
+
+    // Store new value back
+    m_IRBuilder.CreateStore(newVal, alloca);
+
+    // Return the ORIGINAL value
+    m_LastValue = currentVal;
+}
+
+void CodeGenerator::VisitIndexExpr(IndexExpr &node)
+{
+    if (!CheckNotSoaElement(IsSoaArray(ResolvedTypeOf(node.object))))
+    {
+        m_LastValue = nullptr;
+        return;
+    }
+
+    if (ResolvedTypeOf(node.object).IsVector())
+    {
+        node.object->Accept(*this);
+        llvm::Value *vector = m_LastValue;
+        llvm::Value *lane = vector ? EmitLaneIndex(node) : nullptr;
+        m_LastValue = lane ? m_IRBuilder.CreateExtractElement(vector, lane, "lane") : nullptr;
+        return;
+    }
+
+    llvm::Value *elementPtr = EmitElementAddress(node.object, node.index);
+    if (!elementPtr)
+    {
+        m_LastValue = nullptr;
+        return;
+    }
+
+    llvm::Type *elementType = MapType(node.resolvedType);
+    m_LastValue =
+        m_IRBuilder.CreateAlignedLoad(elementType, elementPtr, AccessAlignment(&node, elementType), "elem");
+}
+
+void CodeGenerator::VisitIndexAssignExpr(IndexAssignExpr &node)
+{
+    if (!CheckNotSoaElement(IsSoaArray(ResolvedTypeOf(node.target->object))))
+    {
+        return;
+    }
+
+    if (auto *varExpr = dynamic_cast<VarExpr *>(node.target->object))
+    {
+        VariableInfo *variable = LookupVariable(varExpr->name);
+        if (variable && !variable->isMutable && (variable->type.IsArray() || variable->type.IsVector()))
         {
-            double floatValue = std::stod(node.value);
-            // Default to f64 (double) for now
-            m_LastValue = llvm::ConstantFP::get(llvm::Type::getDoubleTy(m_Context), floatValue);
+            const char *kind = variable->type.IsArray() ? "array" : "vector";
+            JLANG_ERROR(STR("Cannot assign to an element of immutable %s '%s' (declared with 'val')", kind,
+                            varExpr->name.c_str()));
+            return;
         }
-        catch (...)
+    }
+
+    // A compound assignment evaluates its operand only after it has read the element
+    llvm::Value *valueToStore = nullptr;
+    if (!node.compoundOp)
+    {
+        node.value->Accept(*this);
+        valueToStore = m_LastValue;
+
+        if (!valueToStore)
         {
-            JLANG_ERROR(STR("Invalid float literal: %s", node.value.c_str()));
+            JLANG_ERROR("Invalid value in assignment");
+            return;
         }
     }
-    else
+
+    TypeRef elementType = ResolvedTypeOf(node.target);
+
+    if (ResolvedTypeOf(node.target->object).IsVector())
     {
-        // Integer literal
-        try
+        // Vectors are values, a lane is replaced by rewriting the whole vector in its variable
+        llvm::Value *vectorPtr = EmitArrayAddress(node.target->object);
+        if (vectorPtr && !vectorPtr->getType()->isPointerTy())
         {
-            int64_t intValue = std::stoll(node.value);
-            m_LastValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_Context), intValue);
+            JLANG_ERROR("Lanes can only be assigned in a local variable or a struct field");
+            return;
         }
-        catch (...)
+
+        llvm::Value *lane = vectorPtr ? EmitLaneIndex(*node.target) : nullptr;
+        if (!lane)
         {
-            JLANG_ERROR(STR("Unknown literal: %s", node.value.c_str()));
+            return;
         }
+
+        llvm::Type *vectorType = MapType(ResolvedTypeOf(node.target->object));
+        llvm::Align alignment = AccessAlignment(node.target->object, vectorType);
+        llvm::Value *vector = m_IRBuilder.CreateAlignedLoad(vectorType, vectorPtr, alignment, "vec");
+        if (node.compoundOp)
+        {
+            llvm::Value *current = m_IRBuilder.CreateExtractElement(vector, lane, "lane");
+            valueToStore = EmitCompoundValue(*node.compoundOp, current, node.value, elementType);
+            if (!valueToStore)
+            {
+                return;
+            }
+        }
+        vector = m_IRBuilder.CreateInsertElement(vector, valueToStore, lane, "vec");
+        m_IRBuilder.CreateAlignedStore(vector, vectorPtr, alignment);
+        m_LastValue = valueToStore;
+        return;
     }
-}
-
-void CodeGenerator::VisitVarExpr(VarExpr &node)
-{
-    auto it = m_variables.find(node.name);
 
-    if (it == m_variables.end())
+    llvm::Value *elementPtr = EmitElementAddress(node.target->object, node.target->index);
+    if (!elementPtr)
     {
-        JLANG_ERROR(STR("Undefined variable: %s", node.name.c_str()));
         return;
     }
 
-    // Mark variable as used
-    it->second.used = true;
-
-    llvm::Value *storedValue = it->second.value;
-
-    if (llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(storedValue))
-    {
-        m_LastValue = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, node.name);
-    }
-    else
+    if (node.compoundOp)
     {
-        m_LastValue = storedValue;
+        llvm::Type *llvmElementType = MapType(elementType);
+        llvm::Value *current = m_IRBuilder.CreateAlignedLoad(
+            llvmElementType, elementPtr, AccessAlignment(node.target, llvmElementType), "elem");
+        valueToStore = EmitCompoundValue(*node.compoundOp, current, node.value, elementType);
+        if (!valueToStore)
+        {
+            return;
+        }
     }
+
+    m_IRBuilder.CreateAlignedStore(valueToStore, elementPtr,
+                                   AccessAlignment(node.target, valueToStore->getType()));
+    m_LastValue = valueToStore;
 }
 
-void CodeGenerator::VisitCastExpr(CastExpr &node)
+llvm::Value *CodeGenerator::EmitCompoundValue(BinaryOp op, llvm::Value *current, AstNode *operand,
+                                              const TypeRef &type)
 {
-    node.expr->Accept(*this);
-    llvm::Value *valueToCast = m_LastValue;
+    if (!current->getType()->isIntOrIntVectorTy() && !current->getType()->isFPOrFPVectorTy())
+    {
+        JLANG_ERROR(
+            STR("Compound assignment needs a number or a vector, not a '%s'", type.Spelling().c_str()));
+        return nullptr;
+    }
 
-    if (!valueToCast)
+    operand->Accept(*this);
+    llvm::Value *operandVal = m_LastValue;
+    if (!operandVal)
     {
-        JLANG_ERROR("Invalid expression in cast");
+        JLANG_ERROR("Invalid value in assignment");
+        return nullptr;
     }
 
-    llvm::Type *targetLLVMType = MapType(node.targetType);
+    return EmitBinaryOperation(op, current, operandVal, type);
+}
 
-    if (!targetLLVMType)
+void CodeGenerator::VisitMemberAssignExpr(MemberAssignExpr &node)
+{
+    // The fields of a struct value are part of its variable, p.Start.X changes p
+    AstNode *root = node.target->object;
+    while (auto *member = dynamic_cast<MemberAccessExpr *>(root))
     {
-        JLANG_ERROR("Unknown target type in cast");
+        if (!IsStructValue(ResolvedTypeOf(member->object)))
+        {
+            break;
+        }
+        root = member->object;
     }
 
-    bool isPointerToPointerCast = valueToCast->getType()->isPointerTy() && targetLLVMType->isPointerTy();
-
-    if (isPointerToPointerCast)
+    if (auto *varExpr = dynamic_cast<VarExpr *>(root))
     {
-        m_LastValue = m_IRBuilder.CreateBitCast(valueToCast, targetLLVMType, "ptrcast");
+        VariableInfo *variable = LookupVariable(varExpr->name);
+        if (variable && !variable->isMutable && IsStructValue(variable->type))
+        {
+            JLANG_ERROR(STR("Cannot assign to a field of immutable struct '%s' (declared with 'val')",
+                            varExpr->name.c_str()));
+            return;
+        }
     }
-    else
+
+    // A compound assignment evaluates its operand only after it has read the field
+    llvm::Value *valueToStore = nullptr;
+    if (!node.compoundOp)
     {
-        JLANG_ERROR("Unsupported cast");
+        node.value->Accept(*this);
+        valueToStore = m_LastValue;
+
+        if (!valueToStore)
+        {
+            JLANG_ERROR("Invalid value in assignment");
+            return;
+        }
     }
-}
 
-void CodeGenerator::VisitAllocExpr(AllocExpr &node)
-{
-    // Get malloc function
-    llvm::Function *mallocFunc = m_Module->getFunction("malloc");
-    if (!mallocFunc)
+    TypeRef fieldType;
+    llvm::Value *fieldPtr = EmitMemberAddress(*node.target, fieldType);
+    if (!fieldPtr)
     {
-        JLANG_ERROR("malloc not declared");
         return;
     }
 
-    // Calculate size based on the type being allocated
-    uint64_t allocSize = 8; // Default size
-
-    // Check if we're allocating a struct
-    auto structIt = m_structTypes.find(node.allocType.name);
-    if (structIt != m_structTypes.end())
+    if (node.compoundOp)
     {
-        // Get the size of the struct from LLVM's data layout
-        llvm::StructType *structType = structIt->second.llvmType;
-        const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
-        allocSize = dataLayout.getTypeAllocSize(structType);
+        llvm::Type *llvmFieldType = MapType(fieldType);
+        llvm::Value *current = m_IRBuilder.CreateAlignedLoad(
+            llvmFieldType, fieldPtr, AccessAlignment(node.target, llvmFieldType), "field");
+        valueToStore = EmitCompoundValue(*node.compoundOp, current, node.value, fieldType);
+        if (!valueToStore)
+        {
+            return;
+        }
     }
 
-    llvm::Value *size = llvm::ConstantInt::get(llvm::Type::getInt64Ty(m_Context), allocSize);
-
-    // Call malloc
-    llvm::Value *allocated = m_IRBuilder.CreateCall(mallocFunc, {size}, "alloc");
-
-    // Cast to the appropriate pointer type
-    llvm::Type *targetType = MapType(node.allocType);
-    if (allocated->getType() != targetType)
+    if (valueToStore->getType() != MapType(fieldType))
     {
-        allocated = m_IRBuilder.CreateBitCast(allocated, targetType, "alloc_cast");
+        JLANG_ERROR(STR("Cannot assign to field '%s' of type '%s', the value has another type",
+                        node.target->memberName.c_str(), fieldType.Spelling().c_str()));
+        return;
     }
 
-    m_LastValue = allocated;
+    m_IRBuilder.CreateAlignedStore(valueToStore, fieldPtr,
+                                   AccessAlignment(node.target, valueToStore->getType()));
+    m_LastValue = valueToStore;
 }
 
-void CodeGenerator::VisitAssignExpr(AssignExpr &node)
+void CodeGenerator::VisitStructLiteralExpr(StructLiteralExpr &node)
 {
-    // Evaluate the right-hand side
-    node.value->Accept(*this);
-    llvm::Value *valueToStore = m_LastValue;
+    m_LastValue = EmitStructLiteral(node);
+}
 
-    if (!valueToStore)
+llvm::Value *CodeGenerator::EmitStructLiteral(StructLiteralExpr &node)
+{
+    auto structIt = m_structTypes.find(node.structName);
+    if (structIt == m_structTypes.end())
     {
-        JLANG_ERROR("Invalid value in assignment");
-        return;
+        JLANG_ERROR(STR("Unknown struct type in literal: %s", node.structName.c_str()));
+        return nullptr;
     }
 
-    // Find the variable
-    auto it = m_variables.find(node.name);
-    if (it == m_variables.end())
-    {
-        JLANG_ERROR(STR("Undefined variable in assignment: %s", node.name.c_str()));
-        return;
-    }
+    // Fields left out are zero, padding included
+    llvm::Value *value = llvm::Constant::getNullValue(structIt->second.llvmType);
+    std::unordered_set<std::string> initialized;
 
-    if (!it->second.isMutable)
+    for (const FieldInitializer &field : node.fields)
     {
-        JLANG_ERROR(STR("Cannot assign to immutable variable '%s' (declared with 'val')", node.name.c_str()));
-        return;
-    }
+        if (!initialized.insert(field.name).second)
+        {
+            JLANG_ERROR(STR("Field '%s' is given twice in a '%s' literal", field.name.c_str(),
+                            node.structName.c_str()));
+            return nullptr;
+        }
 
-    // Null safety: cannot assign null to non-nullable pointer
-    if (it->second.type.isPointer && !it->second.type.isNullable &&
-        llvm::isa<llvm::ConstantPointerNull>(valueToStore))
-    {
-        JLANG_ERROR(STR("Cannot assign null to non-nullable variable '%s'.", node.name.c_str()));
-        return;
+        const FieldInfo *fieldInfo = LookupField(node.structName, field.name);
+        llvm::Value *fieldValue = fieldInfo ? EmitValueFor(field.value, fieldInfo->type) : nullptr;
+        if (!fieldValue)
+        {
+            return nullptr;
+        }
+
+        llvm::Type *fieldType = MapType(fieldInfo->type);
+        bool isPointerField = fieldValue->getType()->isPointerTy() && fieldType->isPointerTy();
+        if (fieldValue->getType() != fieldType && isPointerField)
+        {
+            fieldValue = m_IRBuilder.CreateBitCast(fieldValue, fieldType, "cast");
+        }
+
+        if (fieldValue->getType() != fieldType)
+        {
+            JLANG_ERROR(STR("Field '%s' of '%s' is a '%s', the value has another type", field.name.c_str(),
+                            node.structName.c_str(), fieldInfo->type.Spelling().c_str()));
+            return nullptr;
+        }
+
+        value = m_IRBuilder.CreateInsertValue(value, fieldValue, fieldInfo->index, node.structName);
     }
 
-    llvm::Value *targetVar = it->second.value;
+    return value;
+}
 
-    if (llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(targetVar))
+llvm::Value *CodeGenerator::EmitArrayAddress(AstNode *node)
+{
+    if (auto *varExpr = dynamic_cast<VarExpr *>(node))
     {
-        m_IRBuilder.CreateStore(valueToStore, alloca);
-        m_LastValue = valueToStore;
+        VariableInfo *variable = LookupVariable(varExpr->name);
+        if (!variable)
+        {
+            JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
+            return nullptr;
+        }
+
+        variable->used = true;
+        return variable->value;
     }
-    else
+
+    if (auto *memberAccess = dynamic_cast<MemberAccessExpr *>(node))
     {
-        JLANG_ERROR("Cannot assign to non-variable");
+        TypeRef fieldType;
+        return EmitMemberAddress(*memberAccess, fieldType);
     }
+
+    JLANG_ERROR("Arrays can only be accessed through a variable or a struct field");
+    return nullptr;
 }
 
-void CodeGenerator::VisitMemberAccessExpr(MemberAccessExpr &node)
+llvm::Value *CodeGenerator::EmitElementAddress(AstNode *object, AstNode *indexNode)
 {
-    // Get the object (should be a pointer to a struct)
-    node.object->Accept(*this);
-    llvm::Value *objectPtr = m_LastValue;
+    TypeRef objectType = ResolvedTypeOf(object);
 
-    if (!objectPtr)
+    llvm::Value *base = nullptr;
+    if (objectType.IsArray())
     {
-        JLANG_ERROR("Invalid object in member access");
-        return;
+        base = EmitArrayAddress(object);
     }
-
-    // Determine the struct type from the object
-    // We need to trace back to find the struct type
-    std::string structTypeName;
-
-    // If the object is a VarExpr, look up its type
-    if (auto *varExpr = dynamic_cast<VarExpr *>(node.object.get()))
+    else if (objectType.isSlice || objectType.isPointer)
     {
-        auto typeIt = m_variables.find(varExpr->name);
-        if (typeIt != m_variables.end())
-        {
-            // Null safety: cannot access member on nullable pointer
-            if (typeIt->second.type.isNullable)
-            {
-                JLANG_ERROR(STR("Cannot access member '%s' on nullable type '%s*?'. Check for null first.",
-                                node.memberName.c_str(), typeIt->second.type.name.c_str()));
-                return;
-            }
+        // A base that fails to lower must not leave the value of an earlier expression behind
+        m_LastValue = nullptr;
+        object->Accept(*this);
+        base = m_LastValue;
 
-            structTypeName = typeIt->second.type.name;
+        bool isAddressable = base && (objectType.isSlice ? base->getType()->isStructTy()
+                                                         : base->getType()->isPointerTy());
+        if (base && !isAddressable)
+        {
+            JLANG_ERROR("Only arrays, slices and pointers can be indexed");
+            return nullptr;
         }
     }
-
-    if (structTypeName.empty())
+    else
     {
-        JLANG_ERROR("Cannot determine struct type for member access");
-        return;
+        JLANG_ERROR("Only arrays, slices and pointers can be indexed");
+        return nullptr;
     }
 
-    // Find the struct info
-    auto structIt = m_structTypes.find(structTypeName);
-    if (structIt == m_structTypes.end())
+    if (!base)
     {
-        JLANG_ERROR(STR("Unknown struct type: %s", structTypeName.c_str()));
-        return;
+        return nullptr;
     }
 
-    const StructInfo &structInfo = structIt->second;
-
-    // Find the field
-    auto fieldIt = structInfo.fields.find(node.memberName);
-    if (fieldIt == structInfo.fields.end())
+    llvm::Value *index = EmitIndex(indexNode);
+    if (!index)
     {
-        JLANG_ERROR(
-            STR("Unknown field '%s' in struct '%s'", node.memberName.c_str(), structTypeName.c_str()));
-        return;
+        return nullptr;
     }
 
-    const FieldInfo &fieldInfo = fieldIt->second;
-
-    // Check visibility - private fields (lowercase) can only be accessed from within the struct's methods
-    // For now, we'll allow all access but emit a warning for private fields
-    // A proper implementation would track the current context
-    if (!fieldInfo.isPublic)
+    // Indexing past the end is undefined as in C, which is what allows inbounds
+    if (objectType.IsArray())
     {
-        JLANG_ERROR(STR("Cannot access private field '%s' in struct '%s'", node.memberName.c_str(),
-                        structTypeName.c_str()));
-        return;
+        return m_IRBuilder.CreateInBoundsGEP(MapType(objectType), base, {m_IRBuilder.getInt64(0), index},
+                                             "elem_ptr");
     }
 
-    // Generate GEP to access the field
-    llvm::Value *fieldPtr = m_IRBuilder.CreateStructGEP(structInfo.llvmType, objectPtr, fieldInfo.index,
-                                                        node.memberName + "_ptr");
+    if (objectType.isSlice)
+    {
+        base = m_IRBuilder.CreateExtractValue(base, 0, "slice_data");
+    }
 
-    // Load the field value
-    llvm::Type *fieldType = MapType(fieldInfo.type);
-    m_LastValue = m_IRBuilder.CreateLoad(fieldType, fieldPtr, node.memberName);
+    return m_IRBuilder.CreateInBoundsGEP(MapType(objectType.ElementType()), base, index, "elem_ptr");
 }
 
-void CodeGenerator::VisitPrefixExpr(PrefixExpr &node)
+llvm::Value *CodeGenerator::EmitIndex(AstNode *indexNode)
 {
-    // Prefix ++/--: increment/decrement and return the NEW value
-    auto *varExpr = dynamic_cast<VarExpr *>(node.operand.get());
-    if (!varExpr)
+    m_LastValue = nullptr;
+    indexNode->Accept(*this);
+    llvm::Value *index = m_LastValue;
+
+    if (!index || !index->getType()->isIntegerTy())
     {
-        JLANG_ERROR("Prefix increment/decrement requires a variable operand");
-        return;
+        JLANG_ERROR("Index must be an integer");
+        return nullptr;
     }
 
-    auto it = m_variables.find(varExpr->name);
-    if (it == m_variables.end())
+    // GEP indices are sign-extended to pointer width, unsigned ones must be zero-extended first
+    bool isSignedIndex = !ResolvedTypeOf(indexNode).IsUnsignedInteger();
+    return m_IRBuilder.CreateIntCast(index, m_IRBuilder.getInt64Ty(), isSignedIndex, "idx");
+}
+
+llvm::Value *CodeGenerator::EmitLaneIndex(IndexExpr &node)
+{
+    node.index->Accept(*this);
+    llvm::Value *lane = m_LastValue;
+
+    if (!lane || !lane->getType()->isIntegerTy())
     {
-        JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
-        return;
+        JLANG_ERROR("Lane index must be an integer");
+        return nullptr;
     }
 
-    if (!it->second.isMutable)
+    // A lane past the end yields poison, catch the constant case at compile time
+    unsigned laneCount = ResolvedTypeOf(node.object).VectorLanes();
+    if (auto *constant = llvm::dyn_cast<llvm::ConstantInt>(lane); constant && constant->uge(laneCount))
     {
-        JLANG_ERROR(
-            STR("Cannot modify immutable variable '%s' (declared with 'val')", varExpr->name.c_str()));
-        return;
+        JLANG_ERROR(STR("Lane %llu is out of range for a vector of %u lanes",
+                        static_cast<unsigned long long>(constant->getZExtValue()), laneCount));
+        return nullptr;
     }
 
-    // Mark variable as used
-    it->second.used = true;
+    return lane;
+}
 
-    llvm::Value *varPtr = it->second.value;
-    llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(varPtr);
-    if (!alloca)
+llvm::Value *CodeGenerator::EmitValueFor(AstNode *node, const TypeRef &targetType)
+{
+    TypeRef sourceType = ResolvedTypeOf(node);
+
+    if (!targetType.isSlice || !sourceType.IsArray())
     {
-        JLANG_ERROR("Cannot increment/decrement non-variable");
-        return;
+        node->Accept(*this);
+        return m_LastValue;
     }
 
-    // Load current value
-    llvm::Value *currentVal = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, "load");
+    if (IsSoaArray(sourceType))
+    {
+        JLANG_ERROR("A #[soa] array cannot be used as a slice, pass one of its columns: a.Field");
+        return nullptr;
+    }
 
-    // Add or subtract 1
-    llvm::Value *one = llvm::ConstantInt::get(currentVal->getType(), 1);
-    llvm::Value *newVal;
-    if (node.op == "++")
+    if (sourceType.name != targetType.name || sourceType.isPointer != targetType.isPointer)
     {
-        newVal = m_IRBuilder.CreateAdd(currentVal, one, "inc");
+        JLANG_ERROR(STR("Cannot use an array of '%s' as a slice of '%s'", sourceType.name.c_str(),
+                        targetType.name.c_str()));
+        return nullptr;
     }
-    else
+
+    // Slice elements are assumed to be naturally aligned, which an array in a #[packed] struct may not be
+    llvm::Type *elementType = MapType(sourceType.ElementType());
+    if (AccessAlignment(node, elementType) < m_Module->getDataLayout().getABITypeAlign(elementType))
     {
-        newVal = m_IRBuilder.CreateSub(currentVal, one, "dec");
+        JLANG_ERROR("Cannot take a slice of a misaligned array field in a #[packed] struct");
+        return nullptr;
     }
 
-    // Store new value back
-    m_IRBuilder.CreateStore(newVal, alloca);
+    llvm::Value *arrayPtr = EmitArrayAddress(node);
+    if (!arrayPtr)
+    {
+        return nullptr;
+    }
 
-    // Return the NEW value
-    m_LastValue = newVal;
+    llvm::Value *data = m_IRBuilder.CreateInBoundsGEP(
+        MapType(sourceType), arrayPtr, {m_IRBuilder.getInt64(0), m_IRBuilder.getInt64(0)}, "slice_data");
+    llvm::Value *slice = llvm::UndefValue::get(MapType(targetType));
+    slice = m_IRBuilder.CreateInsertValue(slice, data, 0);
+    return m_IRBuilder.CreateInsertValue(slice, m_IRBuilder.getInt64(sourceType.arraySize), 1, "slice");
 }
 
-void CodeGenerator::VisitPostfixExpr(PostfixExpr &node)
+llvm::AllocaInst *CodeGenerator::CreateEntryBlockAlloca(llvm::Type *type, const std::string &name,
+                                                        llvm::Align alignment)
 {
-    // Postfix ++/--: increment/decrement and return the ORIGINAL value
-    auto *varExpr = dynamic_cast<VarExpr *>(node.operand.get());
-    if (!varExpr)
-    {
-        JLANG_ERROR("Postfix increment/decrement requires a variable operand");
-        return;
-    }
+    // A declaration inside a loop body must not emit an alloca there, that would grow the stack on
+    // every iteration and keep the variable out of reach of mem2reg
+    llvm::BasicBlock &entry = m_IRBuilder.GetInsertBlock()->getParent()->getEntryBlock();
 
-    auto it = m_variables.find(varExpr->name);
-    if (it == m_variables.end())
-    {
-        JLANG_ERROR(STR("Undefined variable: %s", varExpr->name.c_str()));
-        return;
-    }
+    llvm::IRBuilder<> entryBuilder(&entry, m_LastEntryAlloca ? std::next(m_LastEntryAlloca->getIterator())
+                                                             : entry.begin());
 
-    if (!it->second.isMutable)
-    {
-        JLANG_ERROR(
-            STR("Cannot modify immutable variable '%s' (declared with 'val')", varExpr->name.c_str()));
-        return;
-    }
+    m_LastEntryAlloca = entryBuilder.CreateAlloca(type, nullptr, name);
+    m_LastEntryAlloca->setAlignment(std::max(m_LastEntryAlloca->getAlign(), alignment));
+    return m_LastEntryAlloca;
+}
 
-    // Mark variable as used
-    it->second.used = true;
+void CodeGenerator::PushScope()
+{
+    m_Scopes.emplace_back();
+}
 
-    llvm::Value *varPtr = it->second.value;
-    llvm::AllocaInst *alloca = llvm::dyn_cast<llvm::AllocaInst>(varPtr);
-    if (!alloca)
+void CodeGenerator::PopScope()
+{
+    Scope &scope = m_Scopes.back();
+
+    CheckUnusedVariables(scope);
+
+    // Ending the lifetimes lets stack coloring give disjoint scopes the same stack slot. Nothing can
+    // follow a terminator, and a return ends every lifetime anyway.
+    llvm::BasicBlock *block = m_IRBuilder.GetInsertBlock();
+    if (block && !block->getTerminator())
     {
-        JLANG_ERROR("Cannot increment/decrement non-variable");
-        return;
+        const llvm::DataLayout &dataLayout = m_Module->getDataLayout();
+        for (auto it = scope.lifetimeAllocas.rbegin(); it != scope.lifetimeAllocas.rend(); ++it)
+        {
+            uint64_t size = dataLayout.getTypeAllocSize((*it)->getAllocatedType());
+            m_IRBuilder.CreateLifetimeEnd(*it, m_IRBuilder.getInt64(size));
+        }
     }
 
-    // Load current value
-    llvm::Value *currentVal = m_IRBuilder.CreateLoad(alloca->getAllocatedType(), alloca, "load");
+    m_Scopes.pop_back();
+}
 
-    // Add or subtract 1
-    llvm::Value *one = llvm::ConstantInt::get(currentVal->getType(), 1);
-    llvm::Value *newVal;
-    if (node.op == "++")
+void CodeGenerator::DeclareVariable(const std::string &name, const VariableInfo &info)
+{
+    Scope &scope = m_Scopes.back();
+
+    if (scope.variables.insert_or_assign(name, info).second)
     {
-        newVal = m_IRBuilder.CreateAdd(currentVal, one, "inc");
+        scope.declarationOrder.push_back(name);
     }
-    else
+}
+
+CodeGenerator::VariableInfo *CodeGenerator::LookupVariable(const std::string &name)
+{
+    // Inner declarations shadow outer ones
+    for (auto scope = m_Scopes.rbegin(); scope != m_Scopes.rend(); ++scope)
     {
-        newVal = m_IRBuilder.CreateSub(currentVal, one, "dec");
+        auto it = scope->variables.find(name);
+        if (it != scope->variables.end())
+        {
+            return &it->second;
+        }
     }
 
-    // Store new value back
-    m_IRBuilder.CreateStore(newVal, alloca);
+    return nullptr;
+}
 
-    // Return the ORIGINAL value
-    m_LastValue = currentVal;
+void CodeGenerator::StartLifetime(llvm::AllocaInst *alloca)
+{
+    uint64_t size = m_Module->getDataLayout().getTypeAllocSize(alloca->getAllocatedType());
+    m_IRBuilder.CreateLifetimeStart(alloca, m_IRBuilder.getInt64(size));
+
+    m_Scopes.back().lifetimeAllocas.push_back(alloca);
 }
 
-void CodeGenerator::CheckUnusedVariables()
+void CodeGenerator::CheckUnusedVariables(const Scope &scope)
 {
     // TODO: make this a cool hard error that stops compilation (like Go)
     // for now just complain a bit
-    for (const auto &varName : m_currentFunctionVariables)
+    for (const auto &varName : scope.declarationOrder)
     {
-        auto it = m_variables.find(varName);
-        if (it != m_variables.end() && !it->second.used)
+        if (!scope.variables.at(varName).used)
         {
             JLANG_ERROR(STR("Unused variable: %s", varName.c_str()));
         }
@@ -1410,12 +3741,42 @@ llvm::Type *CodeGenerator::MapType(const TypeRef &typeRef)
         return llvm::Type::getVoidTy(m_Context);
     }
 
+    // A #[soa] array is one [N x field] column per field, in declaration order
+    if (IsSoaArray(typeRef))
+    {
+        const StructInfo &structInfo = m_structTypes.at(typeRef.name);
+        std::vector<llvm::Type *> columns;
+        for (const std::string &fieldName : structInfo.declarationOrder)
+        {
+            llvm::Type *fieldType = MapType(structInfo.fields.at(fieldName).type);
+            columns.push_back(llvm::ArrayType::get(fieldType, typeRef.arraySize));
+        }
+        return llvm::StructType::get(m_Context, columns);
+    }
+
+    if (typeRef.IsArray())
+    {
+        return llvm::ArrayType::get(MapType(typeRef.ElementType()), typeRef.arraySize);
+    }
+
+    if (typeRef.isSlice)
+    {
+        // { T *data, i64 len }
+        llvm::Type *dataType = llvm::PointerType::getUnqual(MapType(typeRef.ElementType()));
+        return llvm::StructType::get(m_Context, {dataType, llvm::Type::getInt64Ty(m_Context)});
+    }
+
     llvm::Type *baseType = nullptr;
+    TypeRef namedType{typeRef.name};
     auto it = typeMap.find(typeRef.name);
     if (it != typeMap.end())
     {
         baseType = it->second(m_Context);
     }
+    else if (namedType.IsVector())
+    {
+        baseType = llvm::FixedVectorType::get(MapType(namedType.ElementType()), namedType.VectorLanes());
+    }
     else
     {
         // Check if it's a registered struct type
@@ -1480,6 +3841,12 @@ TypeRef CodeGenerator::InferTypeRef(llvm::Type *llvmType)
         return TypeRef{"f64", false};
     }
 
+    if (auto *vectorType = llvm::dyn_cast<llvm::FixedVectorType>(llvmType))
+    {
+        TypeRef laneType = InferTypeRef(vectorType->getElementType());
+        return TypeRef{laneType.name + "x" + std::to_string(vectorType->getNumElements())};
+    }
+
     // Handle struct types
     if (auto *structType = llvm::dyn_cast<llvm::StructType>(llvmType))
     {
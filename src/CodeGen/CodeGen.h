@@ -6,11 +6,11 @@
 #include "../AST/Expressions/Expressions.h"
 #include "../AST/Statements/Statements.h"
 #include "../AST/TopLevelDecl/TopLevelDecl.h"
+#include "../Enums/EmitKinds.h"
+#include "../Enums/OptimizationLevels.h"
 
 #include <memory>
-#include <optional>
 #include <unordered_map>
-#include <unordered_set>
 
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
@@ -18,6 +18,8 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
 
 namespace jlang
 {
@@ -25,11 +27,21 @@ namespace jlang
 class CodeGenerator : public AstVisitor
 {
   public:
-    CodeGenerator();
+    explicit CodeGenerator(llvm::LLVMContext &context);
 
-    void Generate(const std::vector<std::shared_ptr<AstNode>> &program);
+    void Generate(const std::vector<AstNode *> &program);
+    // Returns false, leaving the module alone, when it does not pass the verifier
+    bool Optimize(OptimizationLevel level, bool timePasses = false);
     void DumpIR();
 
+    // Size, alignment, field offsets, padding holes and cache line boundaries of every struct
+    void PrintLayoutReport(llvm::raw_ostream &out) const;
+
+    // One line per alloc<T>() that Optimize moved to the stack because its pointer never escapes
+    void PrintEscapeReport(llvm::raw_ostream &out) const;
+    bool Emit(EmitKind kind, const std::string &outputPath);
+    std::unique_ptr<llvm::Module> TakeModule();
+
   private:
     virtual void VisitFunctionDecl(FunctionDecl &) override;
     virtual void VisitInterfaceDecl(InterfaceDecl &) override;
@@ -42,6 +54,7 @@ class CodeGenerator : public AstVisitor
     virtual void VisitBlockStatement(BlockStatement &) override;
     virtual void VisitExprStatement(ExprStatement &) override;
     virtual void VisitReturnStatement(ReturnStatement &) override;
+    virtual void VisitMatchStatement(MatchStatement &) override;
 
     virtual void VisitCallExpr(CallExpr &) override;
     virtual void VisitBinaryExpr(BinaryExpr &) override;
@@ -54,26 +67,141 @@ class CodeGenerator : public AstVisitor
     virtual void VisitMemberAccessExpr(MemberAccessExpr &) override;
     virtual void VisitPrefixExpr(PrefixExpr &) override;
     virtual void VisitPostfixExpr(PostfixExpr &) override;
+    virtual void VisitIndexExpr(IndexExpr &) override;
+    virtual void VisitIndexAssignExpr(IndexAssignExpr &) override;
+    virtual void VisitMemberAssignExpr(MemberAssignExpr &) override;
+    virtual void VisitStructLiteralExpr(StructLiteralExpr &) override;
 
   private:
+    void CreateTargetMachine();
     void DeclareExternalFunctions();
     llvm::Type *MapType(const TypeRef &typeRef);
     TypeRef InferTypeRef(llvm::Type *llvmType);
 
+    // Every local lives in an alloca in the entry block, where mem2reg can promote it to SSA. The alignment
+    // is raised to the given one, which #[align] and #[packed] structs need.
+    llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Type *type, const std::string &name,
+                                             llvm::Align alignment = llvm::Align());
+
     // Struct field information
     struct FieldInfo
     {
-        unsigned index;
+        unsigned index; // Element of the LLVM struct
         TypeRef type;
         bool isPublic;
+        llvm::Align alignment; // Guaranteed alignment of the field's address
+        unsigned column;       // Position in the declaration, the column in #[soa] arrays
     };
 
     struct StructInfo
     {
         llvm::StructType *llvmType;
         std::unordered_map<std::string, FieldInfo> fields;
+        std::vector<std::string> declarationOrder; // As written, FieldInfo::index is the memory order
+        llvm::Align alignment;
+        uint64_t declaredSize = 0; // Size the fields would take in declaration order
+        bool isReprC = false;
+        bool isPacked = false;
+        bool isSoa = false;
+        bool isReordered = false; // Memory order differs from the declaration, C would not agree
+    };
+
+    // Where the fields of a struct go, in the order they are given
+    struct StructLayoutPlan
+    {
+        std::vector<llvm::Type *> elements;       // Fields, plus [N x i8] padding in an explicit layout
+        std::vector<unsigned> fieldIndices;       // Element index of each field
+        std::vector<llvm::Align> fieldAlignments; // Guaranteed alignment of each field's address
+        uint64_t size = 0;
+        llvm::Align alignment;
+        bool isExplicit = false; // An LLVM packed struct with every padding byte spelled out
+    };
+
+    // Lays fields out in the given order at the given alignments. That is LLVM's natural layout unless a
+    // field is aligned differently from its type (#[align], #[packed]) or the struct asks for more
+    // alignment, then the offsets are computed here and the padding is made explicit.
+    StructLayoutPlan PlanStructLayout(const std::vector<llvm::Type *> &types,
+                                      const std::vector<llvm::Align> &alignments,
+                                      llvm::Align structAlignment) const;
+
+    // ABI alignment of a type, or the #[align]/#[packed] alignment of a struct
+    llvm::Align TypeAlignment(const TypeRef &typeRef, llvm::Type *type) const;
+
+    // Alignment for a load or store of node: that of the type, lowered for fields of #[packed] structs
+    llvm::Align AccessAlignment(AstNode *node, llvm::Type *type) const;
+
+    // A struct held by value rather than behind a pointer: Point, not Point* or [4]Point
+    bool IsStructValue(const TypeRef &typeRef) const;
+
+    // Point{X: 1, Y: 2} as an SSA value, insertvalue by insertvalue over a zeroed struct
+    llvm::Value *EmitStructLiteral(StructLiteralExpr &node);
+
+    // Storage of a struct value: its variable, field or array element, or a temporary for other values
+    llvm::Value *EmitStructAddress(AstNode *node);
+
+    // How a struct value crosses a call. On x86-64 SysV a struct of up to 16 bytes travels in one register
+    // per eightbyte, INTEGER ones as iN and SSE ones as float, <2 x float> or double. Bigger, misaligned
+    // and vector-holding structs, and every struct on other targets, go in memory: a byval copy for a
+    // parameter, an sret slot for a result.
+    struct AbiLowering
+    {
+        bool isIndirect = false;
+        std::vector<llvm::Type *> registerTypes;
+        std::vector<uint64_t> registerOffsets; // Where in the struct each register's bytes are
+
+        // Passed or returned in memory
+        static AbiLowering Indirect()
+        {
+            AbiLowering lowering;
+            lowering.isIndirect = true;
+            return lowering;
+        }
+    };
+
+    // A function's jlang signature and the LLVM signature it lowers to
+    struct FunctionAbi
+    {
+        std::vector<TypeRef> paramTypes;
+        TypeRef returnType;
+        std::vector<AbiLowering> params; // Only meaningful for struct values
+        AbiLowering result;
+        llvm::FunctionType *type = nullptr;
+        llvm::AttributeList attributes; // byval and sret parameters, for the function and its call sites
+    };
+
+    enum class EightbyteClass
+    {
+        None,
+        Integer,
+        Sse
+    };
+
+    struct Eightbyte
+    {
+        EightbyteClass kind = EightbyteClass::None;
+        uint64_t dataEnd = 0; // Bytes from the start of the eightbyte to the end of its last field
+        bool hasDouble = false;
     };
 
+    // A struct whose fields were reordered does not match the C struct callers of an exported function
+    // declare, warn about every one in its signature
+    void WarnAboutReorderedStructs(const FunctionDecl &node);
+
+    FunctionAbi LowerSignature(const FunctionDecl &node);
+    AbiLowering ClassifyStruct(const TypeRef &structType);
+
+    // Merges the scalars of type at offset into the eightbytes, false when the ABI puts it in memory
+    bool ClassifyEightbytes(const TypeRef &type, uint64_t offset, std::vector<Eightbyte> &eightbytes);
+
+    // byval copies are at least 8-byte aligned, as the x86-64 stack is
+    llvm::Align ByValAlignment(const TypeRef &typeRef, llvm::Type *type) const;
+
+    // Between a struct value and its registers, through memory both fit in. SROA removes the round trip.
+    std::vector<llvm::Value *> EmitRegisterParts(llvm::Value *value, const AbiLowering &lowering);
+    llvm::Value *EmitFromRegisterParts(const std::vector<llvm::Value *> &parts, llvm::Type *structType,
+                                       const AbiLowering &lowering);
+    llvm::AllocaInst *CreateCoercionSlot(llvm::Type *structType, const AbiLowering &lowering);
+
     // Track variable usage for unused variable detection
     struct VariableInfo
     {
@@ -83,32 +211,85 @@ class CodeGenerator : public AstVisitor
         bool isMutable = true;
     };
 
-    void CheckUnusedVariables();
-
-    // Loop unrolling optimization
-    static const int MAX_UNROLL_COUNT = 8;
-
-    struct LoopUnrollInfo
+    // Lexical scopes: every block, for statement and function parameter list gets one
+    struct Scope
     {
-        std::string varName;
-        int64_t start;
-        int64_t end;
-        int64_t step;          // +1 or -1
-        std::string compareOp; // "<", "<=", ">", ">="
+        std::unordered_map<std::string, VariableInfo> variables;
+        std::vector<std::string> declarationOrder;
+        std::vector<llvm::AllocaInst *> lifetimeAllocas; // Locals whose lifetime ends with the scope
     };
 
-    std::optional<LoopUnrollInfo> AnalyzeForUnroll(ForStatement &node);
-    bool BodyModifiesVar(const std::shared_ptr<AstNode> &node, const std::string &varName);
+    void PushScope();
+    void PopScope();
+    void DeclareVariable(const std::string &name, const VariableInfo &info);
+    VariableInfo *LookupVariable(const std::string &name);
+    void StartLifetime(llvm::AllocaInst *alloca);
+
+    void CheckUnusedVariables(const Scope &scope);
+
+    void EmitForStatement(ForStatement &node);
+
+    // Evaluates a match pattern bound, which has to fold to a constant of the matched value's type
+    llvm::ConstantInt *EmitMatchConstant(AstNode *node, llvm::Type *valueType);
+
+    // Maps 'inline', #[always_inline], #[noinline] and #[flatten] to LLVM function and call site
+    // attributes. Runs after the body is emitted, #[flatten] marks the calls in it.
+    void ApplyInliningAttributes(llvm::Function &function, const FunctionDecl &node);
+
+    // Every operator but the short-circuit ones, on already evaluated operands. operandType gives the
+    // signedness, a scalar operand of a vector operation is broadcast. Returns nullptr on errors.
+    llvm::Value *EmitBinaryOperation(BinaryOp op, llvm::Value *leftVal, llvm::Value *rightVal,
+                                     const TypeRef &operandType);
+
+    // The new value of target op= operand, given the target's current value
+    llvm::Value *EmitCompoundValue(BinaryOp op, llvm::Value *current, AstNode *operand, const TypeRef &type);
+
+    // Storage of an array held in a variable or struct field
+    llvm::Value *EmitArrayAddress(AstNode *node);
+    llvm::Value *EmitElementAddress(AstNode *object, AstNode *index);
+    llvm::Value *EmitIndex(AstNode *index); // As an i64 for a GEP
+
+    // The field, reporting unknown and private ones
+    const FieldInfo *LookupField(const std::string &structName, const std::string &fieldName);
+
+    // An array of a #[soa] struct is stored as one array per field: { [N x X], [N x Y], ... }
+    bool IsSoaArray(const TypeRef &typeRef) const;
+
+    // ps[i].Field, element i of the Field column, or ps.Field, the whole column, of a #[soa] array
+    llvm::Value *EmitSoaAddress(MemberAccessExpr &node, TypeRef &fieldType);
+
+    // splat, load/store (plain and _aligned), shuffle and reduce_* lower straight to vector IR
+    void EmitVectorBuiltin(CallExpr &node);
+    void EmitVectorMemoryAccess(CallExpr &node);
+    void EmitVectorShuffle(CallExpr &node);
+    void EmitVectorReduction(CallExpr &node);
+
+    // Lane number of v[i] on a vector, checked against the lane count when it is a constant
+    llvm::Value *EmitLaneIndex(IndexExpr &node);
+    llvm::Value *EmitMemberAddress(MemberAccessExpr &node, TypeRef &fieldType);
+
+    // Evaluates node for a destination of the given type. An array where a slice is expected becomes a
+    // slice over the whole array, everything else is evaluated as is.
+    llvm::Value *EmitValueFor(AstNode *node, const TypeRef &targetType);
+
+    // Translates #[unroll], #[vectorize] and #[interleave] into an llvm.loop ID for the loop's back
+    // edge, the loop passes do the actual transformation. Returns nullptr for a loop without hints.
+    llvm::MDNode *CreateLoopMetadata(const std::vector<Attribute> &attributes);
 
   private:
-    llvm::LLVMContext m_Context;
+    llvm::LLVMContext &m_Context;
     std::unique_ptr<llvm::Module> m_Module;
     llvm::IRBuilder<> m_IRBuilder;
+    std::unique_ptr<llvm::TargetMachine> m_TargetMachine;
 
-    std::unordered_map<std::string, VariableInfo> m_variables;  // Track variables with usage info
-    std::unordered_map<std::string, StructInfo> m_structTypes;  // Track struct definitions
-    std::unordered_set<std::string> m_currentFunctionVariables; // Variables declared in current function
+    std::vector<Scope> m_Scopes;                               // Innermost scope last
+    std::unordered_map<std::string, StructInfo> m_structTypes; // Track struct definitions
+    std::vector<std::string> m_StructOrder;                    // Struct names in declaration order
+    std::unordered_map<std::string, FunctionAbi> m_Functions;  // Signatures of the jlang functions
+    const FunctionAbi *m_CurrentFunction = nullptr;
+    std::vector<std::string> m_StackAllocations; // Remarks of HeapToStackPass, in the order it made them
     llvm::Value *m_LastValue = nullptr;
+    llvm::AllocaInst *m_LastEntryAlloca = nullptr; // New allocas go after it to keep declaration order
 };
 
 } // namespace jlang
@@ -0,0 +1,236 @@
+#include "HeapToStack.h"
+#include "Allocation.h"
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace jlang
+{
+
+// Bigger allocations stay on the heap, a few of them in a recursive function would overflow the stack
+static constexpr uint64_t kMaxStackAllocationSize = 1024;
+
+// Many small allocations add up just the same, so the moved ones share a budget for the whole frame
+static constexpr uint64_t kMaxStackFrameSize = 4096;
+
+// Bytes the entry block already reserves, which includes the slots of an earlier run of the pass
+static uint64_t StaticFrameSize(llvm::Function &function)
+{
+    const llvm::DataLayout &dataLayout = function.getParent()->getDataLayout();
+    uint64_t size = 0;
+    for (llvm::Instruction &instruction : function.getEntryBlock())
+    {
+        auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(&instruction);
+        if (!alloca)
+        {
+            continue;
+        }
+
+        llvm::Optional<llvm::TypeSize> bits = alloca->getAllocationSizeInBits(dataLayout);
+        if (bits && !bits->isScalable())
+        {
+            size += bits->getFixedSize() / 8;
+        }
+    }
+    return size;
+}
+
+// malloc(size) or aligned_alloc(alignment, size) with a constant size, the two calls alloc<T>() emits
+static bool IsConstantAllocation(llvm::CallInst *call, uint64_t &size)
+{
+    llvm::Function *callee = call->getCalledFunction();
+    if (!callee)
+    {
+        return false;
+    }
+
+    unsigned sizeIndex = 0;
+    if (callee->getName() == "aligned_alloc" && call->arg_size() == 2)
+    {
+        sizeIndex = 1;
+    }
+    else if (callee->getName() != "malloc" || call->arg_size() != 1)
+    {
+        return false;
+    }
+
+    auto *constantSize = llvm::dyn_cast<llvm::ConstantInt>(call->getArgOperand(sizeIndex));
+    if (!constantSize)
+    {
+        return false;
+    }
+
+    size = constantSize->getZExtValue();
+    return true;
+}
+
+static bool IsFree(llvm::CallInst *call)
+{
+    llvm::Function *callee = call->getCalledFunction();
+    return callee && callee->getName() == "free" && call->arg_size() == 1;
+}
+
+// Follows every pointer derived from the allocation. Returns false as soon as one of them escapes,
+// otherwise collects the free calls and the struct the allocation was cast to.
+static bool CollectUses(llvm::CallInst *allocation, std::vector<llvm::CallInst *> &frees,
+                        llvm::StructType *&structType)
+{
+    llvm::SmallVector<llvm::Value *, 8> worklist = {allocation};
+    llvm::SmallPtrSet<llvm::Value *, 8> visited;
+
+    while (!worklist.empty())
+    {
+        llvm::Value *pointer = worklist.pop_back_val();
+        if (!visited.insert(pointer).second)
+        {
+            continue;
+        }
+
+        for (llvm::Use &use : pointer->uses())
+        {
+            llvm::User *user = use.getUser();
+
+            if (auto *cast = llvm::dyn_cast<llvm::BitCastInst>(user))
+            {
+                auto *pointee = cast->getType()->getPointerElementType();
+                if (!structType && pointee->isStructTy())
+                {
+                    structType = llvm::cast<llvm::StructType>(pointee);
+                }
+                worklist.push_back(cast);
+            }
+            else if (llvm::isa<llvm::GetElementPtrInst>(user))
+            {
+                worklist.push_back(user);
+            }
+            else if (llvm::isa<llvm::LoadInst>(user) || llvm::isa<llvm::ICmpInst>(user))
+            {
+                // Reading through the pointer, or comparing it, keeps it in the function
+            }
+            else if (llvm::isa<llvm::StoreInst>(user))
+            {
+                // Storing to the allocation is fine, storing the pointer itself lets it out
+                if (use.getOperandNo() != llvm::StoreInst::getPointerOperandIndex())
+                {
+                    return false;
+                }
+            }
+            else if (auto *call = llvm::dyn_cast<llvm::CallInst>(user))
+            {
+                if (IsFree(call))
+                {
+                    frees.push_back(call);
+                }
+                else if (!llvm::isa<llvm::MemIntrinsic>(call) && !call->isLifetimeStartOrEnd())
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                // Returned, merged by a phi or select, turned into an integer, ...
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+HeapToStackPass::HeapToStackPass(std::vector<std::string> *remarks) : m_Remarks(remarks) {}
+
+llvm::PreservedAnalyses HeapToStackPass::run(llvm::Function &function, llvm::FunctionAnalysisManager &)
+{
+    std::vector<llvm::CallInst *> allocations;
+    for (llvm::Instruction &instruction : llvm::instructions(function))
+    {
+        auto *call = llvm::dyn_cast<llvm::CallInst>(&instruction);
+        uint64_t size = 0;
+        if (call && IsConstantAllocation(call, size) && size <= kMaxStackAllocationSize)
+        {
+            allocations.push_back(call);
+        }
+    }
+
+    bool isChanged = false;
+    llvm::BasicBlock &entryBlock = function.getEntryBlock();
+    uint64_t frameSize = allocations.empty() ? 0 : StaticFrameSize(function);
+
+    for (llvm::CallInst *allocation : allocations)
+    {
+        std::vector<llvm::CallInst *> frees;
+        llvm::StructType *structType = nullptr;
+        if (!CollectUses(allocation, frees, structType))
+        {
+            continue;
+        }
+
+        // An allocation inside a loop gets the same slot on every iteration. That is safe: carrying the
+        // pointer into the next iteration takes a phi or a store, and either counts as an escape.
+        uint64_t size = 0;
+        IsConstantAllocation(allocation, size);
+        llvm::Align alignment = std::max(kMallocAlignment, allocation->getRetAlign().valueOrOne());
+
+        uint64_t slotSize = llvm::alignTo(size, alignment);
+        if (frameSize + slotSize > kMaxStackFrameSize)
+        {
+            continue;
+        }
+        frameSize += slotSize;
+
+        // After the allocas already there, the first instruction after them may be the allocation itself
+        auto insertPoint = entryBlock.getFirstInsertionPt();
+        while (llvm::isa<llvm::AllocaInst>(*insertPoint))
+        {
+            ++insertPoint;
+        }
+
+        llvm::IRBuilder<> builder(&entryBlock, insertPoint);
+        llvm::AllocaInst *slot = builder.CreateAlloca(
+            llvm::ArrayType::get(builder.getInt8Ty(), size), nullptr, allocation->getName() + ".stack");
+        slot->setAlignment(alignment);
+
+        llvm::Value *pointer = new llvm::BitCastInst(slot, allocation->getType(), "", allocation);
+        pointer->takeName(allocation);
+        allocation->replaceAllUsesWith(pointer);
+        allocation->eraseFromParent();
+
+        for (llvm::CallInst *freeCall : frees)
+        {
+            freeCall->eraseFromParent();
+        }
+
+        if (m_Remarks)
+        {
+            std::string remark;
+            llvm::raw_string_ostream remarkStream(remark);
+            remarkStream << function.getName() << ": " << size << "-byte allocation";
+            if (structType && structType->hasName())
+            {
+                remarkStream << " of " << structType->getName();
+            }
+            remarkStream << " moved to the stack, " << frees.size()
+                         << (frees.size() == 1 ? " free" : " frees") << " removed";
+            m_Remarks->push_back(remarkStream.str());
+        }
+
+        isChanged = true;
+    }
+
+    if (!isChanged)
+    {
+        return llvm::PreservedAnalyses::all();
+    }
+
+    llvm::PreservedAnalyses preserved;
+    preserved.preserveSet<llvm::CFGAnalyses>();
+    return preserved;
+}
+
+} // namespace jlang
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+
+namespace jlang
+{
+
+// Escape analysis for alloc<T>(): a malloc or aligned_alloc of a constant size whose pointer never
+// leaves the function becomes an entry block alloca, and the free calls on it are dropped. The pointer
+// escapes when it is stored, returned, merged by a phi or select, converted to an integer or passed to
+// any call but free and the memory intrinsics. Callees are not looked into, the pass runs after the
+// inliner so calls to small helpers are already gone.
+class HeapToStackPass : public llvm::PassInfoMixin<HeapToStackPass>
+{
+  public:
+    // Every conversion is described by a line in remarks when it is given
+    explicit HeapToStackPass(std::vector<std::string> *remarks = nullptr);
+
+    llvm::PreservedAnalyses run(llvm::Function &function, llvm::FunctionAnalysisManager &analysisManager);
+
+  private:
+    std::vector<std::string> *m_Remarks;
+};
+
+} // namespace jlang
@@ -0,0 +1,76 @@
+#include "JitRunner.h"
+
+#include "../Common/Logger.h"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/Error.h>
+
+namespace jlang
+{
+
+std::optional<int> JitRunner::Run(std::unique_ptr<llvm::Module> module,
+                                  std::unique_ptr<llvm::LLVMContext> context)
+{
+    // Executing invalid IR crashes or misbehaves in the JIT'd code rather than failing cleanly
+    if (llvm::verifyModule(*module, &llvm::errs()))
+    {
+        JLANG_ERROR("Cannot run program: module verification failed");
+        return std::nullopt;
+    }
+
+    llvm::Function *mainFunction = module->getFunction("main");
+    if (!mainFunction || mainFunction->isDeclaration())
+    {
+        JLANG_ERROR("Cannot run program: no 'main' function defined");
+        return std::nullopt;
+    }
+
+    bool returnsInt = mainFunction->getReturnType()->isIntegerTy();
+
+    llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> jit = llvm::orc::LLJITBuilder().create();
+    if (!jit)
+    {
+        JLANG_ERROR(STR("Cannot create JIT: %s", llvm::toString(jit.takeError()).c_str()));
+        return std::nullopt;
+    }
+
+    // Resolve printf/malloc/free (and the rest of libc) from the symbols already loaded in this process
+    char globalPrefix = (*jit)->getDataLayout().getGlobalPrefix();
+    auto hostSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(globalPrefix);
+    if (!hostSymbols)
+    {
+        JLANG_ERROR(
+            STR("Cannot expose host symbols to JIT: %s", llvm::toString(hostSymbols.takeError()).c_str()));
+        return std::nullopt;
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*hostSymbols));
+
+    llvm::orc::ThreadSafeModule threadSafeModule(std::move(module), std::move(context));
+    if (llvm::Error error = (*jit)->addIRModule(std::move(threadSafeModule)))
+    {
+        JLANG_ERROR(STR("Cannot add module to JIT: %s", llvm::toString(std::move(error)).c_str()));
+        return std::nullopt;
+    }
+
+    llvm::Expected<llvm::JITEvaluatedSymbol> mainSymbol = (*jit)->lookup("main");
+    if (!mainSymbol)
+    {
+        JLANG_ERROR(STR("Cannot resolve 'main': %s", llvm::toString(mainSymbol.takeError()).c_str()));
+        return std::nullopt;
+    }
+
+    if (!returnsInt)
+    {
+        auto *entryPoint = reinterpret_cast<void (*)()>(mainSymbol->getAddress());
+        entryPoint();
+        return 0;
+    }
+
+    auto *entryPoint = reinterpret_cast<int (*)()>(mainSymbol->getAddress());
+    return entryPoint();
+}
+
+} // namespace jlang
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+namespace jlang
+{
+
+class JitRunner
+{
+  public:
+    std::optional<int> Run(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context);
+};
+
+} // namespace jlang
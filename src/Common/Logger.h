@@ -17,6 +17,7 @@
     }(format, __VA_ARGS__)
 
 #define JLANG_ERROR(MSG) LogErrorV(MSG)
+#define JLANG_WARNING(MSG) LogWarning(MSG)
 
 #define LOG(severity, message) jlang::Logger::log(severity, message, __FILE__, __LINE__)
 
@@ -36,6 +37,12 @@ inline llvm::Value *LogErrorV(const std::string &message)
     return LogErrorV(message.c_str());
 }
 
+// For code that compiles but probably does not do what was meant
+inline void LogWarning(const std::string &message)
+{
+    std::cerr << "JLANG WARNING: " << message << std::endl;
+}
+
 namespace jlang
 {
 
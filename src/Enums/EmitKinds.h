@@ -0,0 +1,13 @@
+#pragma once
+
+namespace jlang
+{
+enum class EmitKind
+{
+    LLVM,
+    Bitcode,
+    Assembly,
+    Object,
+    Executable
+};
+} // namespace jlang
@@ -15,6 +15,7 @@ enum class NodeType
     BlockStatement,
     ExprStatement,
     ReturnStatement,
+    MatchStatement,
 
     CallExpr,
     BinaryExpr,
@@ -26,6 +27,10 @@ enum class NodeType
     AssignExpr,
     MemberAccessExpr,
     PrefixExpr,
-    PostfixExpr
+    PostfixExpr,
+    IndexExpr,
+    IndexAssignExpr,
+    MemberAssignExpr,
+    StructLiteralExpr
 };
 } // namespace jlang
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace jlang
+{
+enum class BinaryOp
+{
+    Add,          // +
+    Sub,          // -
+    Mul,          // *
+    Div,          // /
+    Mod,          // %
+    BitAnd,       // &
+    BitOr,        // |
+    BitXor,       // ^
+    Shl,          // <<
+    Shr,          // >>
+    Equal,        // ==
+    NotEqual,     // !=
+    Less,         // <
+    LessEqual,    // <=
+    Greater,      // >
+    GreaterEqual, // >=
+    LogicalAnd,   // && (short-circuit)
+    LogicalOr,    // || (short-circuit)
+    EagerAnd,     // 'and' keyword (non-short-circuit)
+    EagerOr       // 'or' keyword (non-short-circuit)
+};
+
+enum class UnaryOp
+{
+    Not,       // !
+    BitNot,    // ~
+    Increment, // ++ (prefix or postfix)
+    Decrement  // -- (prefix or postfix)
+};
+} // namespace jlang
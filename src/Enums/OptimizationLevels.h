@@ -0,0 +1,13 @@
+#pragma once
+
+namespace jlang
+{
+enum class OptimizationLevel
+{
+    O0,
+    O1,
+    O2,
+    O3,
+    Os
+};
+} // namespace jlang
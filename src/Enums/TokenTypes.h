@@ -10,11 +10,13 @@ enum class TokenType
     Var,
     Val,
     Fn,
+    Inline,
     If,
     Else,
     While,
     For,
     Return,
+    Match,
     Null,
     Alloc,
     True,
@@ -34,6 +36,7 @@ enum class TokenType
     F64,
     Bool,
     Char,
+    VectorType, // f32x4, i32x8, ... share one token, the lexeme names the type
 
     // Symbols
     LBrace,
@@ -83,6 +86,12 @@ enum class TokenType
     CaretEqual,      // ^=
     LeftShiftEqual,  // <<=
     RightShiftEqual, // >>=
+    Hash,            // # (starts an attribute: #[...])
+    LBracket,        // [
+    RBracket,        // ]
+    FatArrow,        // => (match arm)
+    DotDot,          // .. (exclusive range)
+    DotDotEqual,     // ..= (inclusive range)
 
     // Literals and identifiers
     Identifier,
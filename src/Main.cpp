@@ -1,58 +1,445 @@
 #include "CodeGen/CodeGen.h"
+#include "CodeGen/JitRunner.h"
 #include "Parser/Parser.h"
 #include "Scanner/Scanner.h"
+#include "Sema/TypeAnnotator.h"
 
-#include <fstream>
+#include <algorithm>
+#include <future>
 #include <iostream>
-#include <sstream>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
 
 using namespace jlang;
 
-std::string Load(const std::string &path)
+struct CompileOptions
+{
+    std::vector<std::string> filePaths;
+    std::string outputPath;
+    EmitKind emitKind = EmitKind::LLVM;
+    bool isEmitKindSet = false;
+    OptimizationLevel optimizationLevel = OptimizationLevel::O0;
+    bool timePasses = false;
+    bool layoutReport = false;
+    bool escapeReport = false;
+    bool runInJit = false;
+    unsigned jobs = 0; // 0 = one worker per hardware thread
+};
+
+std::unique_ptr<llvm::MemoryBuffer> Load(const std::string &path)
 {
-    std::ifstream in(path);
+    // Large files are mmap'ed rather than read, and the scanner works directly on the mapping.
+    // The scanner never reads past the end, so there is no need for a null terminator (which
+    // would force a copy whenever the file size is a multiple of the page size).
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
 
-    if (!in.is_open())
+    if (!buffer)
     {
         std::cerr << "Error: Cannot open file: " << path << "\n";
-        return "";
+        return nullptr;
     }
 
-    std::stringstream buffer;
-    buffer << in.rdbuf();
+    return std::move(*buffer);
+}
 
-    in.close();
+std::string DefaultOutputPath(const std::string &inputPath, EmitKind kind)
+{
+    static const std::unordered_map<EmitKind, const char *> extensions = {
+        {EmitKind::LLVM, "ll"},
+        {EmitKind::Bitcode, "bc"},
+        {EmitKind::Assembly, "s"},
+        {EmitKind::Object, "o"},
+    };
 
-    return buffer.str();
+    if (kind == EmitKind::Executable)
+    {
+        return "a.out";
+    }
+
+    llvm::SmallString<128> path(llvm::sys::path::filename(inputPath));
+    llvm::sys::path::replace_extension(path, extensions.at(kind));
+    return std::string(path);
 }
 
-void Compile(const std::string &filePath)
+bool Link(const std::vector<std::string> &objectPaths, const std::string &outputPath)
 {
-    std::string sourceCode = Load(filePath);
-    if (sourceCode.empty())
+    // Let the system C compiler driver pick the CRT objects, libc and dynamic linker for us
+    llvm::ErrorOr<std::string> linker = llvm::sys::findProgramByName("cc");
+    if (!linker)
     {
-        return;
+        std::cerr << "Error: Cannot find the system C compiler 'cc' for linking\n";
+        return false;
     }
 
-    Scanner scanner(sourceCode);
+    std::vector<llvm::StringRef> args = {*linker};
+    args.insert(args.end(), objectPaths.begin(), objectPaths.end());
+    args.push_back("-o");
+    args.push_back(outputPath);
+
+    std::string errorMessage;
+    int exitCode = llvm::sys::ExecuteAndWait(*linker, args, llvm::None, {}, 0, 0, &errorMessage);
+
+    if (exitCode != 0)
+    {
+        std::cerr << "Error: Linking failed" << (errorMessage.empty() ? "" : ": " + errorMessage) << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool Generate(const CompileOptions &options, const std::string &filePath, CodeGenerator &codegen)
+{
+    std::unique_ptr<llvm::MemoryBuffer> source = Load(filePath);
+    if (!source)
+    {
+        return false;
+    }
+
+    Scanner scanner(std::string_view(source->getBufferStart(), source->getBufferSize()));
     const std::vector<Token> &tokens = scanner.Tokenize();
 
-    Parser parser(tokens);
-    std::vector<std::shared_ptr<AstNode>> program = parser.Parse();
+    AstArena arena;
+    Parser parser(tokens, arena);
+    std::vector<AstNode *> program = parser.Parse();
+
+    TypeAnnotator annotator;
+    annotator.Annotate(program);
 
-    CodeGenerator codegen;
     codegen.Generate(program);
-    codegen.DumpIR();
+
+    if (options.layoutReport)
+    {
+        // Written in one piece so the reports of files compiled in parallel do not interleave
+        std::string report;
+        llvm::raw_string_ostream reportStream(report);
+        codegen.PrintLayoutReport(reportStream);
+        llvm::errs() << reportStream.str();
+    }
+
+    // Invalid IR must not reach the backend, the linker or the JIT
+    if (!codegen.Optimize(options.optimizationLevel, options.timePasses))
+    {
+        return false;
+    }
+
+    if (options.escapeReport)
+    {
+        std::string report;
+        llvm::raw_string_ostream reportStream(report);
+        codegen.PrintEscapeReport(reportStream);
+        llvm::errs() << reportStream.str();
+    }
+
+    return true;
+}
+
+// Runs the whole pipeline for one source file. Every call owns its LLVMContext, which is what
+// makes it safe to compile several files at once on different threads.
+bool CompileFile(const CompileOptions &options, const std::string &filePath, EmitKind kind,
+                 const std::string &outputPath)
+{
+    llvm::LLVMContext context;
+    CodeGenerator codegen(context);
+
+    if (!Generate(options, filePath, codegen))
+    {
+        return false;
+    }
+
+    // Without an explicit output the IR goes to stdout, as it always has
+    if (kind == EmitKind::LLVM && outputPath.empty())
+    {
+        codegen.DumpIR();
+        return true;
+    }
+
+    return codegen.Emit(kind, outputPath);
+}
+
+bool CompileAll(const CompileOptions &options, EmitKind kind, const std::vector<std::string> &outputPaths)
+{
+    size_t fileCount = options.filePaths.size();
+    unsigned jobs = options.jobs == 0 ? llvm::hardware_concurrency().compute_thread_count() : options.jobs;
+
+    llvm::ThreadPool pool(llvm::hardware_concurrency(std::min<unsigned>(jobs, fileCount)));
+
+    std::vector<std::shared_future<bool>> results;
+    results.reserve(fileCount);
+
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        results.push_back(pool.async([&options, &outputPaths, kind, i] {
+            return CompileFile(options, options.filePaths[i], kind, outputPaths[i]);
+        }));
+    }
+
+    pool.wait();
+
+    return std::all_of(results.begin(), results.end(), [](const std::shared_future<bool> &result) {
+        return result.get();
+    });
+}
+
+bool CompileExecutable(const CompileOptions &options, const std::string &outputPath)
+{
+    std::vector<std::string> objectPaths;
+
+    for (size_t i = 0; i < options.filePaths.size(); ++i)
+    {
+        llvm::SmallString<128> objectPath;
+        if (llvm::sys::fs::createTemporaryFile("jlang", "o", objectPath))
+        {
+            std::cerr << "Error: Cannot create a temporary object file\n";
+            break;
+        }
+        objectPaths.push_back(std::string(objectPath));
+    }
+
+    bool isLinked = objectPaths.size() == options.filePaths.size() &&
+                    CompileAll(options, EmitKind::Object, objectPaths) && Link(objectPaths, outputPath);
+
+    for (const auto &objectPath : objectPaths)
+    {
+        llvm::sys::fs::remove(objectPath);
+    }
+
+    return isLinked;
+}
+
+bool Compile(const CompileOptions &options)
+{
+    if (options.emitKind == EmitKind::Executable)
+    {
+        std::string outputPath = options.outputPath.empty() ? "a.out" : options.outputPath;
+        return CompileExecutable(options, outputPath);
+    }
+
+    // A single file keeps the classic behavior: -o names the output, and no -o prints IR to stdout
+    if (options.filePaths.size() == 1)
+    {
+        std::string outputPath = options.outputPath;
+        if (outputPath.empty() && options.emitKind != EmitKind::LLVM)
+        {
+            outputPath = DefaultOutputPath(options.filePaths[0], options.emitKind);
+        }
+        return CompileAll(options, options.emitKind, {outputPath});
+    }
+
+    if (!options.outputPath.empty())
+    {
+        std::cerr << "Error: -o with multiple inputs is only supported when linking an executable\n";
+        return false;
+    }
+
+    std::vector<std::string> outputPaths;
+    std::unordered_set<std::string> seenOutputs;
+
+    for (const auto &filePath : options.filePaths)
+    {
+        std::string outputPath = DefaultOutputPath(filePath, options.emitKind);
+        if (!seenOutputs.insert(outputPath).second)
+        {
+            std::cerr << "Error: Multiple inputs would be written to '" << outputPath << "'\n";
+            return false;
+        }
+        outputPaths.push_back(outputPath);
+    }
+
+    return CompileAll(options, options.emitKind, outputPaths);
+}
+
+int Run(const CompileOptions &options)
+{
+    auto context = std::make_unique<llvm::LLVMContext>();
+    CodeGenerator codegen(*context);
+
+    // Generate fails for a module the verifier rejects, which must never be executed
+    if (!Generate(options, options.filePaths[0], codegen))
+    {
+        return 1;
+    }
+
+    // The JIT takes ownership of the module and its context, codegen must not be used afterwards
+    JitRunner runner;
+    std::optional<int> exitCode = runner.Run(codegen.TakeModule(), std::move(context));
+
+    return exitCode.value_or(1);
+}
+
+bool ParseOptimizationLevel(const std::string &arg, OptimizationLevel &level)
+{
+    static const std::unordered_map<std::string, OptimizationLevel> levels = {
+        {"-O0", OptimizationLevel::O0}, {"-O1", OptimizationLevel::O1}, {"-O2", OptimizationLevel::O2},
+        {"-O3", OptimizationLevel::O3}, {"-Os", OptimizationLevel::Os},
+    };
+
+    auto it = levels.find(arg);
+    if (it == levels.end())
+    {
+        return false;
+    }
+
+    level = it->second;
+    return true;
+}
+
+bool ParseEmitKind(const std::string &value, EmitKind &kind)
+{
+    static const std::unordered_map<std::string, EmitKind> kinds = {
+        {"llvm", EmitKind::LLVM}, {"bc", EmitKind::Bitcode},         {"asm", EmitKind::Assembly},
+        {"obj", EmitKind::Object}, {"exe", EmitKind::Executable},
+    };
+
+    auto it = kinds.find(value);
+    if (it == kinds.end())
+    {
+        return false;
+    }
+
+    kind = it->second;
+    return true;
+}
+
+bool ParseJobs(const std::string &value, unsigned &jobs)
+{
+    // Ten digits cannot overflow stoull, the range check then rejects what does not fit an unsigned
+    if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 10)
+    {
+        return false;
+    }
+
+    uint64_t count = std::stoull(value);
+    if (count == 0 || count > std::numeric_limits<unsigned>::max())
+    {
+        return false;
+    }
+
+    jobs = static_cast<unsigned>(count);
+    return true;
+}
+
+void PrintUsage()
+{
+    std::cerr << "Usage: Jlang [-O0|-O1|-O2|-O3|-Os] [--time-passes] [--layout-report] [--escape-report] "
+                 "[--emit=llvm|bc|asm|obj|exe] [-o <path>] [-j <jobs>] <source_file.j>...\n"
+                 "       Jlang run [-O0|-O1|-O2|-O3|-Os] [--time-passes] [--layout-report] [--escape-report] "
+                 "<source_file.j>\n";
 }
 
 int main(int argc, char *argv[])
 {
-    if (argc < 2)
+    CompileOptions options;
+
+    int firstArg = 1;
+    if (argc > 1 && std::string(argv[1]) == "run")
+    {
+        options.runInJit = true;
+        firstArg = 2;
+    }
+
+    for (int i = firstArg; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        if (ParseOptimizationLevel(arg, options.optimizationLevel))
+        {
+            continue;
+        }
+
+        if (arg == "--time-passes")
+        {
+            options.timePasses = true;
+        }
+        else if (arg == "--layout-report")
+        {
+            options.layoutReport = true;
+        }
+        else if (arg == "--escape-report")
+        {
+            options.escapeReport = true;
+        }
+        else if (arg.rfind("--emit=", 0) == 0)
+        {
+            if (!ParseEmitKind(arg.substr(7), options.emitKind))
+            {
+                std::cerr << "Error: Unknown emit kind: " << arg.substr(7) << "\n";
+                return 1;
+            }
+            options.isEmitKindSet = true;
+        }
+        else if (arg == "-o")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: Missing path after -o\n";
+                return 1;
+            }
+            options.outputPath = argv[++i];
+        }
+        else if (arg.rfind("-j", 0) == 0)
+        {
+            std::string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+            if (!ParseJobs(value, options.jobs))
+            {
+                std::cerr << "Error: -j expects a positive number of jobs\n";
+                return 1;
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            return 1;
+        }
+        else
+        {
+            options.filePaths.push_back(arg);
+        }
+    }
+
+    if (options.filePaths.empty())
     {
-        std::cerr << "Usage: Jlang <source_file.j>\n";
+        PrintUsage();
         return 1;
     }
 
-    Compile(argv[1]);
-    return 0;
+    if (options.runInJit)
+    {
+        if (options.isEmitKindSet || !options.outputPath.empty())
+        {
+            std::cerr << "Error: 'run' executes the program in memory and does not accept --emit or -o\n";
+            return 1;
+        }
+
+        if (options.filePaths.size() != 1)
+        {
+            std::cerr << "Error: 'run' expects exactly one source file\n";
+            return 1;
+        }
+
+        return Run(options);
+    }
+
+    // An output path without an explicit emit kind means "build me a program", and several
+    // inputs without one mean "one object file per input"
+    if (!options.isEmitKindSet && !options.outputPath.empty())
+    {
+        options.emitKind = EmitKind::Executable;
+    }
+    else if (!options.isEmitKindSet && options.filePaths.size() > 1)
+    {
+        options.emitKind = EmitKind::Object;
+    }
+
+    return Compile(options) ? 0 : 1;
 }
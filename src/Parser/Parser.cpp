@@ -2,17 +2,98 @@
 
 #include "../Common/Logger.h"
 
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <cstdint>
 #include <unordered_set>
 
 namespace jlang
 {
 
-Parser::Parser(const std::vector<Token> &tokens) : m_Tokens(tokens), m_CurrentPosition(0) {}
+// Binding power of every binary operator token, loosest first. Tokens that are not binary operators
+// keep precedence 0, which is below any minimum and ends the expression.
+struct BinaryOperatorInfo
+{
+    int precedence = 0;
+    BinaryOp op = BinaryOp::Add;
+};
+
+static constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::Unknown) + 1;
+
+static const std::array<BinaryOperatorInfo, TOKEN_TYPE_COUNT> s_BinaryOperators = [] {
+    std::array<BinaryOperatorInfo, TOKEN_TYPE_COUNT> table{};
+
+    auto set = [&table](TokenType type, int precedence, BinaryOp op) {
+        table[static_cast<size_t>(type)] = BinaryOperatorInfo{precedence, op};
+    };
+
+    set(TokenType::Or, 1, BinaryOp::LogicalOr);
+    set(TokenType::OrKeyword, 1, BinaryOp::EagerOr);
+    set(TokenType::And, 2, BinaryOp::LogicalAnd);
+    set(TokenType::AndKeyword, 2, BinaryOp::EagerAnd);
+    set(TokenType::Pipe, 3, BinaryOp::BitOr);
+    set(TokenType::Caret, 4, BinaryOp::BitXor);
+    set(TokenType::Ampersand, 5, BinaryOp::BitAnd);
+    set(TokenType::EqualEqual, 6, BinaryOp::Equal);
+    set(TokenType::NotEqual, 6, BinaryOp::NotEqual);
+    set(TokenType::Less, 7, BinaryOp::Less);
+    set(TokenType::LessEqual, 7, BinaryOp::LessEqual);
+    set(TokenType::Greater, 7, BinaryOp::Greater);
+    set(TokenType::GreaterEqual, 7, BinaryOp::GreaterEqual);
+    set(TokenType::LeftShift, 8, BinaryOp::Shl);
+    set(TokenType::RightShift, 8, BinaryOp::Shr);
+    set(TokenType::Plus, 9, BinaryOp::Add);
+    set(TokenType::Minus, 9, BinaryOp::Sub);
+    set(TokenType::Star, 10, BinaryOp::Mul);
+    set(TokenType::Slash, 10, BinaryOp::Div);
+    set(TokenType::Percent, 10, BinaryOp::Mod);
+
+    return table;
+}();
+
+static const BinaryOperatorInfo &GetBinaryOperatorInfo(TokenType type)
+{
+    return s_BinaryOperators[static_cast<size_t>(type)];
+}
+
+static std::optional<BinaryOp> ToCompoundAssignmentOp(TokenType type)
+{
+    switch (type)
+    {
+    case TokenType::PlusEqual:
+        return BinaryOp::Add;
+    case TokenType::MinusEqual:
+        return BinaryOp::Sub;
+    case TokenType::StarEqual:
+        return BinaryOp::Mul;
+    case TokenType::SlashEqual:
+        return BinaryOp::Div;
+    case TokenType::PercentEqual:
+        return BinaryOp::Mod;
+    case TokenType::AmpersandEqual:
+        return BinaryOp::BitAnd;
+    case TokenType::PipeEqual:
+        return BinaryOp::BitOr;
+    case TokenType::CaretEqual:
+        return BinaryOp::BitXor;
+    case TokenType::LeftShiftEqual:
+        return BinaryOp::Shl;
+    case TokenType::RightShiftEqual:
+        return BinaryOp::Shr;
+    default:
+        return std::nullopt;
+    }
+}
+
+Parser::Parser(const std::vector<Token> &tokens, AstArena &arena)
+    : m_Tokens(tokens), m_Arena(arena), m_CurrentPosition(0)
+{
+}
 
-std::vector<std::shared_ptr<AstNode>> Parser::Parse()
+std::vector<AstNode *> Parser::Parse()
 {
-    std::vector<std::shared_ptr<AstNode>> program;
+    std::vector<AstNode *> program;
 
     while (!IsEndReached())
     {
@@ -63,6 +144,12 @@ const Token &Parser::Peek() const
     return m_Tokens[m_CurrentPosition];
 }
 
+bool Parser::CheckAhead(size_t distance, TokenType type) const
+{
+    size_t position = std::min(m_CurrentPosition + distance, m_Tokens.size() - 1);
+    return m_Tokens[position].m_type == type;
+}
+
 const Token &Parser::Previous() const
 {
     return m_Tokens[m_CurrentPosition - 1];
@@ -73,21 +160,28 @@ bool Parser::IsEndReached() const
     return Peek().m_type == TokenType::EndOfFile;
 }
 
-std::shared_ptr<AstNode> Parser::ParseDeclaration()
+AstNode *Parser::ParseDeclaration()
 {
+    // Attributes belong to the struct or function that follows them: #[repr(C)] struct, #[noinline] fn
+    std::vector<Attribute> attributes = ParseAttributes();
+
     if (Check(TokenType::Interface))
     {
+        if (!attributes.empty())
+        {
+            JLANG_ERROR("Interfaces do not take attributes");
+        }
         return ParseInterface();
     }
 
     if (Check(TokenType::Struct))
     {
-        return ParseStruct();
+        return ParseStruct(std::move(attributes));
     }
 
-    if (Check(TokenType::Fn))
+    if (Check(TokenType::Fn) || Check(TokenType::Inline) || !attributes.empty())
     {
-        return ParseFunction();
+        return ParseFunction(std::move(attributes));
     }
 
     Advance();
@@ -95,7 +189,7 @@ std::shared_ptr<AstNode> Parser::ParseDeclaration()
     return nullptr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseInterface()
+AstNode *Parser::ParseInterface()
 {
     Advance();
 
@@ -104,14 +198,14 @@ std::shared_ptr<AstNode> Parser::ParseInterface()
         JLANG_ERROR("Expected interface name");
     }
 
-    const std::string &name = Previous().m_lexeme;
+    const std::string name(Previous().m_lexeme);
 
     if (!IsMatched(TokenType::LBrace))
     {
         JLANG_ERROR("Expected '{' after interface name!");
     }
 
-    auto interfaceDeclNode = std::make_shared<InterfaceDecl>();
+    auto *interfaceDeclNode = m_Arena.Make<InterfaceDecl>();
     interfaceDeclNode->name = name;
 
     while (!Check(TokenType::RBrace) && !IsEndReached())
@@ -130,7 +224,7 @@ std::shared_ptr<AstNode> Parser::ParseInterface()
             continue;
         }
 
-        std::string methodName = Previous().m_lexeme;
+        std::string methodName(Previous().m_lexeme);
 
         if (!IsMatched(TokenType::LParen) || !IsMatched(TokenType::RParen) ||
             !IsMatched(TokenType::Semicolon))
@@ -156,7 +250,7 @@ std::shared_ptr<AstNode> Parser::ParseInterface()
     return interfaceDeclNode;
 }
 
-std::shared_ptr<AstNode> Parser::ParseStruct()
+AstNode *Parser::ParseStruct(std::vector<Attribute> attributes)
 {
     Advance(); // consume 'struct'
 
@@ -165,7 +259,7 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
         JLANG_ERROR("Expected struct name");
     }
 
-    const std::string name = Previous().m_lexeme;
+    const std::string name(Previous().m_lexeme);
 
     std::string implementedInterface;
 
@@ -185,13 +279,16 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
         JLANG_ERROR("Expected '{' after struct declaration");
     }
 
-    auto structDeclNode = std::make_shared<StructDecl>();
+    auto *structDeclNode = m_Arena.Make<StructDecl>();
     structDeclNode->name = name;
     structDeclNode->interfaceImplemented = implementedInterface;
+    structDeclNode->attributes = std::move(attributes);
 
-    // Parse fields: fieldName: Type;
+    // Parse fields: #[attributes] fieldName: Type;
     while (!Check(TokenType::RBrace) && !IsEndReached())
     {
+        std::vector<Attribute> fieldAttributes = ParseAttributes();
+
         if (!IsMatched(TokenType::Identifier))
         {
             JLANG_ERROR("Expected field name");
@@ -204,7 +301,7 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
             continue;
         }
 
-        std::string fieldName = Previous().m_lexeme;
+        std::string fieldName(Previous().m_lexeme);
 
         // Expect colon after field name
         if (!IsMatched(TokenType::Colon))
@@ -219,8 +316,8 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
         }
 
         // Parse field type
-        std::string typeName = ParseTypeName();
-        if (typeName.empty())
+        TypeRef fieldType = ParseType();
+        if (!fieldType.IsKnown())
         {
             JLANG_ERROR("Expected field type");
             while (!IsEndReached() && !Check(TokenType::Semicolon) && !Check(TokenType::RBrace))
@@ -231,27 +328,13 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
             continue;
         }
 
-        bool isPointer = IsMatched(TokenType::Star);
-
-        bool isNullable = false;
-        if (isPointer && IsMatched(TokenType::Question))
-        {
-            isNullable = true;
-        }
-        else if (!isPointer && Check(TokenType::Question))
-        {
-            JLANG_ERROR("Only pointer types can be nullable. Use '" + typeName + "*?' instead of '" +
-                        typeName + "?'");
-            Advance();
-        }
-
         if (!IsMatched(TokenType::Semicolon))
         {
             JLANG_ERROR("Expected ';' after struct field");
         }
 
         bool isPublic = !fieldName.empty() && std::isupper(static_cast<unsigned char>(fieldName[0]));
-        StructField field{fieldName, TypeRef{typeName, isPointer, isNullable}, isPublic};
+        StructField field{fieldName, fieldType, isPublic, std::move(fieldAttributes)};
         structDeclNode->fields.push_back(field);
     }
 
@@ -263,16 +346,23 @@ std::shared_ptr<AstNode> Parser::ParseStruct()
     return structDeclNode;
 }
 
-std::shared_ptr<AstNode> Parser::ParseFunction()
+AstNode *Parser::ParseFunction(std::vector<Attribute> attributes)
 {
-    Advance(); // consume 'fn'
+    // 'inline' follows the attributes: #[noinline] fn cold() or inline fn get()
+    bool isInline = IsMatched(TokenType::Inline);
+
+    if (!IsMatched(TokenType::Fn))
+    {
+        JLANG_ERROR("Expected 'fn' after function attributes");
+        return nullptr;
+    }
 
     if (!IsMatched(TokenType::Identifier))
     {
         JLANG_ERROR("Expected function name!");
     }
 
-    const std::string &functionName = Previous().m_lexeme;
+    const std::string functionName(Previous().m_lexeme);
 
     // Parse parameter list: (name: Type, name: Type, ...)
     if (!IsMatched(TokenType::LParen))
@@ -291,7 +381,7 @@ std::shared_ptr<AstNode> Parser::ParseFunction()
                 JLANG_ERROR("Expected parameter name");
                 break;
             }
-            std::string paramName = Previous().m_lexeme;
+            std::string paramName(Previous().m_lexeme);
 
             if (!IsMatched(TokenType::Colon))
             {
@@ -299,28 +389,14 @@ std::shared_ptr<AstNode> Parser::ParseFunction()
                 break;
             }
 
-            std::string typeName = ParseTypeName();
-            if (typeName.empty())
+            TypeRef paramType = ParseType();
+            if (!paramType.IsKnown())
             {
                 JLANG_ERROR("Expected parameter type");
                 break;
             }
 
-            bool isPointer = IsMatched(TokenType::Star);
-
-            bool isNullable = false;
-            if (isPointer && IsMatched(TokenType::Question))
-            {
-                isNullable = true;
-            }
-            else if (!isPointer && Check(TokenType::Question))
-            {
-                JLANG_ERROR("Only pointer types can be nullable. Use '" + typeName + "*?' instead of '" +
-                            typeName + "?'");
-                Advance();
-            }
-
-            params.push_back(Parameter{paramName, TypeRef{typeName, isPointer, isNullable}});
+            params.push_back(Parameter{paramName, paramType});
 
         } while (IsMatched(TokenType::Comma));
     }
@@ -335,47 +411,36 @@ std::shared_ptr<AstNode> Parser::ParseFunction()
 
     if (IsMatched(TokenType::Arrow))
     {
-        std::string returnTypeName = ParseTypeName();
-        if (returnTypeName.empty())
+        returnType = ParseType();
+        if (!returnType.IsKnown())
         {
             JLANG_ERROR("Expected return type after '->'");
         }
-        bool isPointer = IsMatched(TokenType::Star);
-
-        bool isNullable = false;
-        if (isPointer && IsMatched(TokenType::Question))
-        {
-            isNullable = true;
-        }
-        else if (!isPointer && Check(TokenType::Question))
-        {
-            JLANG_ERROR("Only pointer types can be nullable. Use '" + returnTypeName + "*?' instead of '" +
-                        returnTypeName + "?'");
-            Advance();
-        }
-
-        returnType = TypeRef{returnTypeName, isPointer, isNullable};
     }
 
     auto body = ParseBlock();
 
-    auto functionDeclNode = std::make_shared<FunctionDecl>();
+    auto *functionDeclNode = m_Arena.Make<FunctionDecl>();
     functionDeclNode->name = functionName;
     functionDeclNode->params = params;
     functionDeclNode->returnType = returnType;
     functionDeclNode->body = body;
+    functionDeclNode->isPublic =
+        !functionName.empty() && std::isupper(static_cast<unsigned char>(functionName[0]));
+    functionDeclNode->isInline = isInline;
+    functionDeclNode->attributes = std::move(attributes);
 
     return functionDeclNode;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBlock()
+AstNode *Parser::ParseBlock()
 {
     if (!IsMatched(TokenType::LBrace))
     {
         JLANG_ERROR("Expected '{' at the beginning of the block");
     }
 
-    auto blockStmt = std::make_shared<BlockStatement>();
+    auto *blockStmt = m_Arena.Make<BlockStatement>();
 
     while (!Check(TokenType::RBrace) && !IsEndReached())
     {
@@ -395,8 +460,29 @@ std::shared_ptr<AstNode> Parser::ParseBlock()
     return blockStmt;
 }
 
-std::shared_ptr<AstNode> Parser::ParseStatement()
+AstNode *Parser::ParseStatement()
 {
+    if (Check(TokenType::Hash))
+    {
+        std::vector<Attribute> attributes = ParseAttributes();
+        AstNode *statement = ParseStatement();
+
+        if (auto *forStmt = dynamic_cast<ForStatement *>(statement))
+        {
+            forStmt->attributes = std::move(attributes);
+        }
+        else if (auto *whileStmt = dynamic_cast<WhileStatement *>(statement))
+        {
+            whileStmt->attributes = std::move(attributes);
+        }
+        else
+        {
+            JLANG_ERROR("Attributes inside a function body can only be applied to 'for' and 'while' loops");
+        }
+
+        return statement;
+    }
+
     if (Check(TokenType::If))
     {
         return ParseIfStatement();
@@ -422,6 +508,11 @@ std::shared_ptr<AstNode> Parser::ParseStatement()
         return ParseReturnStatement();
     }
 
+    if (Check(TokenType::Match))
+    {
+        return ParseMatchStatement();
+    }
+
     if (Check(TokenType::LBrace))
     {
         return ParseBlock();
@@ -430,11 +521,64 @@ std::shared_ptr<AstNode> Parser::ParseStatement()
     return ParseExprStatement();
 }
 
-std::shared_ptr<AstNode> Parser::ParseReturnStatement()
+// Parses one or more attribute groups: #[name, name(arg, ...)] #[...]
+std::vector<Attribute> Parser::ParseAttributes()
+{
+    std::vector<Attribute> attributes;
+
+    while (IsMatched(TokenType::Hash))
+    {
+        if (!IsMatched(TokenType::LBracket))
+        {
+            JLANG_ERROR("Expected '[' after '#'");
+            return attributes;
+        }
+
+        do
+        {
+            if (!IsMatched(TokenType::Identifier))
+            {
+                JLANG_ERROR("Expected attribute name");
+                break;
+            }
+
+            Attribute attribute;
+            attribute.name = Previous().m_lexeme;
+
+            if (IsMatched(TokenType::LParen))
+            {
+                while (!Check(TokenType::RParen) && !IsEndReached())
+                {
+                    attribute.args.emplace_back(Advance().m_lexeme);
+                    if (!IsMatched(TokenType::Comma))
+                    {
+                        break;
+                    }
+                }
+
+                if (!IsMatched(TokenType::RParen))
+                {
+                    JLANG_ERROR(STR("Expected ')' after the arguments of '%s'", attribute.name.c_str()));
+                }
+            }
+
+            attributes.push_back(std::move(attribute));
+        } while (IsMatched(TokenType::Comma));
+
+        if (!IsMatched(TokenType::RBracket))
+        {
+            JLANG_ERROR("Expected ']' to close attribute");
+        }
+    }
+
+    return attributes;
+}
+
+AstNode *Parser::ParseReturnStatement()
 {
     Advance(); // consume 'return'
 
-    std::shared_ptr<AstNode> value = nullptr;
+    AstNode *value = nullptr;
 
     // Check if there's a return value (not just "return;")
     if (!Check(TokenType::Semicolon))
@@ -447,13 +591,93 @@ std::shared_ptr<AstNode> Parser::ParseReturnStatement()
         JLANG_ERROR("Expected ';' after return statement");
     }
 
-    auto returnStmt = std::make_shared<ReturnStatement>();
+    auto *returnStmt = m_Arena.Make<ReturnStatement>();
     returnStmt->value = value;
 
     return returnStmt;
 }
 
-std::shared_ptr<AstNode> Parser::ParseVarDecl()
+AstNode *Parser::ParseMatchStatement()
+{
+    Advance(); // consume 'match'
+
+    if (!IsMatched(TokenType::LParen))
+    {
+        JLANG_ERROR("Expected '(' after 'match'");
+    }
+
+    auto *matchStmt = m_Arena.Make<MatchStatement>();
+    matchStmt->value = ParseExpression();
+
+    if (!IsMatched(TokenType::RParen))
+    {
+        JLANG_ERROR("Expected ')' after match value");
+    }
+
+    if (!IsMatched(TokenType::LBrace))
+    {
+        JLANG_ERROR("Expected '{' to open the match arms");
+        return matchStmt;
+    }
+
+    while (!Check(TokenType::RBrace) && !IsEndReached())
+    {
+        size_t armStart = m_CurrentPosition;
+        MatchArm arm;
+
+        if (Check(TokenType::Identifier) && Peek().m_lexeme == "_")
+        {
+            Advance();
+            arm.isWildcard = true;
+        }
+        else
+        {
+            // 1 | 2 | 5..=9 | 'a'..'f'
+            do
+            {
+                MatchPattern pattern;
+                pattern.low = ParsePrimary();
+
+                if (IsMatched(TokenType::DotDot) || IsMatched(TokenType::DotDotEqual))
+                {
+                    pattern.isInclusive = Previous().m_type == TokenType::DotDotEqual;
+                    pattern.high = ParsePrimary();
+                }
+
+                arm.patterns.push_back(pattern);
+            } while (IsMatched(TokenType::Pipe));
+        }
+
+        if (!IsMatched(TokenType::FatArrow))
+        {
+            JLANG_ERROR("Expected '=>' after match pattern");
+        }
+
+        arm.body = ParseStatement();
+        IsMatched(TokenType::Comma);
+
+        if (!matchStmt->arms.empty() && matchStmt->arms.back().isWildcard)
+        {
+            JLANG_ERROR("The '_' arm must be the last arm of a match");
+        }
+        matchStmt->arms.push_back(arm);
+
+        // A malformed arm that consumed nothing would otherwise loop forever
+        if (m_CurrentPosition == armStart)
+        {
+            Advance();
+        }
+    }
+
+    if (!IsMatched(TokenType::RBrace))
+    {
+        JLANG_ERROR("Expected '}' after the match arms");
+    }
+
+    return matchStmt;
+}
+
+AstNode *Parser::ParseVarDecl()
 {
     bool isMutable = Check(TokenType::Var);
     Advance(); // consume 'var' or 'val'
@@ -465,12 +689,10 @@ std::shared_ptr<AstNode> Parser::ParseVarDecl()
         return nullptr;
     }
 
-    std::string varName = Previous().m_lexeme;
+    std::string varName(Previous().m_lexeme);
 
-    std::string typeName;
-    bool isPointer = false;
-    bool isNullable = false;
-    std::shared_ptr<AstNode> initializer = nullptr;
+    TypeRef varType;
+    AstNode *initializer = nullptr;
 
     // Check for type inference syntax: var x := expr;
     if (IsMatched(TokenType::ColonEqual))
@@ -493,26 +715,13 @@ std::shared_ptr<AstNode> Parser::ParseVarDecl()
         }
 
         // Parse type
-        typeName = ParseTypeName();
-        if (typeName.empty())
+        varType = ParseType();
+        if (!varType.IsKnown())
         {
             JLANG_ERROR("Expected variable type");
             return nullptr;
         }
 
-        isPointer = IsMatched(TokenType::Star);
-
-        if (isPointer && IsMatched(TokenType::Question))
-        {
-            isNullable = true;
-        }
-        else if (!isPointer && Check(TokenType::Question))
-        {
-            JLANG_ERROR("Only pointer types can be nullable. Use '" + typeName + "*?' instead of '" +
-                        typeName + "?'");
-            Advance();
-        }
-
         if (IsMatched(TokenType::Equal))
         {
             initializer = ParseExpression();
@@ -524,16 +733,16 @@ std::shared_ptr<AstNode> Parser::ParseVarDecl()
         JLANG_ERROR("Expected ';' after variable declaration");
     }
 
-    auto varDecl = std::make_shared<VariableDecl>();
+    auto *varDecl = m_Arena.Make<VariableDecl>();
     varDecl->name = varName;
-    varDecl->varType = TypeRef{typeName, isPointer, isNullable};
+    varDecl->varType = varType;
     varDecl->initializer = initializer;
     varDecl->isMutable = isMutable;
 
     return varDecl;
 }
 
-std::shared_ptr<AstNode> Parser::ParseIfStatement()
+AstNode *Parser::ParseIfStatement()
 {
     Advance();
 
@@ -551,13 +760,13 @@ std::shared_ptr<AstNode> Parser::ParseIfStatement()
 
     auto thenBranch = ParseStatement();
 
-    std::shared_ptr<AstNode> elseBranch = nullptr;
+    AstNode *elseBranch = nullptr;
     if (IsMatched(TokenType::Else))
     {
         elseBranch = ParseStatement();
     }
 
-    auto node = std::make_shared<IfStatement>();
+    auto *node = m_Arena.Make<IfStatement>();
 
     node->condition = condition;
     node->thenBranch = thenBranch;
@@ -566,7 +775,7 @@ std::shared_ptr<AstNode> Parser::ParseIfStatement()
     return node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseWhileStatement()
+AstNode *Parser::ParseWhileStatement()
 {
     Advance(); // consume 'while'
 
@@ -584,14 +793,14 @@ std::shared_ptr<AstNode> Parser::ParseWhileStatement()
 
     auto body = ParseStatement();
 
-    auto node = std::make_shared<WhileStatement>();
+    auto *node = m_Arena.Make<WhileStatement>();
     node->condition = condition;
     node->body = body;
 
     return node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseForStatement()
+AstNode *Parser::ParseForStatement()
 {
     Advance(); // consume 'for'
 
@@ -601,7 +810,7 @@ std::shared_ptr<AstNode> Parser::ParseForStatement()
     }
 
     // Parse initializer (var decl or expression statement, or empty)
-    std::shared_ptr<AstNode> init = nullptr;
+    AstNode *init = nullptr;
     if (Check(TokenType::Semicolon))
     {
         Advance(); // empty initializer
@@ -616,7 +825,7 @@ std::shared_ptr<AstNode> Parser::ParseForStatement()
     }
 
     // Parse condition (or empty for infinite loop)
-    std::shared_ptr<AstNode> condition = nullptr;
+    AstNode *condition = nullptr;
     if (!Check(TokenType::Semicolon))
     {
         condition = ParseExpression();
@@ -628,7 +837,7 @@ std::shared_ptr<AstNode> Parser::ParseForStatement()
     }
 
     // Parse update expression (or empty)
-    std::shared_ptr<AstNode> update = nullptr;
+    AstNode *update = nullptr;
     if (!Check(TokenType::RParen))
     {
         update = ParseExpression();
@@ -641,7 +850,7 @@ std::shared_ptr<AstNode> Parser::ParseForStatement()
 
     auto body = ParseStatement();
 
-    auto node = std::make_shared<ForStatement>();
+    auto *node = m_Arena.Make<ForStatement>();
     node->init = init;
     node->condition = condition;
     node->update = update;
@@ -650,23 +859,37 @@ std::shared_ptr<AstNode> Parser::ParseForStatement()
     return node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseExpression()
+AstNode *Parser::ParseExpression()
 {
-    auto expr = ParseLogicalOr();
+    auto expr = ParseBinary(1);
 
-    // Handle assignment: identifier = expression
+    // Handle assignment: identifier = expression, a[i] = expression, p.Field = expression
     if (IsMatched(TokenType::Equal))
     {
         auto value = ParseExpression();
 
         // Check if left side is a variable
-        if (auto varExpr = std::dynamic_pointer_cast<VarExpr>(expr))
+        if (auto *varExpr = dynamic_cast<VarExpr *>(expr))
         {
-            auto assign = std::make_shared<AssignExpr>();
+            auto *assign = m_Arena.Make<AssignExpr>();
             assign->name = varExpr->name;
             assign->value = value;
             return assign;
         }
+        else if (auto *indexExpr = dynamic_cast<IndexExpr *>(expr))
+        {
+            auto *assign = m_Arena.Make<IndexAssignExpr>();
+            assign->target = indexExpr;
+            assign->value = value;
+            return assign;
+        }
+        else if (auto *memberExpr = dynamic_cast<MemberAccessExpr *>(expr))
+        {
+            auto *assign = m_Arena.Make<MemberAssignExpr>();
+            assign->target = memberExpr;
+            assign->value = value;
+            return assign;
+        }
         else
         {
             JLANG_ERROR("Invalid assignment target");
@@ -674,64 +897,42 @@ std::shared_ptr<AstNode> Parser::ParseExpression()
     }
 
     // Handle compound assignment: x += expr  =>  x = x + expr
-    std::string compoundOp;
-    if (IsMatched(TokenType::PlusEqual))
-    {
-        compoundOp = "+";
-    }
-    else if (IsMatched(TokenType::MinusEqual))
-    {
-        compoundOp = "-";
-    }
-    else if (IsMatched(TokenType::StarEqual))
-    {
-        compoundOp = "*";
-    }
-    else if (IsMatched(TokenType::SlashEqual))
-    {
-        compoundOp = "/";
-    }
-    else if (IsMatched(TokenType::PercentEqual))
-    {
-        compoundOp = "%";
-    }
-    else if (IsMatched(TokenType::AmpersandEqual))
-    {
-        compoundOp = "&";
-    }
-    else if (IsMatched(TokenType::PipeEqual))
-    {
-        compoundOp = "|";
-    }
-    else if (IsMatched(TokenType::CaretEqual))
-    {
-        compoundOp = "^";
-    }
-    else if (IsMatched(TokenType::LeftShiftEqual))
-    {
-        compoundOp = "<<";
-    }
-    else if (IsMatched(TokenType::RightShiftEqual))
-    {
-        compoundOp = ">>";
-    }
-
-    if (!compoundOp.empty())
+    std::optional<BinaryOp> compoundOp = ToCompoundAssignmentOp(Peek().m_type);
+    if (compoundOp)
     {
+        Advance();
         auto rhs = ParseExpression();
 
-        if (auto varExpr = std::dynamic_pointer_cast<VarExpr>(expr))
+        if (auto *varExpr = dynamic_cast<VarExpr *>(expr))
         {
-            auto binary = std::make_shared<BinaryExpr>();
-            binary->op = compoundOp;
+            auto *binary = m_Arena.Make<BinaryExpr>();
+            binary->op = *compoundOp;
             binary->left = expr;
             binary->right = rhs;
 
-            auto assign = std::make_shared<AssignExpr>();
+            auto *assign = m_Arena.Make<AssignExpr>();
             assign->name = varExpr->name;
             assign->value = binary;
             return assign;
         }
+        else if (auto *indexExpr = dynamic_cast<IndexExpr *>(expr))
+        {
+            // Not desugared, a[i++] += v must evaluate the index only once
+            auto *assign = m_Arena.Make<IndexAssignExpr>();
+            assign->target = indexExpr;
+            assign->value = rhs;
+            assign->compoundOp = compoundOp;
+            return assign;
+        }
+        else if (auto *memberExpr = dynamic_cast<MemberAccessExpr *>(expr))
+        {
+            // Not desugared either, ps[i++].X += v must evaluate ps[i++] only once
+            auto *assign = m_Arena.Make<MemberAssignExpr>();
+            assign->target = memberExpr;
+            assign->value = rhs;
+            assign->compoundOp = compoundOp;
+            return assign;
+        }
         else
         {
             JLANG_ERROR("Invalid compound assignment target");
@@ -741,196 +942,25 @@ std::shared_ptr<AstNode> Parser::ParseExpression()
     return expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseLogicalOr()
-{
-    auto left = ParseLogicalAnd();
-
-    while (Check(TokenType::Or) || Check(TokenType::OrKeyword))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseLogicalAnd();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseLogicalAnd()
-{
-    auto left = ParseBitwiseOr();
-
-    while (Check(TokenType::And) || Check(TokenType::AndKeyword))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseBitwiseOr();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseBitwiseOr()
-{
-    auto left = ParseBitwiseXor();
-
-    while (Check(TokenType::Pipe))
-    {
-        Advance();
-        auto right = ParseBitwiseXor();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = "|";
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseBitwiseXor()
-{
-    auto left = ParseBitwiseAnd();
-
-    while (Check(TokenType::Caret))
-    {
-        Advance();
-        auto right = ParseBitwiseAnd();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = "^";
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseBitwiseAnd()
-{
-    auto left = ParseEquality();
-
-    while (Check(TokenType::Ampersand))
-    {
-        Advance();
-        auto right = ParseEquality();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = "&";
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseEquality()
-{
-    auto left = ParseComparison();
-
-    while (Check(TokenType::EqualEqual) || Check(TokenType::NotEqual))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseComparison();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseComparison()
-{
-    auto left = ParseShift();
-
-    while (Check(TokenType::Less) || Check(TokenType::LessEqual) || Check(TokenType::Greater) ||
-           Check(TokenType::GreaterEqual))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseShift();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseShift()
-{
-    auto left = ParseAdditive();
-
-    while (Check(TokenType::LeftShift) || Check(TokenType::RightShift))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseAdditive();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseAdditive()
-{
-    auto left = ParseMultiplicative();
-
-    while (Check(TokenType::Plus) || Check(TokenType::Minus))
-    {
-        std::string op = Peek().m_lexeme;
-        Advance();
-        auto right = ParseMultiplicative();
-
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
-        binary->left = left;
-        binary->right = right;
-        left = binary;
-    }
-
-    return left;
-}
-
-std::shared_ptr<AstNode> Parser::ParseMultiplicative()
+AstNode *Parser::ParseBinary(int minPrecedence)
 {
     auto left = ParseUnary();
 
-    while (Check(TokenType::Star) || Check(TokenType::Slash) || Check(TokenType::Percent))
+    // Operators of at least minPrecedence are folded into the left operand. The right operand only
+    // takes strictly tighter operators, which makes every level left-associative.
+    while (true)
     {
-        std::string op = Peek().m_lexeme;
+        const BinaryOperatorInfo &info = GetBinaryOperatorInfo(Peek().m_type);
+        if (info.precedence < minPrecedence)
+        {
+            break;
+        }
+
         Advance();
-        auto right = ParseUnary();
+        auto right = ParseBinary(info.precedence + 1);
 
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->op = op;
+        auto *binary = m_Arena.Make<BinaryExpr>();
+        binary->op = info.op;
         binary->left = left;
         binary->right = right;
         left = binary;
@@ -939,15 +969,15 @@ std::shared_ptr<AstNode> Parser::ParseMultiplicative()
     return left;
 }
 
-std::shared_ptr<AstNode> Parser::ParseUnary()
+AstNode *Parser::ParseUnary()
 {
     if (Check(TokenType::Not) || Check(TokenType::Tilde))
     {
-        std::string op = Peek().m_lexeme;
+        UnaryOp op = Check(TokenType::Not) ? UnaryOp::Not : UnaryOp::BitNot;
         Advance();
         auto operand = ParseUnary();
 
-        auto unary = std::make_shared<UnaryExpr>();
+        auto *unary = m_Arena.Make<UnaryExpr>();
         unary->op = op;
         unary->operand = operand;
         return unary;
@@ -956,11 +986,11 @@ std::shared_ptr<AstNode> Parser::ParseUnary()
     // Handle prefix increment/decrement
     if (Check(TokenType::PlusPlus) || Check(TokenType::MinusMinus))
     {
-        std::string op = Peek().m_lexeme;
+        UnaryOp op = Check(TokenType::PlusPlus) ? UnaryOp::Increment : UnaryOp::Decrement;
         Advance();
         auto operand = ParseUnary();
 
-        auto prefix = std::make_shared<PrefixExpr>();
+        auto *prefix = m_Arena.Make<PrefixExpr>();
         prefix->op = op;
         prefix->operand = operand;
         return prefix;
@@ -969,17 +999,17 @@ std::shared_ptr<AstNode> Parser::ParseUnary()
     return ParsePostfix();
 }
 
-std::shared_ptr<AstNode> Parser::ParsePostfix()
+AstNode *Parser::ParsePostfix()
 {
     auto expr = ParsePrimary();
 
     // Handle postfix increment/decrement
     while (Check(TokenType::PlusPlus) || Check(TokenType::MinusMinus))
     {
-        std::string op = Peek().m_lexeme;
+        UnaryOp op = Check(TokenType::PlusPlus) ? UnaryOp::Increment : UnaryOp::Decrement;
         Advance();
 
-        auto postfix = std::make_shared<PostfixExpr>();
+        auto *postfix = m_Arena.Make<PostfixExpr>();
         postfix->op = op;
         postfix->operand = expr;
         expr = postfix;
@@ -988,7 +1018,7 @@ std::shared_ptr<AstNode> Parser::ParsePostfix()
     return expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseExprStatement()
+AstNode *Parser::ParseExprStatement()
 {
     auto expression = ParseExpression();
 
@@ -1008,18 +1038,18 @@ std::shared_ptr<AstNode> Parser::ParseExprStatement()
         JLANG_ERROR("Expected ';' after expression");
     }
 
-    auto stmt = std::make_shared<ExprStatement>();
+    auto *stmt = m_Arena.Make<ExprStatement>();
     stmt->expression = expression;
 
     return stmt;
 }
 
-std::shared_ptr<AstNode> Parser::ParsePrimary()
+AstNode *Parser::ParsePrimary()
 {
     // Handle null literal (keyword)
     if (IsMatched(TokenType::Null))
     {
-        auto literal = std::make_shared<LiteralExpr>();
+        auto *literal = m_Arena.Make<LiteralExpr>();
         literal->value = "null";
         return literal;
     }
@@ -1027,7 +1057,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle true literal
     if (IsMatched(TokenType::True))
     {
-        auto literal = std::make_shared<LiteralExpr>();
+        auto *literal = m_Arena.Make<LiteralExpr>();
         literal->value = "true";
         return literal;
     }
@@ -1035,7 +1065,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle false literal
     if (IsMatched(TokenType::False))
     {
-        auto literal = std::make_shared<LiteralExpr>();
+        auto *literal = m_Arena.Make<LiteralExpr>();
         literal->value = "false";
         return literal;
     }
@@ -1055,7 +1085,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
             return nullptr;
         }
 
-        std::string typeName = Previous().m_lexeme;
+        std::string typeName(Previous().m_lexeme);
 
         if (!IsMatched(TokenType::Greater))
         {
@@ -1069,7 +1099,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
             return nullptr;
         }
 
-        auto allocExpr = std::make_shared<AllocExpr>();
+        auto *allocExpr = m_Arena.Make<AllocExpr>();
         allocExpr->allocType = TypeRef{typeName, true}; // always returns a pointer
         return allocExpr;
     }
@@ -1089,7 +1119,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
                 return nullptr;
             }
 
-            std::string typeName = Previous().m_lexeme;
+            std::string typeName(Previous().m_lexeme);
             bool isPointer = IsMatched(TokenType::Star);
 
             bool isNullable = false;
@@ -1112,7 +1142,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
 
             auto expr = ParsePrimary();
 
-            auto cast = std::make_shared<CastExpr>();
+            auto *cast = m_Arena.Make<CastExpr>();
             cast->targetType = TypeRef{typeName, isPointer, isNullable};
             cast->expr = expr;
             return cast;
@@ -1132,12 +1162,12 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle identifiers, function calls, and member access
     if (IsMatched(TokenType::Identifier))
     {
-        std::string name = Previous().m_lexeme;
+        std::string name(Previous().m_lexeme);
 
         // Check for function call first (before member access)
         if (IsMatched(TokenType::LParen))
         {
-            auto call = std::make_shared<CallExpr>();
+            auto *call = m_Arena.Make<CallExpr>();
             call->callee = name;
 
             if (!Check(TokenType::RParen))
@@ -1157,21 +1187,45 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
             return call;
         }
 
+        // Name{ Field: value, ... } or Name{}, a block cannot start with 'identifier:' nor be empty here
+        if (Check(TokenType::LBrace) &&
+            (CheckAhead(1, TokenType::RBrace) ||
+             (CheckAhead(1, TokenType::Identifier) && CheckAhead(2, TokenType::Colon))))
+        {
+            return ParseStructLiteral(name);
+        }
+
         // Start with a variable expression
-        std::shared_ptr<AstNode> expr = std::make_shared<VarExpr>();
-        std::static_pointer_cast<VarExpr>(expr)->name = name;
+        AstNode *expr = m_Arena.Make<VarExpr>();
+        static_cast<VarExpr *>(expr)->name = name;
 
-        // Handle member access chain: obj.field1.field2
-        while (IsMatched(TokenType::Dot))
+        // Handle member access and indexing chains: obj.field1.field2, obj.items[i]
+        while (Check(TokenType::Dot) || Check(TokenType::LBracket))
         {
+            if (IsMatched(TokenType::LBracket))
+            {
+                auto *index = m_Arena.Make<IndexExpr>();
+                index->object = expr;
+                index->index = ParseExpression();
+                expr = index;
+
+                if (!IsMatched(TokenType::RBracket))
+                {
+                    JLANG_ERROR("Expected ']' after index");
+                    break;
+                }
+                continue;
+            }
+
+            Advance(); // consume '.'
             if (!IsMatched(TokenType::Identifier))
             {
                 JLANG_ERROR("Expected member name after '.'");
                 break;
             }
-            std::string memberName = Previous().m_lexeme;
+            std::string memberName(Previous().m_lexeme);
 
-            auto memberAccess = std::make_shared<MemberAccessExpr>();
+            auto *memberAccess = m_Arena.Make<MemberAccessExpr>();
             memberAccess->object = expr;
             memberAccess->memberName = memberName;
             expr = memberAccess;
@@ -1183,15 +1237,15 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle string literals
     if (IsMatched(TokenType::StringLiteral))
     {
-        auto expression = std::make_shared<LiteralExpr>();
-        expression->value = "\"" + Previous().m_lexeme + "\"";
+        auto *expression = m_Arena.Make<LiteralExpr>();
+        expression->value = "\"" + std::string(Previous().m_lexeme) + "\"";
         return expression;
     }
 
     // Handle number literals
     if (IsMatched(TokenType::NumberLiteral))
     {
-        auto expression = std::make_shared<LiteralExpr>();
+        auto *expression = m_Arena.Make<LiteralExpr>();
         expression->value = Previous().m_lexeme;
         return expression;
     }
@@ -1199,7 +1253,7 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle float literals
     if (IsMatched(TokenType::FloatLiteral))
     {
-        auto expression = std::make_shared<LiteralExpr>();
+        auto *expression = m_Arena.Make<LiteralExpr>();
         expression->value = Previous().m_lexeme;
         return expression;
     }
@@ -1207,9 +1261,9 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     // Handle character literals
     if (IsMatched(TokenType::CharLiteral))
     {
-        auto expression = std::make_shared<LiteralExpr>();
+        auto *expression = m_Arena.Make<LiteralExpr>();
         // Wrap in single quotes to distinguish from other literals in codegen
-        expression->value = "'" + Previous().m_lexeme + "'";
+        expression->value = "'" + std::string(Previous().m_lexeme) + "'";
         return expression;
     }
 
@@ -1217,26 +1271,133 @@ std::shared_ptr<AstNode> Parser::ParsePrimary()
     return nullptr;
 }
 
+AstNode *Parser::ParseStructLiteral(const std::string &structName)
+{
+    Advance(); // consume '{'
+
+    auto *literal = m_Arena.Make<StructLiteralExpr>();
+    literal->structName = structName;
+
+    while (!Check(TokenType::RBrace) && !IsEndReached())
+    {
+        if (!IsMatched(TokenType::Identifier))
+        {
+            JLANG_ERROR(STR("Expected field name in '%s' literal", structName.c_str()));
+            return nullptr;
+        }
+
+        FieldInitializer field;
+        field.name = std::string(Previous().m_lexeme);
+
+        if (!IsMatched(TokenType::Colon))
+        {
+            JLANG_ERROR(STR("Expected ':' after field '%s' in '%s' literal", field.name.c_str(),
+                            structName.c_str()));
+            return nullptr;
+        }
+
+        field.value = ParseExpression();
+        literal->fields.push_back(field);
+
+        if (!IsMatched(TokenType::Comma))
+        {
+            break;
+        }
+    }
+
+    if (!IsMatched(TokenType::RBrace))
+    {
+        JLANG_ERROR(STR("Expected '}' after '%s' literal", structName.c_str()));
+        return nullptr;
+    }
+
+    return literal;
+}
+
 bool Parser::IsTypeKeyword() const
 {
     static const std::unordered_set<TokenType> typeKeywords = {
         TokenType::Void, TokenType::I8,   TokenType::I16, TokenType::I32, TokenType::I64,
         TokenType::U8,   TokenType::U16,  TokenType::U32, TokenType::U64, TokenType::F32,
-        TokenType::F64,  TokenType::Bool, TokenType::Char};
+        TokenType::F64,  TokenType::Bool, TokenType::Char, TokenType::VectorType};
     return typeKeywords.count(Peek().m_type) > 0;
 }
 
+TypeRef Parser::ParseType()
+{
+    TypeRef type;
+    bool isValidSize = true;
+
+    // [N]T is a fixed-size array, []T a slice
+    if (IsMatched(TokenType::LBracket))
+    {
+        if (IsMatched(TokenType::NumberLiteral))
+        {
+            // Ten digits cannot overflow stoull, anything longer is out of range anyway
+            std::string size(Previous().m_lexeme);
+            type.arraySize = size.size() <= 10 ? std::stoull(size) : 0;
+            if (size.size() > 10 || type.arraySize > UINT32_MAX)
+            {
+                JLANG_ERROR(
+                    STR("Array size %s is out of range, the maximum is %u", size.c_str(), UINT32_MAX));
+                isValidSize = false;
+            }
+            else if (type.arraySize == 0)
+            {
+                JLANG_ERROR("Array size must be at least 1");
+                isValidSize = false;
+            }
+        }
+        else
+        {
+            type.isSlice = true;
+        }
+
+        if (!IsMatched(TokenType::RBracket))
+        {
+            JLANG_ERROR("Expected ']' in array type");
+        }
+
+        if (Check(TokenType::LBracket))
+        {
+            JLANG_ERROR("Arrays of arrays are not supported");
+        }
+    }
+
+    type.name = ParseTypeName();
+    if (!type.IsKnown())
+    {
+        return type;
+    }
+
+    type.isPointer = IsMatched(TokenType::Star);
+
+    if (type.isPointer && IsMatched(TokenType::Question))
+    {
+        type.isNullable = true;
+    }
+    else if (!type.isPointer && Check(TokenType::Question))
+    {
+        JLANG_ERROR("Only pointer types can be nullable. Use '" + type.name + "*?' instead of '" + type.name +
+                    "?'");
+        Advance();
+    }
+
+    // The whole type is consumed, but a bad size must not leave a plain T behind for later phases
+    return isValidSize ? type : TypeRef();
+}
+
 std::string Parser::ParseTypeName()
 {
     if (IsTypeKeyword())
     {
-        std::string name = Peek().m_lexeme;
+        std::string name(Peek().m_lexeme);
         Advance();
         return name;
     }
     else if (IsMatched(TokenType::Identifier))
     {
-        return Previous().m_lexeme;
+        return std::string(Previous().m_lexeme);
     }
 
     return "";
@@ -1,12 +1,12 @@
 #pragma once
 
 #include "../AST/Ast.h"
+#include "../AST/AstArena.h"
 #include "../AST/Expressions/Expressions.h"
 #include "../AST/Statements/Statements.h"
 #include "../AST/TopLevelDecl/TopLevelDecl.h"
 #include "../Types/Token.h"
 
-#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -17,49 +17,47 @@ namespace jlang
 class Parser
 {
   public:
-    explicit Parser(const std::vector<Token> &tokens);
-    std::vector<std::shared_ptr<AstNode>> Parse();
+    // Nodes are allocated in the arena, which must outlive the returned tree
+    Parser(const std::vector<Token> &tokens, AstArena &arena);
+    std::vector<AstNode *> Parse();
 
   private:
     bool IsMatched(TokenType type);
     bool Check(TokenType type) const;
     const Token &Advance();
     const Token &Peek() const;
+    bool CheckAhead(size_t distance, TokenType type) const; // The token distance places after Peek()
     const Token &Previous() const;
     bool IsEndReached() const;
 
-    std::shared_ptr<AstNode> ParseDeclaration();
-    std::shared_ptr<AstNode> ParseInterface();
-    std::shared_ptr<AstNode> ParseStruct();
-    std::shared_ptr<AstNode> ParseFunction();
-    std::shared_ptr<AstNode> ParseStatement();
-    std::shared_ptr<AstNode> ParseBlock();
-    std::shared_ptr<AstNode> ParseIfStatement();
-    std::shared_ptr<AstNode> ParseWhileStatement();
-    std::shared_ptr<AstNode> ParseForStatement();
-    std::shared_ptr<AstNode> ParseReturnStatement();
-    std::shared_ptr<AstNode> ParseVarDecl();
-    std::shared_ptr<AstNode> ParseExpression();
-    std::shared_ptr<AstNode> ParseLogicalOr();
-    std::shared_ptr<AstNode> ParseLogicalAnd();
-    std::shared_ptr<AstNode> ParseBitwiseOr();
-    std::shared_ptr<AstNode> ParseBitwiseXor();
-    std::shared_ptr<AstNode> ParseBitwiseAnd();
-    std::shared_ptr<AstNode> ParseEquality();
-    std::shared_ptr<AstNode> ParseComparison();
-    std::shared_ptr<AstNode> ParseShift();
-    std::shared_ptr<AstNode> ParseAdditive();
-    std::shared_ptr<AstNode> ParseMultiplicative();
-    std::shared_ptr<AstNode> ParseUnary();
-    std::shared_ptr<AstNode> ParsePostfix();
-    std::shared_ptr<AstNode> ParseExprStatement();
-    std::shared_ptr<AstNode> ParsePrimary();
+    AstNode *ParseDeclaration();
+    AstNode *ParseInterface();
+    AstNode *ParseStruct(std::vector<Attribute> attributes);
+    AstNode *ParseFunction(std::vector<Attribute> attributes);
+    AstNode *ParseStatement();
+    std::vector<Attribute> ParseAttributes();
+    AstNode *ParseBlock();
+    AstNode *ParseIfStatement();
+    AstNode *ParseWhileStatement();
+    AstNode *ParseForStatement();
+    AstNode *ParseReturnStatement();
+    AstNode *ParseMatchStatement();
+    AstNode *ParseVarDecl();
+    AstNode *ParseExpression();
+    AstNode *ParseBinary(int minPrecedence);
+    AstNode *ParseUnary();
+    AstNode *ParsePostfix();
+    AstNode *ParseExprStatement();
+    AstNode *ParsePrimary();
+    AstNode *ParseStructLiteral(const std::string &structName);
 
     bool IsTypeKeyword() const;
     std::string ParseTypeName();
+    TypeRef ParseType();
 
   private:
     const std::vector<Token> &m_Tokens;
+    AstArena &m_Arena;
     size_t m_CurrentPosition;
 };
 
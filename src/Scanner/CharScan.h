@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JLANG_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bulk character-class scanning used by the Scanner's hot loops. Every function takes a half-open
+// range [p, end) and returns the first position that does not belong to the run (or end). On SSE2
+// targets, which is every x86-64 build, 16 bytes are classified per step and the remainder is
+// finished with the scalar loop that other targets use for the whole range.
+
+namespace jlang
+{
+
+inline bool IsWhitespaceChar(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool IsDigitChar(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool IsIdentifierChar(char c)
+{
+    char lower = static_cast<char>(c | 0x20);
+    return (lower >= 'a' && lower <= 'z') || IsDigitChar(c) || c == '_';
+}
+
+#ifdef JLANG_SCAN_SSE2
+
+inline unsigned CountTrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// True for bytes in [lo, hi]. Only valid for ASCII bounds, bytes >= 0x80 compare as negative
+inline __m128i InRange(__m128i chunk, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline __m128i WhitespaceMask(__m128i chunk)
+{
+    __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                  _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+    __m128i newlines = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+    return _mm_or_si128(spaces, newlines);
+}
+
+inline __m128i IdentifierMask(__m128i chunk)
+{
+    // Setting bit 5 folds 'A'-'Z' onto 'a'-'z' and maps no other byte into that range
+    __m128i letters = InRange(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i underscores = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(letters, InRange(chunk, '0', '9')), underscores);
+}
+
+// Returns a bitmask with one bit per byte of the 16 bytes at p
+inline uint32_t MoveMask(__m128i mask)
+{
+    return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+}
+
+inline __m128i Load(const char *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+#endif
+
+inline const char *SkipWhitespaceChars(const char *p, const char *end)
+{
+#ifdef JLANG_SCAN_SSE2
+    for (; end - p >= 16; p += 16)
+    {
+        uint32_t outside = ~MoveMask(WhitespaceMask(Load(p))) & 0xFFFF;
+        if (outside != 0)
+        {
+            return p + CountTrailingZeros(outside);
+        }
+    }
+#endif
+    while (p < end && IsWhitespaceChar(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char *SkipIdentifierChars(const char *p, const char *end)
+{
+#ifdef JLANG_SCAN_SSE2
+    for (; end - p >= 16; p += 16)
+    {
+        uint32_t outside = ~MoveMask(IdentifierMask(Load(p))) & 0xFFFF;
+        if (outside != 0)
+        {
+            return p + CountTrailingZeros(outside);
+        }
+    }
+#endif
+    while (p < end && IsIdentifierChar(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char *SkipDigitChars(const char *p, const char *end)
+{
+#ifdef JLANG_SCAN_SSE2
+    for (; end - p >= 16; p += 16)
+    {
+        uint32_t outside = ~MoveMask(InRange(Load(p), '0', '9')) & 0xFFFF;
+        if (outside != 0)
+        {
+            return p + CountTrailingZeros(outside);
+        }
+    }
+#endif
+    while (p < end && IsDigitChar(*p))
+    {
+        ++p;
+    }
+    return p;
+}
+
+// Finds the '\n' that ends a line comment
+inline const char *FindNewline(const char *p, const char *end)
+{
+#ifdef JLANG_SCAN_SSE2
+    for (; end - p >= 16; p += 16)
+    {
+        uint32_t newlines = MoveMask(_mm_cmpeq_epi8(Load(p), _mm_set1_epi8('\n')));
+        if (newlines != 0)
+        {
+            return p + CountTrailingZeros(newlines);
+        }
+    }
+#endif
+    while (p < end && *p != '\n')
+    {
+        ++p;
+    }
+    return p;
+}
+
+// Finds the '*' of the "*/" that closes a block comment
+inline const char *FindBlockCommentEnd(const char *p, const char *end)
+{
+#ifdef JLANG_SCAN_SSE2
+    // The second load is one byte ahead, so each step needs 17 readable bytes
+    for (; end - p >= 17; p += 16)
+    {
+        __m128i stars = _mm_cmpeq_epi8(Load(p), _mm_set1_epi8('*'));
+        __m128i slashes = _mm_cmpeq_epi8(Load(p + 1), _mm_set1_epi8('/'));
+        uint32_t closers = MoveMask(_mm_and_si128(stars, slashes));
+        if (closers != 0)
+        {
+            return p + CountTrailingZeros(closers);
+        }
+    }
+#endif
+    for (; end - p >= 2; ++p)
+    {
+        if (p[0] == '*' && p[1] == '/')
+        {
+            return p;
+        }
+    }
+    return end;
+}
+
+// Appends the offset just past every '\n' in the source
+inline void CollectLineStarts(std::string_view source, std::vector<uint32_t> &lineStarts)
+{
+    const char *begin = source.data();
+    const char *end = begin + source.size();
+    const char *p = begin;
+
+#ifdef JLANG_SCAN_SSE2
+    for (; end - p >= 16; p += 16)
+    {
+        uint32_t newlines = MoveMask(_mm_cmpeq_epi8(Load(p), _mm_set1_epi8('\n')));
+        while (newlines != 0)
+        {
+            lineStarts.push_back(static_cast<uint32_t>(p - begin) + CountTrailingZeros(newlines) + 1);
+            newlines &= newlines - 1;
+        }
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        if (*p == '\n')
+        {
+            lineStarts.push_back(static_cast<uint32_t>(p - begin) + 1);
+        }
+    }
+}
+
+} // namespace jlang
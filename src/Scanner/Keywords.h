@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../Enums/TokenTypes.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace jlang
+{
+
+struct Keyword
+{
+    std::string_view text;
+    TokenType type;
+};
+
+// The single source of truth for reserved words. The perfect hash table below is generated from
+// this list at compile time, so adding a keyword only means adding a line here.
+inline constexpr Keyword s_Keywords[] = {
+    // Control flow
+    {"if", TokenType::If},
+    {"else", TokenType::Else},
+    {"while", TokenType::While},
+    {"for", TokenType::For},
+    {"return", TokenType::Return},
+    {"match", TokenType::Match},
+    // Declarations
+    {"fn", TokenType::Fn},
+    {"inline", TokenType::Inline},
+    {"var", TokenType::Var},
+    {"val", TokenType::Val},
+    {"struct", TokenType::Struct},
+    {"interface", TokenType::Interface},
+    // Types
+    {"void", TokenType::Void},
+    {"i8", TokenType::I8},
+    {"i16", TokenType::I16},
+    {"i32", TokenType::I32},
+    {"i64", TokenType::I64},
+    {"u8", TokenType::U8},
+    {"u16", TokenType::U16},
+    {"u32", TokenType::U32},
+    {"u64", TokenType::U64},
+    {"f32", TokenType::F32},
+    {"f64", TokenType::F64},
+    {"bool", TokenType::Bool},
+    {"char", TokenType::Char},
+    // SIMD vector types, 128 and 256 bits wide
+    {"i8x16", TokenType::VectorType},
+    {"i8x32", TokenType::VectorType},
+    {"u8x16", TokenType::VectorType},
+    {"u8x32", TokenType::VectorType},
+    {"i16x8", TokenType::VectorType},
+    {"i16x16", TokenType::VectorType},
+    {"u16x8", TokenType::VectorType},
+    {"u16x16", TokenType::VectorType},
+    {"i32x4", TokenType::VectorType},
+    {"i32x8", TokenType::VectorType},
+    {"u32x4", TokenType::VectorType},
+    {"u32x8", TokenType::VectorType},
+    {"i64x2", TokenType::VectorType},
+    {"i64x4", TokenType::VectorType},
+    {"u64x2", TokenType::VectorType},
+    {"u64x4", TokenType::VectorType},
+    {"f32x4", TokenType::VectorType},
+    {"f32x8", TokenType::VectorType},
+    {"f64x2", TokenType::VectorType},
+    {"f64x4", TokenType::VectorType},
+    // Literals
+    {"null", TokenType::Null},
+    {"true", TokenType::True},
+    {"false", TokenType::False},
+    // Memory
+    {"alloc", TokenType::Alloc},
+    // Logical operators (non-short-circuit)
+    {"and", TokenType::AndKeyword},
+    {"or", TokenType::OrKeyword},
+};
+
+inline constexpr size_t s_KeywordCount = sizeof(s_Keywords) / sizeof(s_Keywords[0]);
+
+// Power of two at least four times the keyword count keeps the seed search short and the mask cheap
+inline constexpr size_t s_KeywordTableSize = [] {
+    size_t size = 1;
+    while (size < s_KeywordCount * 4)
+    {
+        size <<= 1;
+    }
+    return size;
+}();
+
+inline constexpr size_t s_KeywordMinLength = [] {
+    size_t length = s_Keywords[0].text.size();
+    for (const Keyword &keyword : s_Keywords)
+    {
+        length = keyword.text.size() < length ? keyword.text.size() : length;
+    }
+    return length;
+}();
+
+inline constexpr size_t s_KeywordMaxLength = [] {
+    size_t length = 0;
+    for (const Keyword &keyword : s_Keywords)
+    {
+        length = keyword.text.size() > length ? keyword.text.size() : length;
+    }
+    return length;
+}();
+
+// FNV-1a with a variable offset basis, the basis is the knob the seed search turns. The final fold
+// matters: without it the masked low bits would only ever depend on the low bits of the seed.
+constexpr uint32_t HashKeyword(std::string_view text, uint32_t seed)
+{
+    uint32_t hash = seed;
+    for (char c : text)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+constexpr bool IsKeywordHashCollisionFree(uint32_t seed)
+{
+    bool isUsed[s_KeywordTableSize] = {};
+    for (const Keyword &keyword : s_Keywords)
+    {
+        size_t slot = HashKeyword(keyword.text, seed) & (s_KeywordTableSize - 1);
+        if (isUsed[slot])
+        {
+            return false;
+        }
+        isUsed[slot] = true;
+    }
+    return true;
+}
+
+inline constexpr uint32_t s_KeywordSeed = [] {
+    uint32_t seed = 2166136261u;
+    while (!IsKeywordHashCollisionFree(seed))
+    {
+        ++seed;
+    }
+    return seed;
+}();
+
+inline constexpr std::array<Keyword, s_KeywordTableSize> s_KeywordTable = [] {
+    std::array<Keyword, s_KeywordTableSize> table{};
+    for (Keyword &entry : table)
+    {
+        entry = Keyword{std::string_view(), TokenType::Identifier};
+    }
+    for (const Keyword &keyword : s_Keywords)
+    {
+        table[HashKeyword(keyword.text, s_KeywordSeed) & (s_KeywordTableSize - 1)] = keyword;
+    }
+    return table;
+}();
+
+// One hash and at most one string comparison, no allocation
+constexpr TokenType LookupKeyword(std::string_view text)
+{
+    if (text.size() < s_KeywordMinLength || text.size() > s_KeywordMaxLength)
+    {
+        return TokenType::Identifier;
+    }
+
+    const Keyword &candidate = s_KeywordTable[HashKeyword(text, s_KeywordSeed) & (s_KeywordTableSize - 1)];
+    return candidate.text == text ? candidate.type : TokenType::Identifier;
+}
+
+static_assert(LookupKeyword("interface") == TokenType::Interface, "keyword table is broken");
+static_assert(LookupKeyword("or") == TokenType::OrKeyword, "keyword table is broken");
+static_assert(LookupKeyword("person") == TokenType::Identifier, "keyword table is broken");
+
+} // namespace jlang
@@ -1,53 +1,31 @@
 #include "../Scanner/Scanner.h"
+#include "../Scanner/CharScan.h"
+#include "../Scanner/Keywords.h"
 
+#include <array>
 #include <cctype>
-#include <unordered_map>
 
 namespace jlang
 {
 
-static std::unordered_map<std::string, TokenType> s_Keywords = {
-    // Control flow
-    {"if", TokenType::If},
-    {"else", TokenType::Else},
-    {"while", TokenType::While},
-    {"for", TokenType::For},
-    {"return", TokenType::Return},
-    // Declarations
-    {"fn", TokenType::Fn},
-    {"var", TokenType::Var},
-    {"val", TokenType::Val},
-    {"struct", TokenType::Struct},
-    {"interface", TokenType::Interface},
-    // Types
-    {"void", TokenType::Void},
-    {"i8", TokenType::I8},
-    {"i16", TokenType::I16},
-    {"i32", TokenType::I32},
-    {"i64", TokenType::I64},
-    {"u8", TokenType::U8},
-    {"u16", TokenType::U16},
-    {"u32", TokenType::U32},
-    {"u64", TokenType::U64},
-    {"f32", TokenType::F32},
-    {"f64", TokenType::F64},
-    {"bool", TokenType::Bool},
-    {"char", TokenType::Char},
-    // Literals
-    {"null", TokenType::Null},
-    {"true", TokenType::True},
-    {"false", TokenType::False},
-    // Memory
-    {"alloc", TokenType::Alloc},
-    // Logical operators (non-short-circuit)
-    {"and", TokenType::AndKeyword},
-    {"or", TokenType::OrKeyword},
-};
-
-Scanner::Scanner(const std::string &source) : m_Source(source) {}
+// Char literal lexemes hold the decoded character, which for escape sequences does not appear
+// verbatim in the source. Such tokens view one byte of this table instead.
+static const std::array<char, 256> s_CharLexemes = [] {
+    std::array<char, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        table[i] = static_cast<char>(i);
+    }
+    return table;
+}();
+
+Scanner::Scanner(std::string_view source) : m_Source(source), m_LineTable(source) {}
 
 std::vector<Token> Scanner::Tokenize()
 {
+    // Typical code has a token every four to six bytes, reserving up front avoids regrowing the vector
+    m_Tokens.reserve(m_Source.size() / 4 + 1);
+
     while (!IsEndReached())
     {
         SkipWhitespace();
@@ -59,8 +37,15 @@ std::vector<Token> Scanner::Tokenize()
         ScanToken();
     }
 
-    m_Tokens.emplace_back(TokenType::EndOfFile, "", m_CurrentLine);
-    return m_Tokens;
+    m_Tokens.emplace_back(TokenType::EndOfFile, std::string_view(), static_cast<uint32_t>(m_CurrentPosition));
+
+    // Tokenize runs once per scanner, hand the tokens over instead of copying them
+    return std::move(m_Tokens);
+}
+
+SourceLocation Scanner::GetLocation(const Token &token) const
+{
+    return m_LineTable.GetLocation(token.m_Offset);
 }
 
 void Scanner::ScanToken()
@@ -91,7 +76,14 @@ void Scanner::ScanToken()
         AddToken(TokenType::Comma);
         break;
     case '.':
-        AddToken(TokenType::Dot);
+        if (IsMatched('.'))
+        {
+            AddToken(IsMatched('=') ? TokenType::DotDotEqual : TokenType::DotDot);
+        }
+        else
+        {
+            AddToken(TokenType::Dot);
+        }
         break;
     case '*':
         AddToken(IsMatched('=') ? TokenType::StarEqual : TokenType::Star);
@@ -117,7 +109,18 @@ void Scanner::ScanToken()
         AddToken(IsMatched('=') ? TokenType::PercentEqual : TokenType::Percent);
         break;
     case '=':
-        AddToken(IsMatched('=') ? TokenType::EqualEqual : TokenType::Equal);
+        if (IsMatched('='))
+        {
+            AddToken(TokenType::EqualEqual);
+        }
+        else if (IsMatched('>'))
+        {
+            AddToken(TokenType::FatArrow);
+        }
+        else
+        {
+            AddToken(TokenType::Equal);
+        }
         break;
     case '!':
         AddToken(IsMatched('=') ? TokenType::NotEqual : TokenType::Not);
@@ -179,6 +182,15 @@ void Scanner::ScanToken()
     case '?':
         AddToken(TokenType::Question);
         break;
+    case '#':
+        AddToken(TokenType::Hash);
+        break;
+    case '[':
+        AddToken(TokenType::LBracket);
+        break;
+    case ']':
+        AddToken(TokenType::RBracket);
+        break;
     case '-':
         if (IsMatched('-'))
         {
@@ -221,61 +233,45 @@ void Scanner::ScanToken()
 
 void Scanner::SkipWhitespace()
 {
+    const char *end = m_Source.data() + m_Source.size();
+
     while (!IsEndReached())
     {
-        char c = Peek();
+        SkipTo(SkipWhitespaceChars(Current(), end));
 
-        if (c == ' ' || c == '\r' || c == '\t')
+        if (Peek() != '/')
         {
-            Advance();
+            break;
         }
-        else if (c == '\n')
+
+        if (PeekNext() == '/')
         {
-            m_CurrentLine++;
-            Advance();
+            // Single-line comment: skip until end of line
+            SkipTo(FindNewline(Current() + 2, end));
         }
-        else if (c == '/')
+        else if (PeekNext() == '*')
         {
-            if (PeekNext() == '/')
-            {
-                // Single-line comment: skip until end of line
-                while (Peek() != '\n' && !IsEndReached())
-                {
-                    Advance();
-                }
-            }
-            else if (PeekNext() == '*')
-            {
-                // Block comment: skip until */
-                Advance(); // consume '/'
-                Advance(); // consume '*'
-                while (!IsEndReached())
-                {
-                    if (Peek() == '*' && PeekNext() == '/')
-                    {
-                        Advance(); // consume '*'
-                        Advance(); // consume '/'
-                        break;
-                    }
-                    if (Peek() == '\n')
-                    {
-                        m_CurrentLine++;
-                    }
-                    Advance();
-                }
-            }
-            else
-            {
-                break; // It's a division operator, not a comment
-            }
+            // Block comment: skip past the closing */, or to the end if it is unterminated
+            const char *close = FindBlockCommentEnd(Current() + 2, end);
+            SkipTo(close == end ? end : close + 2);
         }
         else
         {
-            break;
+            break; // It's a division operator, not a comment
         }
     }
 }
 
+const char *Scanner::Current() const
+{
+    return m_Source.data() + m_CurrentPosition;
+}
+
+void Scanner::SkipTo(const char *position)
+{
+    m_CurrentPosition = static_cast<size_t>(position - m_Source.data());
+}
+
 char Scanner::Advance()
 {
     return m_Source[m_CurrentPosition++];
@@ -316,19 +312,16 @@ void Scanner::AddToken(TokenType type)
     AddToken(type, m_Source.substr(m_Start, m_CurrentPosition - m_Start));
 }
 
-void Scanner::AddToken(TokenType type, const std::string &lexeme)
+void Scanner::AddToken(TokenType type, std::string_view lexeme)
 {
-    m_Tokens.emplace_back(type, lexeme, m_CurrentLine);
+    m_Tokens.emplace_back(type, lexeme, static_cast<uint32_t>(m_Start));
 }
 
 void Scanner::AddIdentifier()
 {
-    while (std::isalnum(Peek()) || Peek() == '_')
-    {
-        Advance();
-    }
+    SkipTo(SkipIdentifierChars(Current(), m_Source.data() + m_Source.size()));
 
-    std::string text = m_Source.substr(m_Start, m_CurrentPosition - m_Start);
+    std::string_view text = m_Source.substr(m_Start, m_CurrentPosition - m_Start);
     TokenType type = IsKeywordOrIdentifier(text);
 
     AddToken(type, text);
@@ -336,10 +329,9 @@ void Scanner::AddIdentifier()
 
 void Scanner::AddNumber()
 {
-    while (std::isdigit(Peek()))
-    {
-        Advance();
-    }
+    const char *end = m_Source.data() + m_Source.size();
+
+    SkipTo(SkipDigitChars(Current(), end));
 
     // Check for decimal point (float literal)
     if (Peek() == '.' && std::isdigit(PeekNext()))
@@ -348,10 +340,7 @@ void Scanner::AddNumber()
         Advance();
 
         // Consume the fractional part
-        while (std::isdigit(Peek()))
-        {
-            Advance();
-        }
+        SkipTo(SkipDigitChars(Current(), end));
 
         AddToken(TokenType::FloatLiteral);
     }
@@ -365,11 +354,6 @@ void Scanner::AddStringLiteral()
 {
     while (Peek() != '"' && !IsEndReached())
     {
-        if (Peek() == '\n')
-        {
-            m_CurrentLine++;
-        }
-
         Advance();
     }
 
@@ -380,7 +364,7 @@ void Scanner::AddStringLiteral()
 
     Advance();
 
-    std::string value = m_Source.substr(m_Start + 1, m_CurrentPosition - m_Start - 2);
+    std::string_view value = m_Source.substr(m_Start + 1, m_CurrentPosition - m_Start - 2);
 
     AddToken(TokenType::StringLiteral, value);
 }
@@ -435,14 +419,13 @@ void Scanner::AddCharLiteral()
 
     Advance(); // consume closing '
 
-    // Store the character value as a string
-    AddToken(TokenType::CharLiteral, std::string(1, c));
+    // Store the decoded character value
+    AddToken(TokenType::CharLiteral, std::string_view(&s_CharLexemes[static_cast<unsigned char>(c)], 1));
 }
 
-TokenType Scanner::IsKeywordOrIdentifier(const std::string &text)
+TokenType Scanner::IsKeywordOrIdentifier(std::string_view text)
 {
-    auto it = s_Keywords.find(text);
-    return it != s_Keywords.end() ? it->second : TokenType::Identifier;
+    return LookupKeyword(text);
 }
 
 } // namespace jlang
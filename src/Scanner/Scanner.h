@@ -2,9 +2,11 @@
 
 #include "../Enums/TokenTypes.h"
 #include "../Parser/Parser.h"
+#include "../Types/LineTable.h"
 #include "../Types/Token.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace jlang
@@ -13,9 +15,11 @@ namespace jlang
 class Scanner
 {
   public:
-    explicit Scanner(const std::string &source);
+    explicit Scanner(std::string_view source);
     std::vector<Token> Tokenize();
 
+    SourceLocation GetLocation(const Token &token) const;
+
   private:
     void ScanToken();
     char Advance();
@@ -27,7 +31,7 @@ class Scanner
     bool IsEndReached() const;
 
     void AddToken(TokenType type);
-    void AddToken(TokenType type, const std::string &lexeme);
+    void AddToken(TokenType type, std::string_view lexeme);
 
     void AddIdentifier();
     void AddNumber();
@@ -36,17 +40,22 @@ class Scanner
 
     void SkipWhitespace();
 
-    TokenType IsKeywordOrIdentifier(const std::string &text);
+    // Bulk-advance helpers for the vectorized scans in CharScan.h
+    const char *Current() const;
+    void SkipTo(const char *position);
+
+    TokenType IsKeywordOrIdentifier(std::string_view text);
 
   private:
     std::vector<Token> m_Tokens;
 
-    const std::string &m_Source;
+    // Non-owning view, the caller keeps the source buffer alive while scanning
+    std::string_view m_Source;
 
     size_t m_Start = 0;
     size_t m_CurrentPosition = 0;
 
-    uint32_t m_CurrentLine = 1;
+    LineTable m_LineTable;
 };
 
 } // namespace jlang
@@ -0,0 +1,531 @@
+#include "TypeAnnotator.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace jlang
+{
+
+static bool IsNullLiteral(const std::string &value)
+{
+    return value == "NULL" || value == "null" || value == "nullptr";
+}
+
+static bool IsNumericLiteral(const std::string &value)
+{
+    return !value.empty() && std::isdigit(static_cast<unsigned char>(value.front()));
+}
+
+static bool IsFloatLiteral(const std::string &value)
+{
+    return IsNumericLiteral(value) && value.find('.') != std::string::npos;
+}
+
+void TypeAnnotator::Annotate(const std::vector<AstNode *> &program)
+{
+    // Functions can be called before their definition and struct fields referenced before the
+    // struct, so collect every signature and layout up front
+    m_Functions["printf"] = FunctionSignature{{TypeRef{"char", true}}, TypeRef{"i32"}};
+    m_Functions["malloc"] = FunctionSignature{{TypeRef{"u64"}}, TypeRef{"i8", true}};
+    m_Functions["free"] = FunctionSignature{{TypeRef{"i8", true}}, TypeRef{"void"}};
+
+    for (AstNode *node : program)
+    {
+        if (auto *function = dynamic_cast<FunctionDecl *>(node))
+        {
+            FunctionSignature &signature = m_Functions[function->name];
+            signature.paramTypes.clear();
+            for (const Parameter &param : function->params)
+            {
+                signature.paramTypes.push_back(param.type);
+            }
+            signature.returnType = function->returnType;
+        }
+        else if (auto *structDecl = dynamic_cast<StructDecl *>(node))
+        {
+            auto &fields = m_StructFields[structDecl->name];
+            for (const StructField &field : structDecl->fields)
+            {
+                fields[field.name] = field.type;
+            }
+
+            for (const Attribute &attribute : structDecl->attributes)
+            {
+                if (attribute.name == "soa")
+                {
+                    m_SoaStructs.insert(structDecl->name);
+                }
+            }
+        }
+    }
+
+    for (AstNode *node : program)
+    {
+        AnnotateStatement(node);
+    }
+}
+
+TypeRef TypeAnnotator::AnnotateExpression(AstNode *node, const TypeRef &expected)
+{
+    if (!node)
+    {
+        return TypeRef();
+    }
+
+    m_ExpectedType = expected;
+    m_LastType = TypeRef();
+    node->Accept(*this);
+
+    if (auto *expression = dynamic_cast<Expression *>(node))
+    {
+        expression->resolvedType = m_LastType;
+    }
+
+    return m_LastType;
+}
+
+void TypeAnnotator::AnnotateStatement(AstNode *node)
+{
+    if (node)
+    {
+        node->Accept(*this);
+    }
+}
+
+TypeRef TypeAnnotator::AnnotateOperands(BinaryExpr &node, const TypeRef &expected)
+{
+    if (IsUntyped(node.left) && !IsUntyped(node.right))
+    {
+        TypeRef rightType = AnnotateExpression(node.right, expected);
+        AnnotateExpression(node.left, rightType);
+        return rightType;
+    }
+
+    TypeRef leftType = AnnotateExpression(node.left, expected);
+    TypeRef rightType = AnnotateExpression(node.right, leftType);
+
+    // A scalar operand is broadcast across the lanes of a vector operand, so the result is the vector
+    return !leftType.IsVector() && rightType.IsVector() ? rightType : leftType;
+}
+
+bool TypeAnnotator::IsUntyped(AstNode *node)
+{
+    if (auto *literal = dynamic_cast<LiteralExpr *>(node))
+    {
+        return IsNumericLiteral(literal->value) || IsNullLiteral(literal->value);
+    }
+
+    if (auto *binary = dynamic_cast<BinaryExpr *>(node))
+    {
+        switch (binary->op)
+        {
+        case BinaryOp::Add:
+        case BinaryOp::Sub:
+        case BinaryOp::Mul:
+        case BinaryOp::Div:
+        case BinaryOp::Mod:
+        case BinaryOp::BitAnd:
+        case BinaryOp::BitOr:
+        case BinaryOp::BitXor:
+        case BinaryOp::Shl:
+        case BinaryOp::Shr:
+            return IsUntyped(binary->left) && IsUntyped(binary->right);
+        default:
+            return false;
+        }
+    }
+
+    if (auto *unary = dynamic_cast<UnaryExpr *>(node))
+    {
+        return unary->op == UnaryOp::BitNot && IsUntyped(unary->operand);
+    }
+
+    return false;
+}
+
+void TypeAnnotator::PushScope()
+{
+    m_Scopes.emplace_back();
+}
+
+void TypeAnnotator::PopScope()
+{
+    m_Scopes.pop_back();
+}
+
+void TypeAnnotator::DeclareVariable(const std::string &name, const TypeRef &type)
+{
+    m_Scopes.back()[name] = type;
+}
+
+const TypeRef *TypeAnnotator::LookupVariable(const std::string &name) const
+{
+    for (auto scope = m_Scopes.rbegin(); scope != m_Scopes.rend(); ++scope)
+    {
+        auto it = scope->find(name);
+        if (it != scope->end())
+        {
+            return &it->second;
+        }
+    }
+
+    return nullptr;
+}
+
+void TypeAnnotator::VisitFunctionDecl(FunctionDecl &node)
+{
+    m_CurrentReturnType = node.returnType;
+
+    PushScope();
+
+    for (const Parameter &param : node.params)
+    {
+        DeclareVariable(param.name, param.type);
+    }
+
+    AnnotateStatement(node.body);
+
+    PopScope();
+}
+
+void TypeAnnotator::VisitInterfaceDecl(InterfaceDecl &) {}
+
+void TypeAnnotator::VisitStructDecl(StructDecl &) {}
+
+void TypeAnnotator::VisitVariableDecl(VariableDecl &node)
+{
+    if (node.varType.IsKnown())
+    {
+        AnnotateExpression(node.initializer, node.varType);
+        DeclareVariable(node.name, node.varType);
+        return;
+    }
+
+    // Type inference: the variable takes the initializer's type
+    DeclareVariable(node.name, AnnotateExpression(node.initializer));
+}
+
+void TypeAnnotator::VisitIfStatement(IfStatement &node)
+{
+    AnnotateExpression(node.condition);
+    AnnotateStatement(node.thenBranch);
+    AnnotateStatement(node.elseBranch);
+}
+
+void TypeAnnotator::VisitWhileStatement(WhileStatement &node)
+{
+    AnnotateExpression(node.condition);
+    AnnotateStatement(node.body);
+}
+
+void TypeAnnotator::VisitForStatement(ForStatement &node)
+{
+    PushScope();
+
+    AnnotateStatement(node.init);
+    AnnotateExpression(node.condition);
+    AnnotateExpression(node.update);
+    AnnotateStatement(node.body);
+
+    PopScope();
+}
+
+void TypeAnnotator::VisitBlockStatement(BlockStatement &node)
+{
+    PushScope();
+
+    for (AstNode *statement : node.statements)
+    {
+        AnnotateStatement(statement);
+    }
+
+    PopScope();
+}
+
+void TypeAnnotator::VisitExprStatement(ExprStatement &node)
+{
+    AnnotateExpression(node.expression);
+}
+
+void TypeAnnotator::VisitReturnStatement(ReturnStatement &node)
+{
+    AnnotateExpression(node.value, m_CurrentReturnType);
+}
+
+void TypeAnnotator::VisitMatchStatement(MatchStatement &node)
+{
+    // Patterns are literals, they become case constants of the matched value's type
+    TypeRef valueType = AnnotateExpression(node.value);
+
+    for (MatchArm &arm : node.arms)
+    {
+        for (MatchPattern &pattern : arm.patterns)
+        {
+            AnnotateExpression(pattern.low, valueType);
+            AnnotateExpression(pattern.high, valueType);
+        }
+        AnnotateStatement(arm.body);
+    }
+}
+
+void TypeAnnotator::VisitCallExpr(CallExpr &node)
+{
+    if (IsVectorBuiltin(node.callee))
+    {
+        // Copied, annotating the arguments replaces m_ExpectedType
+        TypeRef expected = m_ExpectedType;
+        AnnotateVectorBuiltin(node, expected);
+        return;
+    }
+
+    auto it = m_Functions.find(node.callee);
+
+    for (size_t i = 0; i < node.arguments.size(); ++i)
+    {
+        // Variadic arguments (printf) have no declared type to steer literals
+        bool hasParam = it != m_Functions.end() && i < it->second.paramTypes.size();
+        AnnotateExpression(node.arguments[i], hasParam ? it->second.paramTypes[i] : TypeRef());
+    }
+
+    m_LastType = it != m_Functions.end() ? it->second.returnType : TypeRef();
+}
+
+void TypeAnnotator::AnnotateVectorBuiltin(CallExpr &node, const TypeRef &expected)
+{
+    const std::string &name = node.callee;
+    std::vector<AstNode *> &args = node.arguments;
+
+    if (name == "splat")
+    {
+        // splat and load cannot tell the lane count from their arguments, it comes from the context
+        TypeRef vectorType = expected.IsVector() ? expected : TypeRef();
+        if (!args.empty())
+        {
+            AnnotateExpression(args[0], vectorType.IsVector() ? vectorType.ElementType() : TypeRef());
+        }
+        m_LastType = vectorType;
+    }
+    else if (name == "load" || name == "load_aligned" || name == "store" || name == "store_aligned")
+    {
+        // load(source, index), store(destination, index, vector)
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            AnnotateExpression(args[i], i == 1 ? TypeRef{"i64"} : TypeRef());
+        }
+        bool isLoad = name == "load" || name == "load_aligned";
+        m_LastType = isLoad && expected.IsVector() ? expected : TypeRef{isLoad ? "" : "void"};
+    }
+    else if (name == "shuffle")
+    {
+        // shuffle(a, lanes...) or shuffle(a, b, lanes...), the lane indices are integer literals
+        TypeRef sourceType = args.empty() ? TypeRef() : AnnotateExpression(args[0]);
+        unsigned laneCount = 0;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            bool isLaneIndex = IsUntyped(args[i]);
+            AnnotateExpression(args[i], isLaneIndex ? TypeRef{"i32"} : sourceType);
+            laneCount += isLaneIndex ? 1 : 0;
+        }
+
+        m_LastType = TypeRef();
+        if (sourceType.IsVector())
+        {
+            m_LastType = TypeRef{sourceType.ElementType().name + "x" + std::to_string(laneCount)};
+        }
+    }
+    else
+    {
+        // reduce_add, reduce_mul, reduce_min, reduce_max
+        TypeRef vectorType = args.empty() ? TypeRef() : AnnotateExpression(args[0]);
+        m_LastType = vectorType.IsVector() ? vectorType.ElementType() : TypeRef();
+    }
+}
+
+void TypeAnnotator::VisitBinaryExpr(BinaryExpr &node)
+{
+    TypeRef expected = m_ExpectedType;
+
+    switch (node.op)
+    {
+    case BinaryOp::LogicalAnd:
+    case BinaryOp::LogicalOr:
+    case BinaryOp::EagerAnd:
+    case BinaryOp::EagerOr:
+        AnnotateExpression(node.left);
+        AnnotateExpression(node.right);
+        m_LastType = TypeRef{"bool"};
+        break;
+    case BinaryOp::Equal:
+    case BinaryOp::NotEqual:
+    case BinaryOp::Less:
+    case BinaryOp::LessEqual:
+    case BinaryOp::Greater:
+    case BinaryOp::GreaterEqual:
+        AnnotateOperands(node, TypeRef());
+        m_LastType = TypeRef{"bool"};
+        break;
+    default:
+        m_LastType = AnnotateOperands(node, expected);
+        break;
+    }
+}
+
+void TypeAnnotator::VisitUnaryExpr(UnaryExpr &node)
+{
+    if (node.op == UnaryOp::Not)
+    {
+        AnnotateExpression(node.operand);
+        m_LastType = TypeRef{"bool"};
+        return;
+    }
+
+    m_LastType = AnnotateExpression(node.operand, m_ExpectedType);
+}
+
+void TypeAnnotator::VisitLiteralExpr(LiteralExpr &node)
+{
+    const std::string &value = node.value;
+
+    if (IsNullLiteral(value))
+    {
+        // null is whatever pointer the context wants, so comparing against a Person*? needs no cast
+        m_LastType = m_ExpectedType.isPointer ? m_ExpectedType : TypeRef{"i8", true, true};
+    }
+    else if (value == "true" || value == "false")
+    {
+        m_LastType = TypeRef{"bool"};
+    }
+    else if (value.front() == '"')
+    {
+        m_LastType = TypeRef{"char", true};
+    }
+    else if (value.front() == '\'')
+    {
+        m_LastType = TypeRef{"char"};
+    }
+    else if (IsFloatLiteral(value))
+    {
+        // f32 and f64 adopt the context, so do float vectors, which splat the literal across the lanes
+        bool isFloatContext = m_ExpectedType.IsScalar() && m_ExpectedType.ElementType().IsFloat();
+        m_LastType = isFloatContext ? m_ExpectedType : TypeRef{"f64"};
+    }
+    else if (IsNumericLiteral(value))
+    {
+        bool isNumericContext =
+            m_ExpectedType.IsInteger() || m_ExpectedType.IsFloat() || m_ExpectedType.IsVector();
+        m_LastType = isNumericContext ? m_ExpectedType : TypeRef{"i32"};
+    }
+}
+
+void TypeAnnotator::VisitVarExpr(VarExpr &node)
+{
+    const TypeRef *type = LookupVariable(node.name);
+    m_LastType = type ? *type : TypeRef();
+}
+
+void TypeAnnotator::VisitCastExpr(CastExpr &node)
+{
+    AnnotateExpression(node.expr);
+    m_LastType = node.targetType;
+}
+
+void TypeAnnotator::VisitAllocExpr(AllocExpr &node)
+{
+    m_LastType = node.allocType;
+}
+
+void TypeAnnotator::VisitAssignExpr(AssignExpr &node)
+{
+    const TypeRef *target = LookupVariable(node.name);
+    TypeRef targetType = target ? *target : TypeRef();
+
+    AnnotateExpression(node.value, targetType);
+    m_LastType = targetType;
+}
+
+void TypeAnnotator::VisitMemberAccessExpr(MemberAccessExpr &node)
+{
+    TypeRef objectType = AnnotateExpression(node.object);
+
+    m_LastType = TypeRef();
+
+    if ((objectType.IsArray() || objectType.isSlice) && node.memberName == "len")
+    {
+        m_LastType = TypeRef{"u64"};
+        return;
+    }
+
+    auto structIt = m_StructFields.find(objectType.name);
+    if (structIt == m_StructFields.end())
+    {
+        return;
+    }
+
+    auto fieldIt = structIt->second.find(node.memberName);
+    if (fieldIt == structIt->second.end())
+    {
+        return;
+    }
+
+    m_LastType = fieldIt->second;
+
+    // A field of a #[soa] array is a whole column: particles.X is an [N]f32
+    if (objectType.IsArray() && !objectType.isPointer && m_SoaStructs.count(objectType.name))
+    {
+        m_LastType.arraySize = objectType.arraySize;
+    }
+}
+
+void TypeAnnotator::VisitPrefixExpr(PrefixExpr &node)
+{
+    m_LastType = AnnotateExpression(node.operand);
+}
+
+void TypeAnnotator::VisitPostfixExpr(PostfixExpr &node)
+{
+    m_LastType = AnnotateExpression(node.operand);
+}
+
+void TypeAnnotator::VisitIndexExpr(IndexExpr &node)
+{
+    TypeRef objectType = AnnotateExpression(node.object);
+    AnnotateExpression(node.index, TypeRef{"i64"});
+
+    bool isIndexable =
+        objectType.IsArray() || objectType.isSlice || objectType.isPointer || objectType.IsVector();
+    m_LastType = isIndexable ? objectType.ElementType() : TypeRef();
+}
+
+void TypeAnnotator::VisitIndexAssignExpr(IndexAssignExpr &node)
+{
+    TypeRef elementType = AnnotateExpression(node.target);
+    AnnotateExpression(node.value, elementType);
+    m_LastType = elementType;
+}
+
+void TypeAnnotator::VisitMemberAssignExpr(MemberAssignExpr &node)
+{
+    TypeRef fieldType = AnnotateExpression(node.target);
+    AnnotateExpression(node.value, fieldType);
+    m_LastType = fieldType;
+}
+
+void TypeAnnotator::VisitStructLiteralExpr(StructLiteralExpr &node)
+{
+    auto structIt = m_StructFields.find(node.structName);
+
+    for (FieldInitializer &field : node.fields)
+    {
+        const TypeRef *fieldType = nullptr;
+        if (structIt != m_StructFields.end())
+        {
+            auto fieldIt = structIt->second.find(field.name);
+            fieldType = fieldIt != structIt->second.end() ? &fieldIt->second : nullptr;
+        }
+        AnnotateExpression(field.value, fieldType ? *fieldType : TypeRef());
+    }
+
+    m_LastType = TypeRef{node.structName};
+}
+
+} // namespace jlang
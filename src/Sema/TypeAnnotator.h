@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../AST/Ast.h"
+#include "../AST/Expressions/Expressions.h"
+#include "../AST/Statements/Statements.h"
+#include "../AST/TopLevelDecl/TopLevelDecl.h"
+#include "../CodeGen/AstVisitor.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace jlang
+{
+
+// Records the exact jlang type of every expression in Expression::resolvedType. LLVM types cannot
+// tell u32 from i32, so codegen reads signedness from here to pick udiv/urem/lshr/unsigned compares
+// and overflow flags. Untyped literals take the type their context expects, so `var b: u8 = 200;`
+// produces an i8 constant rather than an i32 one.
+class TypeAnnotator : public AstVisitor
+{
+  public:
+    void Annotate(const std::vector<AstNode *> &program);
+
+    virtual void VisitFunctionDecl(FunctionDecl &) override;
+    virtual void VisitInterfaceDecl(InterfaceDecl &) override;
+    virtual void VisitStructDecl(StructDecl &) override;
+    virtual void VisitVariableDecl(VariableDecl &) override;
+
+    virtual void VisitIfStatement(IfStatement &) override;
+    virtual void VisitWhileStatement(WhileStatement &) override;
+    virtual void VisitForStatement(ForStatement &) override;
+    virtual void VisitBlockStatement(BlockStatement &) override;
+    virtual void VisitExprStatement(ExprStatement &) override;
+    virtual void VisitReturnStatement(ReturnStatement &) override;
+    virtual void VisitMatchStatement(MatchStatement &) override;
+
+    virtual void VisitCallExpr(CallExpr &) override;
+    virtual void VisitBinaryExpr(BinaryExpr &) override;
+    virtual void VisitUnaryExpr(UnaryExpr &) override;
+    virtual void VisitLiteralExpr(LiteralExpr &) override;
+    virtual void VisitVarExpr(VarExpr &) override;
+    virtual void VisitCastExpr(CastExpr &) override;
+    virtual void VisitAllocExpr(AllocExpr &) override;
+    virtual void VisitAssignExpr(AssignExpr &) override;
+    virtual void VisitMemberAccessExpr(MemberAccessExpr &) override;
+    virtual void VisitPrefixExpr(PrefixExpr &) override;
+    virtual void VisitPostfixExpr(PostfixExpr &) override;
+    virtual void VisitIndexExpr(IndexExpr &) override;
+    virtual void VisitIndexAssignExpr(IndexAssignExpr &) override;
+    virtual void VisitMemberAssignExpr(MemberAssignExpr &) override;
+    virtual void VisitStructLiteralExpr(StructLiteralExpr &) override;
+
+  private:
+    struct FunctionSignature
+    {
+        std::vector<TypeRef> paramTypes;
+        TypeRef returnType;
+    };
+
+    // Annotates an expression and returns its type. The expected type only steers untyped literals.
+    TypeRef AnnotateExpression(AstNode *node, const TypeRef &expected = TypeRef());
+    void AnnotateStatement(AstNode *node);
+
+    // Annotates both operands of a binary operator so that a literal on either side adopts the
+    // type of the other side. Returns the common operand type.
+    TypeRef AnnotateOperands(BinaryExpr &node, const TypeRef &expected);
+
+    static bool IsUntyped(AstNode *node);
+
+    // splat, load/store, shuffle and reduce_* have no signature, their types follow from the arguments
+    // and, for splat and load, from the expected vector type
+    void AnnotateVectorBuiltin(CallExpr &node, const TypeRef &expected);
+
+    void PushScope();
+    void PopScope();
+    void DeclareVariable(const std::string &name, const TypeRef &type);
+    const TypeRef *LookupVariable(const std::string &name) const;
+
+  private:
+    std::unordered_map<std::string, FunctionSignature> m_Functions;
+    std::unordered_map<std::string, std::unordered_map<std::string, TypeRef>> m_StructFields;
+    std::unordered_set<std::string> m_SoaStructs; // #[soa], arrays of them are stored one column per field
+    std::vector<std::unordered_map<std::string, TypeRef>> m_Scopes;
+
+    TypeRef m_CurrentReturnType;
+    TypeRef m_ExpectedType; // Context for the expression being visited
+    TypeRef m_LastType;     // Result of the expression just visited
+};
+
+} // namespace jlang
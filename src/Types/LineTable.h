@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../Scanner/CharScan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace jlang
+{
+
+struct SourceLocation
+{
+    uint32_t line;   // 1-based
+    uint32_t column; // 1-based, in bytes
+};
+
+// Maps byte offsets in a source buffer to line/column pairs. Tokens only carry an offset, and the
+// table of line starts is built on the first lookup, so compiles without diagnostics never pay for it.
+class LineTable
+{
+  public:
+    explicit LineTable(std::string_view source) : m_Source(source) {}
+
+    SourceLocation GetLocation(uint32_t offset) const
+    {
+        if (m_LineStarts.empty())
+        {
+            Build();
+        }
+
+        auto it = std::upper_bound(m_LineStarts.begin(), m_LineStarts.end(), offset);
+        uint32_t lineIndex = static_cast<uint32_t>(it - m_LineStarts.begin()) - 1;
+
+        return SourceLocation{lineIndex + 1, offset - m_LineStarts[lineIndex] + 1};
+    }
+
+  private:
+    void Build() const
+    {
+        m_LineStarts.push_back(0);
+        CollectLineStarts(m_Source, m_LineStarts);
+    }
+
+  private:
+    std::string_view m_Source;
+    mutable std::vector<uint32_t> m_LineStarts;
+};
+
+} // namespace jlang
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace jlang
 {
@@ -12,11 +14,11 @@ namespace jlang
 struct Token
 {
     TokenType m_type;
-    std::string m_lexeme;
-    uint32_t m_CurrentLine;
+    uint32_t m_Offset;         // Byte offset into the source, resolve to line/column through a LineTable
+    std::string_view m_lexeme; // Points into the source buffer, which must outlive the token
 
-    Token(const TokenType type, const std::string &lexeme, uint32_t const currentLine)
-        : m_type(type), m_lexeme(lexeme), m_CurrentLine(currentLine)
+    Token(const TokenType type, std::string_view lexeme, uint32_t const offset)
+        : m_type(type), m_Offset(offset), m_lexeme(lexeme)
     {
     }
 
@@ -24,7 +26,7 @@ struct Token
     {
         std::stringstream ss;
 
-        ss << m_CurrentLine << ": ";
+        ss << m_Offset << ": ";
         ss << m_lexeme;
         ss << " (" << static_cast<int32_t>(m_type) << ")";
 
@@ -32,4 +34,6 @@ struct Token
     }
 };
 
+static_assert(std::is_trivially_copyable_v<Token>, "Tokens are copied around by value and must stay cheap");
+
 } // namespace jlang
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "../../src/AST/AstArena.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace jlang;
+
+namespace
+{
+
+struct Tracked
+{
+    explicit Tracked(int &destroyed) : m_Destroyed(destroyed) {}
+    ~Tracked() { ++m_Destroyed; }
+
+    int &m_Destroyed;
+};
+
+struct alignas(32) OverAligned
+{
+    char payload[32];
+};
+
+} // namespace
+
+TEST(AstArenaTest, RunsDestructorsWhenArenaIsDestroyed)
+{
+    // Given
+    int destroyed = 0;
+
+    // When
+    {
+        AstArena arena;
+        arena.Make<Tracked>(destroyed);
+        arena.Make<Tracked>(destroyed);
+        EXPECT_EQ(destroyed, 0);
+    }
+
+    // Then
+    EXPECT_EQ(destroyed, 2);
+}
+
+TEST(AstArenaTest, ForwardsConstructorArguments)
+{
+    // Given
+    AstArena arena;
+
+    // When
+    std::string *text = arena.Make<std::string>(3, 'x');
+
+    // Then
+    EXPECT_EQ(*text, "xxx");
+}
+
+TEST(AstArenaTest, RespectsAlignment)
+{
+    // Given
+    AstArena arena;
+    arena.Make<char>('a');
+
+    // When
+    OverAligned *object = arena.Make<OverAligned>();
+
+    // Then
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(object) % alignof(OverAligned), 0u);
+}
+
+TEST(AstArenaTest, AllocatesAcrossBlocks)
+{
+    // Given
+    AstArena arena;
+    std::vector<uint64_t *> values;
+
+    // When
+    for (uint64_t i = 0; i < 20000; ++i)
+    {
+        values.push_back(arena.Make<uint64_t>(i));
+    }
+
+    // Then
+    for (uint64_t i = 0; i < values.size(); ++i)
+    {
+        ASSERT_EQ(*values[i], i);
+    }
+    EXPECT_EQ(arena.GetBytesAllocated(), 20000 * sizeof(uint64_t));
+}
@@ -0,0 +1,413 @@
+#include <gtest/gtest.h>
+
+#include "../../src/CodeGen/CodeGen.h"
+#include "../../src/Parser/Parser.h"
+#include "../../src/Scanner/Scanner.h"
+#include "../../src/Sema/TypeAnnotator.h"
+
+#include <string>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace jlang;
+
+namespace
+{
+
+// Runs a program through the whole frontend at -O0 and keeps what the code generator reported and emitted
+class CodeGenTest : public ::testing::Test
+{
+  protected:
+    // True when the module passes the verifier, the errors logged on the way end up in m_Errors, the
+    // module's IR in m_IR and the --layout-report text in m_LayoutReport
+    bool Compile(const std::string &source)
+    {
+        m_Source = source;
+        Scanner scanner(m_Source);
+        m_Tokens = scanner.Tokenize();
+
+        Parser parser(m_Tokens, m_Arena);
+        std::vector<AstNode *> program = parser.Parse();
+
+        TypeAnnotator annotator;
+        annotator.Annotate(program);
+
+        ::testing::internal::CaptureStderr();
+        CodeGenerator codegen(m_Context);
+        codegen.Generate(program);
+        bool isValid = codegen.Optimize(OptimizationLevel::O0);
+        m_Errors = ::testing::internal::GetCapturedStderr();
+
+        m_LayoutReport.clear();
+        llvm::raw_string_ostream reportStream(m_LayoutReport);
+        codegen.PrintLayoutReport(reportStream);
+        reportStream.flush();
+
+        m_IR.clear();
+        llvm::raw_string_ostream irStream(m_IR);
+        codegen.TakeModule()->print(irStream, nullptr);
+        irStream.flush();
+        return isValid;
+    }
+
+    // Position of text in the IR, npos when it is missing
+    size_t FindInIR(const std::string &text, size_t from = 0) const { return m_IR.find(text, from); }
+
+    std::string m_Errors;
+    std::string m_IR;
+    std::string m_LayoutReport;
+
+  private:
+    std::string m_Source;
+    std::vector<Token> m_Tokens;
+    AstArena m_Arena;
+    llvm::LLVMContext m_Context;
+};
+
+} // namespace
+
+TEST_F(CodeGenTest, IfBranchEndingInReturnPassesVerifier)
+{
+    // Given
+    std::string source = "fn main() -> i32 { var x: i32 = 1; if (x == 1) { return 2; } return 0; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    EXPECT_TRUE(isValid) << m_Errors;
+}
+
+TEST_F(CodeGenTest, ElseBranchEndingInReturnPassesVerifier)
+{
+    // Given
+    std::string source = "fn f(x: i32) -> i32 { if (x < 10) { x = 10; } else { return 20; } return x; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    EXPECT_TRUE(isValid) << m_Errors;
+}
+
+TEST_F(CodeGenTest, LoopBodiesEndingInReturnPassVerifier)
+{
+    // Given
+    std::string source = "fn f(n: i32) -> i32 {\n"
+                         "    while (n > 0) { return n; }\n"
+                         "    for (var i: i32 = 0; i < n; i++) { return i; }\n"
+                         "    return 0;\n"
+                         "}";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    EXPECT_TRUE(isValid) << m_Errors;
+}
+
+TEST_F(CodeGenTest, ArrayPassesAsSliceOfItsElementType)
+{
+    // Given
+    std::string source = "fn Sum(xs: []i32) -> i32 { return xs[0]; }\n"
+                         "fn main() -> i32 { var a: [4]i32; a[0] = 1; return Sum(a); }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    EXPECT_TRUE(isValid) << m_Errors;
+}
+
+TEST_F(CodeGenTest, ReportsArrayOfOtherElementTypeForSlice)
+{
+    // Given
+    std::string source = "fn Sum(xs: []i32) -> i32 { return xs[0]; }\n"
+                         "fn main() -> i32 { var a: [4]i64; a[0] = 1; return Sum(a); }";
+
+    // When
+    Compile(source);
+
+    // Then
+    EXPECT_NE(m_Errors.find("Cannot use an array of 'i64' as a slice of 'i32'"), std::string::npos)
+        << m_Errors;
+}
+
+TEST_F(CodeGenTest, ReportsSoaArrayPassedAsSlice)
+{
+    // Given
+    std::string source = "#[soa] struct P { X: i32; Y: i32; }\n"
+                         "fn Sum(xs: []P) -> i32 { return 0; }\n"
+                         "fn main() -> i32 { var a: [4]P; return Sum(a); }";
+
+    // When
+    Compile(source);
+
+    // Then
+    EXPECT_NE(m_Errors.find("A #[soa] array cannot be used as a slice"), std::string::npos) << m_Errors;
+}
+
+TEST_F(CodeGenTest, ReportsIndexIntoUndeclaredPointer)
+{
+    // Given
+    std::string source = "fn main() -> i32 { var p: i64*; p[0] = 1; return 0; }";
+
+    // When
+    Compile(source);
+
+    // Then
+    EXPECT_NE(m_Errors.find("Undefined variable: p"), std::string::npos) << m_Errors;
+}
+
+TEST_F(CodeGenTest, BlockLocalLifetimeSpansItsBlock)
+{
+    // Given
+    std::string source = "fn F(n: i32) -> i32 {\n"
+                         "    var total: i32 = 0;\n"
+                         "    if (n > 0) {\n"
+                         "        var buffer: [16]i32;\n"
+                         "        buffer[0] = n;\n"
+                         "        total = buffer[0];\n"
+                         "    }\n"
+                         "    return total;\n"
+                         "}";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    size_t thenBlock = FindInIR("\nthen:");
+    size_t start = FindInIR("call void @llvm.lifetime.start.p0i8(i64 64", thenBlock);
+    size_t store = FindInIR("store i32 %n", start);
+    size_t end = FindInIR("call void @llvm.lifetime.end.p0i8(i64 64", store);
+    size_t elseBlock = FindInIR("\nelse:", end);
+    EXPECT_NE(thenBlock, std::string::npos) << m_IR;
+    EXPECT_NE(start, std::string::npos) << m_IR;
+    EXPECT_NE(store, std::string::npos) << m_IR;
+    EXPECT_NE(end, std::string::npos) << m_IR;
+    EXPECT_NE(elseBlock, std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, LoopAttributesBecomeLoopMetadataOnTheBackEdge)
+{
+    // Given
+    std::string source = "fn F(n: i32) -> i32 {\n"
+                         "    var total: i32 = 0;\n"
+                         "    #[unroll(4)]\n"
+                         "    for (var i: i32 = 0; i < n; i++) { total += i; }\n"
+                         "    #[vectorize(disable)]\n"
+                         "    while (total > 100) { total -= 1; }\n"
+                         "    return total;\n"
+                         "}";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("br label %for.cond, !llvm.loop !"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("br label %while.cond, !llvm.loop !"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("!{!\"llvm.loop.unroll.count\", i32 4}"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("!{!\"llvm.loop.vectorize.enable\", i1 false}"), std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, InliningAttributesBecomeFunctionAttributes)
+{
+    // Given
+    std::string source = "#[noinline] fn Cold(x: i32) -> i32 { return x; }\n"
+                         "#[always_inline] fn Hot(x: i32) -> i32 { return x; }\n"
+                         "inline fn Hint(x: i32) -> i32 { return x; }\n"
+                         "fn main() -> i32 { return Cold(1) + Hot(2) + Hint(3); }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("; Function Attrs: noinline\ndefine i32 @Cold("), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("; Function Attrs: alwaysinline\ndefine i32 @Hot("), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("; Function Attrs: inlinehint\ndefine i32 @Hint("), std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, LowercaseFunctionsAreInternalFastcc)
+{
+    // Given
+    std::string source = "fn helper(x: i32) -> i32 { return x + 1; }\n"
+                         "fn Exported(x: i32) -> i32 { return helper(x); }\n"
+                         "fn main() -> i32 { return Exported(1); }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("define internal fastcc i32 @helper("), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("call fastcc i32 @helper("), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("define i32 @Exported("), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("call i32 @Exported("), std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, MatchLowersToSwitchWithWideRangesCompared)
+{
+    // Given
+    std::string source = "fn Classify(c: i32) -> i32 {\n"
+                         "    match (c) {\n"
+                         "        0 => return 10;\n"
+                         "        1 | 2 => return 11;\n"
+                         "        1000..=9999 => return 12;\n"
+                         "        _ => return 0;\n"
+                         "    }\n"
+                         "}";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("switch i32 %c, label %match.range ["), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("i32 2, label %match.arm"), std::string::npos) << m_IR;
+    EXPECT_EQ(FindInIR("i32 1000, label"), std::string::npos) << m_IR;
+    EXPECT_EQ(FindInIR("icmp eq"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("%match.offset = sub i32 %c, 1000"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("%match.inrange = icmp ule i32 %match.offset, 8999"), std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, FieldsAreReorderedUnlessReprC)
+{
+    // Given
+    std::string source = "struct Padded { A: u8; B: i64; C: u8; }\n"
+                         "#[repr(C)] struct Header { A: u8; B: i64; C: u8; }\n"
+                         "fn F(p: Padded*, h: Header*) -> i64 { return p.B + h.B; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("%Padded = type { i64, i8, i8 }"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("%Header = type { i8, i64, i8 }"), std::string::npos) << m_IR;
+    EXPECT_NE(FindInIR("getelementptr inbounds %Padded, %Padded* %p, i32 0, i32 0"), std::string::npos)
+        << m_IR;
+    EXPECT_NE(FindInIR("getelementptr inbounds %Header, %Header* %h, i32 0, i32 1"), std::string::npos)
+        << m_IR;
+
+    EXPECT_NE(m_LayoutReport.find("struct Padded: 16 bytes, align 8, reordered (24 bytes as declared)\n"
+                                  "  offset   size  field\n"
+                                  "       0      8  B: i64\n"
+                                  "       8      1  A: u8\n"
+                                  "       9      1  C: u8\n"
+                                  "      10      6  (padding)\n"
+                                  "  6 bytes of padding\n"),
+              std::string::npos)
+        << m_LayoutReport;
+    EXPECT_NE(m_LayoutReport.find("struct Header: 24 bytes, align 8, #[repr(C)]\n"), std::string::npos)
+        << m_LayoutReport;
+}
+
+TEST_F(CodeGenTest, WarnsAboutReorderedStructInExportedSignature)
+{
+    // Given
+    std::string source = "struct Small { A: u8; B: i16; }\n"
+                         "#[repr(C)] struct Wire { A: u8; B: i16; }\n"
+                         "fn Exported(s: Small) -> Small { return s; }\n"
+                         "fn Shared(w: Wire*) -> i16 { return w.B; }\n"
+                         "fn local(s: Small) -> i16 { return s.B; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    // One warning per struct, however often the signature uses it
+    size_t warning = m_Errors.find("JLANG WARNING: Exported function 'Exported' uses struct 'Small'");
+    EXPECT_NE(warning, std::string::npos) << m_Errors;
+    EXPECT_EQ(m_Errors.find("JLANG WARNING", warning + 1), std::string::npos) << m_Errors;
+}
+
+TEST_F(CodeGenTest, ThreeFloatsTravelAsFloatVectorAndFloat)
+{
+    // Given
+    std::string source = "#[repr(C)] struct V3 { X: f32; Y: f32; Z: f32; }\n"
+                         "fn Pass(v: V3) -> V3 { return v; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("define { <2 x float>, float } @Pass(<2 x float> %v.part0, float %v.part1)"),
+              std::string::npos)
+        << m_IR;
+}
+
+TEST_F(CodeGenTest, MixedEightbytesTravelAsIntegerAndDouble)
+{
+    // Given
+    std::string source = "#[repr(C)] struct Mixed { A: i32; B: f32; C: f64; }\n"
+                         "fn Pass(m: Mixed) -> Mixed { return m; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("define { i64, double } @Pass(i64 %m.part0, double %m.part1)"), std::string::npos)
+        << m_IR;
+}
+
+TEST_F(CodeGenTest, SmallStructTravelsAsOneInteger)
+{
+    // Given
+    std::string source = "#[repr(C)] struct Small { A: u8; B: i16; }\n"
+                         "fn Pass(s: Small) -> Small { return s; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("define i32 @Pass(i32 %s.part0)"), std::string::npos) << m_IR;
+}
+
+TEST_F(CodeGenTest, LargeStructTravelsInMemory)
+{
+    // Given
+    std::string source = "#[repr(C)] struct Big { A: i64; B: i64; C: i64; }\n"
+                         "fn Pass(b: Big) -> Big { return b; }";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("define void @Pass(%Big* noalias sret(%Big) align 8 %result, "
+                       "%Big* byval(%Big) align 8 %b.byval)"),
+              std::string::npos)
+        << m_IR;
+}
+
+TEST_F(CodeGenTest, StructGoesInMemoryWhenRegistersRunOut)
+{
+    // Given
+    std::string source = "#[repr(C)] struct Pair { A: i64; B: i64; }\n"
+                         "fn Fits(a: i64, b: i64, c: i64, d: i64, p: Pair) -> i64 { return p.B; }\n"
+                         "fn Spills(a: i64, b: i64, c: i64, d: i64, e: i64, p: Pair) -> i64 {\n"
+                         "    return p.B;\n"
+                         "}";
+
+    // When
+    bool isValid = Compile(source);
+
+    // Then
+    ASSERT_TRUE(isValid) << m_Errors;
+    EXPECT_NE(FindInIR("@Fits(i64 %a, i64 %b, i64 %c, i64 %d, i64 %p.part0, i64 %p.part1)"),
+              std::string::npos)
+        << m_IR;
+    EXPECT_NE(FindInIR("@Spills(i64 %a, i64 %b, i64 %c, i64 %d, i64 %e, "
+                       "%Pair* byval(%Pair) align 8 %p.byval)"),
+              std::string::npos)
+        << m_IR;
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include "../../src/CodeGen/HeapToStack.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+
+using namespace jlang;
+
+namespace
+{
+
+// Declarations shared by every test module, alloc<T>() lowers to these calls
+const char *kPrelude = "%Point = type { i64, i64 }\n"
+                       "declare i8* @malloc(i64)\n"
+                       "declare i8* @aligned_alloc(i64, i64)\n"
+                       "declare void @free(i8*)\n"
+                       "declare void @consume(i8*)\n";
+
+// Parses a module holding one function @f, runs the pass over it and collects the remarks
+class HeapToStackTest : public ::testing::Test
+{
+  protected:
+    llvm::Function *RunPass(const std::string &function)
+    {
+        llvm::SMDiagnostic error;
+        m_Module = llvm::parseAssemblyString(std::string(kPrelude) + function, error, m_Context);
+        if (!m_Module)
+        {
+            ADD_FAILURE() << error.getMessage().str();
+            return nullptr;
+        }
+
+        llvm::Function *f = m_Module->getFunction("f");
+        llvm::FunctionAnalysisManager analysisManager;
+        HeapToStackPass(&m_Remarks).run(*f, analysisManager);
+        return f;
+    }
+
+    static unsigned CountCalls(llvm::Function *function, const std::string &callee)
+    {
+        unsigned count = 0;
+        for (llvm::Instruction &instruction : llvm::instructions(*function))
+        {
+            auto *call = llvm::dyn_cast<llvm::CallInst>(&instruction);
+            if (call && call->getCalledFunction() && call->getCalledFunction()->getName() == callee)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static llvm::AllocaInst *FirstAlloca(llvm::Function *function)
+    {
+        for (llvm::Instruction &instruction : function->getEntryBlock())
+        {
+            if (auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(&instruction))
+            {
+                return alloca;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<std::string> m_Remarks;
+
+  private:
+    llvm::LLVMContext m_Context;
+    std::unique_ptr<llvm::Module> m_Module;
+};
+
+} // namespace
+
+TEST_F(HeapToStackTest, MovesLocalAllocationAndDropsFree)
+{
+    // Given
+    std::string function = "define i64 @f() {\n"
+                           "  %alloc = call align 16 i8* @malloc(i64 16)\n"
+                           "  %p = bitcast i8* %alloc to %Point*\n"
+                           "  %x = getelementptr inbounds %Point, %Point* %p, i32 0, i32 0\n"
+                           "  store i64 7, i64* %x\n"
+                           "  %v = load i64, i64* %x\n"
+                           "  call void @free(i8* %alloc)\n"
+                           "  ret i64 %v\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 0u);
+    EXPECT_EQ(CountCalls(f, "free"), 0u);
+    llvm::AllocaInst *slot = FirstAlloca(f);
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->getAlign().value(), 16u);
+    ASSERT_EQ(m_Remarks.size(), 1u);
+    EXPECT_EQ(m_Remarks[0], "f: 16-byte allocation of Point moved to the stack, 1 free removed");
+}
+
+TEST_F(HeapToStackTest, KeepsAlignmentOfAlignedAlloc)
+{
+    // Given
+    std::string function = "define void @f() {\n"
+                           "  %alloc = call align 64 i8* @aligned_alloc(i64 64, i64 64)\n"
+                           "  store i8 1, i8* %alloc\n"
+                           "  call void @free(i8* %alloc)\n"
+                           "  ret void\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "aligned_alloc"), 0u);
+    llvm::AllocaInst *slot = FirstAlloca(f);
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->getAlign().value(), 64u);
+}
+
+TEST_F(HeapToStackTest, PointerStoredToMemoryEscapes)
+{
+    // Given
+    std::string function = "define void @f(i8** %out) {\n"
+                           "  %alloc = call i8* @malloc(i64 16)\n"
+                           "  store i8* %alloc, i8** %out\n"
+                           "  ret void\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+    EXPECT_TRUE(m_Remarks.empty());
+}
+
+TEST_F(HeapToStackTest, PointerMergedByPhiEscapes)
+{
+    // Given
+    std::string function = "define i8 @f(i1 %c, i8* %other) {\n"
+                           "entry:\n"
+                           "  %alloc = call i8* @malloc(i64 16)\n"
+                           "  br i1 %c, label %then, label %join\n"
+                           "then:\n"
+                           "  br label %join\n"
+                           "join:\n"
+                           "  %p = phi i8* [ %alloc, %entry ], [ %other, %then ]\n"
+                           "  %v = load i8, i8* %p\n"
+                           "  call void @free(i8* %alloc)\n"
+                           "  ret i8 %v\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+    EXPECT_EQ(CountCalls(f, "free"), 1u);
+}
+
+TEST_F(HeapToStackTest, PointerPassedToCallEscapes)
+{
+    // Given
+    std::string function = "define void @f() {\n"
+                           "  %alloc = call i8* @malloc(i64 16)\n"
+                           "  %field = getelementptr inbounds i8, i8* %alloc, i64 8\n"
+                           "  call void @consume(i8* %field)\n"
+                           "  call void @free(i8* %alloc)\n"
+                           "  ret void\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+    EXPECT_EQ(CountCalls(f, "free"), 1u);
+}
+
+TEST_F(HeapToStackTest, ReturnedPointerEscapes)
+{
+    // Given
+    std::string function = "define %Point* @f() {\n"
+                           "  %alloc = call i8* @malloc(i64 16)\n"
+                           "  %p = bitcast i8* %alloc to %Point*\n"
+                           "  ret %Point* %p\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+    EXPECT_TRUE(m_Remarks.empty());
+}
+
+TEST_F(HeapToStackTest, LargeAllocationStaysOnHeap)
+{
+    // Given
+    std::string function = "define void @f() {\n"
+                           "  %alloc = call i8* @malloc(i64 4096)\n"
+                           "  store i8 1, i8* %alloc\n"
+                           "  call void @free(i8* %alloc)\n"
+                           "  ret void\n"
+                           "}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+}
+
+TEST_F(HeapToStackTest, FrameBudgetLimitsMovedAllocations)
+{
+    // Given: five 1 KiB allocations, the 4 KiB frame budget takes four
+    std::string body;
+    for (int i = 0; i < 5; ++i)
+    {
+        std::string name = "%a" + std::to_string(i);
+        body += "  " + name + " = call i8* @malloc(i64 1024)\n" + "  store i8 1, i8* " + name + "\n" +
+                "  call void @free(i8* " + name + ")\n";
+    }
+    std::string function = "define void @f() {\n" + body + "  ret void\n}\n";
+
+    // When
+    llvm::Function *f = RunPass(function);
+
+    // Then
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(CountCalls(f, "malloc"), 1u);
+    EXPECT_EQ(CountCalls(f, "free"), 1u);
+    EXPECT_EQ(m_Remarks.size(), 4u);
+}
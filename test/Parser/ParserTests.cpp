@@ -0,0 +1,526 @@
+#include <gtest/gtest.h>
+
+#include "../../src/Parser/Parser.h"
+#include "../../src/Scanner/Scanner.h"
+
+#include <memory>
+#include <string>
+
+using namespace jlang;
+
+namespace
+{
+
+const char *ToString(BinaryOp op)
+{
+    switch (op)
+    {
+    case BinaryOp::Add:
+        return "+";
+    case BinaryOp::Sub:
+        return "-";
+    case BinaryOp::Mul:
+        return "*";
+    case BinaryOp::Div:
+        return "/";
+    case BinaryOp::Mod:
+        return "%";
+    case BinaryOp::BitAnd:
+        return "&";
+    case BinaryOp::BitOr:
+        return "|";
+    case BinaryOp::BitXor:
+        return "^";
+    case BinaryOp::Shl:
+        return "<<";
+    case BinaryOp::Shr:
+        return ">>";
+    case BinaryOp::Equal:
+        return "==";
+    case BinaryOp::NotEqual:
+        return "!=";
+    case BinaryOp::Less:
+        return "<";
+    case BinaryOp::LessEqual:
+        return "<=";
+    case BinaryOp::Greater:
+        return ">";
+    case BinaryOp::GreaterEqual:
+        return ">=";
+    case BinaryOp::LogicalAnd:
+        return "&&";
+    case BinaryOp::LogicalOr:
+        return "||";
+    case BinaryOp::EagerAnd:
+        return "and";
+    case BinaryOp::EagerOr:
+        return "or";
+    }
+    return "?";
+}
+
+// Renders an expression fully parenthesized, so the expected strings spell out the tree shape
+std::string Render(AstNode *node)
+{
+    if (auto *binary = dynamic_cast<BinaryExpr *>(node))
+    {
+        return "(" + Render(binary->left) + " " + ToString(binary->op) + " " + Render(binary->right) + ")";
+    }
+    if (auto *unary = dynamic_cast<UnaryExpr *>(node))
+    {
+        return std::string(unary->op == UnaryOp::Not ? "!" : "~") + Render(unary->operand);
+    }
+    if (auto *assign = dynamic_cast<AssignExpr *>(node))
+    {
+        return "(" + assign->name + " = " + Render(assign->value) + ")";
+    }
+    if (auto *assign = dynamic_cast<IndexAssignExpr *>(node))
+    {
+        std::string op = assign->compoundOp ? std::string(ToString(*assign->compoundOp)) + "=" : "=";
+        return "(" + Render(assign->target) + " " + op + " " + Render(assign->value) + ")";
+    }
+    if (auto *assign = dynamic_cast<MemberAssignExpr *>(node))
+    {
+        std::string op = assign->compoundOp ? std::string(ToString(*assign->compoundOp)) + "=" : "=";
+        return "(" + Render(assign->target) + " " + op + " " + Render(assign->value) + ")";
+    }
+    if (auto *literal = dynamic_cast<StructLiteralExpr *>(node))
+    {
+        std::string fields;
+        for (const FieldInitializer &field : literal->fields)
+        {
+            fields += (fields.empty() ? "" : ", ") + field.name + ": " + Render(field.value);
+        }
+        return literal->structName + "{" + fields + "}";
+    }
+    if (auto *index = dynamic_cast<IndexExpr *>(node))
+    {
+        return Render(index->object) + "[" + Render(index->index) + "]";
+    }
+    if (auto *member = dynamic_cast<MemberAccessExpr *>(node))
+    {
+        return Render(member->object) + "." + member->memberName;
+    }
+    if (auto *postfix = dynamic_cast<PostfixExpr *>(node))
+    {
+        return Render(postfix->operand) + (postfix->op == UnaryOp::Increment ? "++" : "--");
+    }
+    if (auto *var = dynamic_cast<VarExpr *>(node))
+    {
+        return var->name;
+    }
+    if (auto *literal = dynamic_cast<LiteralExpr *>(node))
+    {
+        return literal->value;
+    }
+    return "<unexpected>";
+}
+
+// The top-level declarations of a source, kept alive by the arena that owns them
+struct ParsedProgram
+{
+    std::unique_ptr<AstArena> arena;
+    std::vector<AstNode *> declarations;
+};
+
+ParsedProgram ParseProgram(const std::string &source)
+{
+    Scanner scanner(source);
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    ParsedProgram program{std::make_unique<AstArena>(), {}};
+    Parser parser(tokens, *program.arena);
+    program.declarations = parser.Parse();
+    return program;
+}
+
+// Parses "fn f() { <statement> }" and renders the expression of its only statement
+std::string ParseStatementExpression(const std::string &statement)
+{
+    std::string source = "fn f() -> i32 { " + statement + " }";
+    ParsedProgram program = ParseProgram(source);
+
+    auto *function =
+        program.declarations.empty() ? nullptr : dynamic_cast<FunctionDecl *>(program.declarations[0]);
+    auto *body = function ? dynamic_cast<BlockStatement *>(function->body) : nullptr;
+    if (!body || body->statements.size() != 1)
+    {
+        return "<parse error>";
+    }
+
+    AstNode *statement0 = body->statements[0];
+    if (auto *returnStmt = dynamic_cast<ReturnStatement *>(statement0))
+    {
+        return Render(returnStmt->value);
+    }
+    if (auto *exprStmt = dynamic_cast<ExprStatement *>(statement0))
+    {
+        return Render(exprStmt->expression);
+    }
+    return "<unexpected statement>";
+}
+
+std::string ParseExpression(const std::string &expression)
+{
+    return ParseStatementExpression("return " + expression + ";");
+}
+
+// Parses "fn f() { <loop> }" and renders the attributes of the loop as "name(arg,arg) name"
+std::string ParseLoopAttributes(const std::string &loop)
+{
+    std::string source = "fn f() { " + loop + " }";
+    ParsedProgram program = ParseProgram(source);
+
+    auto *function =
+        program.declarations.empty() ? nullptr : dynamic_cast<FunctionDecl *>(program.declarations[0]);
+    auto *body = function ? dynamic_cast<BlockStatement *>(function->body) : nullptr;
+    if (!body || body->statements.size() != 1)
+    {
+        return "<parse error>";
+    }
+
+    const std::vector<Attribute> *attributes = nullptr;
+    if (auto *forStmt = dynamic_cast<ForStatement *>(body->statements[0]))
+    {
+        attributes = &forStmt->attributes;
+    }
+    else if (auto *whileStmt = dynamic_cast<WhileStatement *>(body->statements[0]))
+    {
+        attributes = &whileStmt->attributes;
+    }
+    else
+    {
+        return "<not a loop>";
+    }
+
+    std::string rendered;
+    for (const Attribute &attribute : *attributes)
+    {
+        rendered += rendered.empty() ? attribute.name : " " + attribute.name;
+        if (!attribute.args.empty())
+        {
+            rendered += "(";
+            for (size_t i = 0; i < attribute.args.size(); ++i)
+            {
+                rendered += (i > 0 ? "," : "") + attribute.args[i];
+            }
+            rendered += ")";
+        }
+    }
+    return rendered;
+}
+
+} // namespace
+
+TEST(ParserTest, MultiplicationBindsTighterThanAddition)
+{
+    EXPECT_EQ(ParseExpression("1 + 2 * 3"), "(1 + (2 * 3))");
+    EXPECT_EQ(ParseExpression("1 * 2 + 3"), "((1 * 2) + 3)");
+}
+
+TEST(ParserTest, SamePrecedenceIsLeftAssociative)
+{
+    EXPECT_EQ(ParseExpression("1 - 2 - 3"), "((1 - 2) - 3)");
+    EXPECT_EQ(ParseExpression("8 / 4 % 3 * 2"), "(((8 / 4) % 3) * 2)");
+    EXPECT_EQ(ParseExpression("a < b == c != d"), "(((a < b) == c) != d)");
+}
+
+TEST(ParserTest, FollowsFullPrecedenceLadder)
+{
+    EXPECT_EQ(ParseExpression("a || b && c | d ^ e & f == g < h << i + j * k"),
+              "(a || (b && (c | (d ^ (e & (f == (g < (h << (i + (j * k))))))))))");
+    EXPECT_EQ(ParseExpression("a * b + c << d < e == f & g ^ h | i && j || k"),
+              "((((((((((a * b) + c) << d) < e) == f) & g) ^ h) | i) && j) || k)");
+}
+
+TEST(ParserTest, KeywordLogicalOperatorsShareSymbolPrecedence)
+{
+    EXPECT_EQ(ParseExpression("a or b and c"), "(a or (b and c))");
+    EXPECT_EQ(ParseExpression("a and b && c"), "((a and b) && c)");
+}
+
+TEST(ParserTest, UnaryBindsTighterThanBinary)
+{
+    EXPECT_EQ(ParseExpression("!a && ~b + c"), "(!a && (~b + c))");
+}
+
+TEST(ParserTest, GroupedExpressionOverridesPrecedence)
+{
+    EXPECT_EQ(ParseExpression("(1 + 2) * 3"), "((1 + 2) * 3)");
+}
+
+TEST(ParserTest, CompoundAssignmentWrapsWholeRightHandSide)
+{
+    EXPECT_EQ(ParseStatementExpression("x += 1 + 2 * 3;"), "(x = (x + (1 + (2 * 3))))");
+    EXPECT_EQ(ParseStatementExpression("x <<= 1 | 2;"), "(x = (x << (1 | 2)))");
+}
+
+TEST(ParserTest, IndexBindsTighterThanBinaryOperators)
+{
+    EXPECT_EQ(ParseExpression("a[i + 1] * 2"), "(a[(i + 1)] * 2)");
+    EXPECT_EQ(ParseExpression("s.items[i].len"), "s.items[i].len");
+}
+
+TEST(ParserTest, IndexAssignmentTargetsElement)
+{
+    EXPECT_EQ(ParseStatementExpression("a[i] = 3;"), "(a[i] = 3)");
+}
+
+TEST(ParserTest, CompoundIndexAssignmentKeepsOneTarget)
+{
+    // Desugaring to a[i++] = a[i++] + 5 would run the increment twice
+    EXPECT_EQ(ParseStatementExpression("a[i++] += 5;"), "(a[i++] += 5)");
+    EXPECT_EQ(ParseStatementExpression("a[i] <<= 1 | 2;"), "(a[i] <<= (1 | 2))");
+}
+
+TEST(ParserTest, MemberAssignmentTargetsField)
+{
+    EXPECT_EQ(ParseStatementExpression("p.X = 3;"), "(p.X = 3)");
+    EXPECT_EQ(ParseStatementExpression("ps[i++].Mass *= 2;"), "(ps[i++].Mass *= 2)");
+}
+
+TEST(ParserTest, ParsesStructLiterals)
+{
+    EXPECT_EQ(ParseExpression("Point{X: 1, Y: a + 2}"), "Point{X: 1, Y: (a + 2)}");
+    EXPECT_EQ(ParseExpression("Point{}"), "Point{}");
+    EXPECT_EQ(ParseExpression("Rect{Min: Point{X: 1,}, Max: p}"), "Rect{Min: Point{X: 1}, Max: p}");
+}
+
+TEST(ParserTest, ParsesArrayAndSliceTypes)
+{
+    // Given
+    std::string source = "fn f(values: []f32, grid: [16]i32*) -> [4]u8 { }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    auto *function =
+        program.declarations.empty() ? nullptr : dynamic_cast<FunctionDecl *>(program.declarations[0]);
+    ASSERT_NE(function, nullptr);
+    ASSERT_EQ(function->params.size(), 2);
+
+    EXPECT_TRUE(function->params[0].type.isSlice);
+    EXPECT_EQ(function->params[0].type.name, "f32");
+
+    EXPECT_EQ(function->params[1].type.arraySize, 16);
+    EXPECT_TRUE(function->params[1].type.isPointer);
+    EXPECT_EQ(function->params[1].type.ElementType().name, "i32");
+    EXPECT_TRUE(function->params[1].type.ElementType().isPointer);
+
+    EXPECT_EQ(function->returnType.arraySize, 4);
+    EXPECT_EQ(function->returnType.name, "u8");
+}
+
+TEST(ParserTest, RejectsEmptyAndOversizedArrays)
+{
+    // Given
+    std::string source = "struct Buffers {\n"
+                         "    empty: [0]i32;\n"
+                         "    huge: [99999999999999999999999]i32;\n"
+                         "    wide: [4294967296]i32*;\n"
+                         "    largest: [4294967295]u8;\n"
+                         "    tail: i32;\n"
+                         "}";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 1);
+    auto *buffers = dynamic_cast<StructDecl *>(program.declarations[0]);
+    ASSERT_NE(buffers, nullptr);
+    ASSERT_EQ(buffers->fields.size(), 2);
+
+    EXPECT_EQ(buffers->fields[0].name, "largest");
+    EXPECT_EQ(buffers->fields[0].type.arraySize, 4294967295u);
+    EXPECT_EQ(buffers->fields[1].name, "tail");
+    EXPECT_TRUE(buffers->fields[1].type.IsScalar());
+}
+
+TEST(ParserTest, ParsesVectorTypes)
+{
+    // Given
+    std::string source = "fn f(v: f32x8, data: i16x8*) -> u32x4 { }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    auto *function =
+        program.declarations.empty() ? nullptr : dynamic_cast<FunctionDecl *>(program.declarations[0]);
+    ASSERT_NE(function, nullptr);
+    ASSERT_EQ(function->params.size(), 2);
+
+    EXPECT_TRUE(function->params[0].type.IsVector());
+    EXPECT_EQ(function->params[0].type.VectorLanes(), 8);
+    EXPECT_EQ(function->params[0].type.ElementType().name, "f32");
+
+    EXPECT_FALSE(function->params[1].type.IsVector());
+    EXPECT_TRUE(function->params[1].type.isPointer);
+
+    EXPECT_TRUE(function->returnType.ElementType().IsUnsignedInteger());
+}
+
+TEST(ParserTest, LoopWithoutAttributesHasNone)
+{
+    EXPECT_EQ(ParseLoopAttributes("for (var i: i32 = 0; i < 4; i++) {}"), "");
+}
+
+TEST(ParserTest, ParsesAttributesInFrontOfLoops)
+{
+    EXPECT_EQ(ParseLoopAttributes("#[unroll(4)] for (var i: i32 = 0; i < n; i++) {}"), "unroll(4)");
+    EXPECT_EQ(ParseLoopAttributes("#[unroll] while (x) {}"), "unroll");
+}
+
+TEST(ParserTest, CollectsAttributesFromListsAndRepeatedGroups)
+{
+    EXPECT_EQ(ParseLoopAttributes("#[vectorize(4), interleave(2)] #[unroll(disable)] while (x) {}"),
+              "vectorize(4) interleave(2) unroll(disable)");
+}
+
+TEST(ParserTest, ParsesFunctionAttributesAndInline)
+{
+    // Given
+    std::string source = "#[noinline] fn cold() { }\n"
+                         "#[always_inline, flatten] inline fn hot() { }\n"
+                         "fn plain() { }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 3);
+
+    auto *cold = dynamic_cast<FunctionDecl *>(program.declarations[0]);
+    ASSERT_NE(cold, nullptr);
+    EXPECT_EQ(cold->name, "cold");
+    EXPECT_FALSE(cold->isInline);
+    ASSERT_EQ(cold->attributes.size(), 1);
+    EXPECT_EQ(cold->attributes[0].name, "noinline");
+
+    auto *hot = dynamic_cast<FunctionDecl *>(program.declarations[1]);
+    ASSERT_NE(hot, nullptr);
+    EXPECT_TRUE(hot->isInline);
+    ASSERT_EQ(hot->attributes.size(), 2);
+    EXPECT_EQ(hot->attributes[1].name, "flatten");
+
+    auto *plain = dynamic_cast<FunctionDecl *>(program.declarations[2]);
+    ASSERT_NE(plain, nullptr);
+    EXPECT_FALSE(plain->isInline);
+    EXPECT_TRUE(plain->attributes.empty());
+}
+
+TEST(ParserTest, FunctionVisibilityFollowsCapitalization)
+{
+    // Given
+    std::string source = "fn Exported() { } fn helper() { }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 2);
+
+    EXPECT_TRUE(static_cast<FunctionDecl *>(program.declarations[0])->isPublic);
+    EXPECT_FALSE(static_cast<FunctionDecl *>(program.declarations[1])->isPublic);
+}
+
+TEST(ParserTest, ParsesMatchArmsWithRangesAndAlternatives)
+{
+    // Given
+    std::string source = "fn f(c: char) -> i32 {\n"
+                         "    match (c) {\n"
+                         "        '0'..='9' => return 0;\n"
+                         "        'a' | 'b'..'f' => { return 1; }\n"
+                         "        _ => return 2;\n"
+                         "    }\n"
+                         "}";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 1);
+
+    auto *body = dynamic_cast<BlockStatement *>(static_cast<FunctionDecl *>(program.declarations[0])->body);
+    ASSERT_NE(body, nullptr);
+    ASSERT_EQ(body->statements.size(), 1);
+
+    auto *match = dynamic_cast<MatchStatement *>(body->statements[0]);
+    ASSERT_NE(match, nullptr);
+    EXPECT_NE(dynamic_cast<VarExpr *>(match->value), nullptr);
+    ASSERT_EQ(match->arms.size(), 3);
+
+    const MatchArm &digits = match->arms[0];
+    ASSERT_EQ(digits.patterns.size(), 1);
+    EXPECT_NE(digits.patterns[0].high, nullptr);
+    EXPECT_TRUE(digits.patterns[0].isInclusive);
+
+    const MatchArm &letters = match->arms[1];
+    ASSERT_EQ(letters.patterns.size(), 2);
+    EXPECT_EQ(letters.patterns[0].high, nullptr);
+    EXPECT_FALSE(letters.patterns[1].isInclusive);
+    EXPECT_NE(dynamic_cast<BlockStatement *>(letters.body), nullptr);
+
+    EXPECT_TRUE(match->arms[2].isWildcard);
+    EXPECT_TRUE(match->arms[2].patterns.empty());
+}
+
+TEST(ParserTest, AttributesInFrontOfStructBelongToTheStruct)
+{
+    // Given
+    std::string source = "#[repr(C)] struct Header { tag: u8; length: u32; }\n"
+                         "struct Plain { value: i32; }\n"
+                         "#[noinline] fn cold() { }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 3);
+
+    auto *header = dynamic_cast<StructDecl *>(program.declarations[0]);
+    ASSERT_NE(header, nullptr);
+    EXPECT_EQ(header->fields.size(), 2);
+    ASSERT_EQ(header->attributes.size(), 1);
+    EXPECT_EQ(header->attributes[0].name, "repr");
+    ASSERT_EQ(header->attributes[0].args.size(), 1);
+    EXPECT_EQ(header->attributes[0].args[0], "C");
+
+    auto *plain = dynamic_cast<StructDecl *>(program.declarations[1]);
+    ASSERT_NE(plain, nullptr);
+    EXPECT_TRUE(plain->attributes.empty());
+
+    auto *cold = dynamic_cast<FunctionDecl *>(program.declarations[2]);
+    ASSERT_NE(cold, nullptr);
+    ASSERT_EQ(cold->attributes.size(), 1);
+}
+
+TEST(ParserTest, ParsesAlignmentAttributesOnStructsAndFields)
+{
+    // Given
+    std::string source = "#[align(64)] struct Counter { Hits: u64; }\n"
+                         "#[packed] struct Wire { tag: u8; #[align(4)] length: u32; checksum: u16; }";
+
+    // When
+    ParsedProgram program = ParseProgram(source);
+
+    // Then
+    ASSERT_EQ(program.declarations.size(), 2);
+
+    auto *counter = static_cast<StructDecl *>(program.declarations[0]);
+    ASSERT_EQ(counter->attributes.size(), 1);
+    EXPECT_EQ(counter->attributes[0].name, "align");
+    ASSERT_EQ(counter->attributes[0].args.size(), 1);
+    EXPECT_EQ(counter->attributes[0].args[0], "64");
+
+    auto *wire = static_cast<StructDecl *>(program.declarations[1]);
+    ASSERT_EQ(wire->attributes.size(), 1);
+    EXPECT_EQ(wire->attributes[0].name, "packed");
+    ASSERT_EQ(wire->fields.size(), 3);
+    EXPECT_TRUE(wire->fields[0].attributes.empty());
+    ASSERT_EQ(wire->fields[1].attributes.size(), 1);
+    EXPECT_EQ(wire->fields[1].attributes[0].name, "align");
+    EXPECT_EQ(wire->fields[1].name, "length");
+}
@@ -165,6 +165,39 @@ TEST(ScannerTest, TokenizesFnKeyword)
     EXPECT_EQ(tokens[0].m_lexeme, "fn");
 }
 
+TEST(ScannerTest, TokenizesInlineKeyword)
+{
+    // Given
+    Scanner scanner("inline");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Inline);
+    EXPECT_EQ(tokens[0].m_lexeme, "inline");
+}
+
+TEST(ScannerTest, TokenizesMatchArrowAndRangeOperators)
+{
+    // Given
+    Scanner scanner("match 1..=9 => 0..8 == x = y");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 13);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Match);
+    EXPECT_EQ(tokens[2].m_type, TokenType::DotDotEqual);
+    EXPECT_EQ(tokens[4].m_type, TokenType::FatArrow);
+    EXPECT_EQ(tokens[6].m_type, TokenType::DotDot);
+    EXPECT_EQ(tokens[7].m_lexeme, "8");
+    EXPECT_EQ(tokens[8].m_type, TokenType::EqualEqual);
+    EXPECT_EQ(tokens[10].m_type, TokenType::Equal);
+}
+
 TEST(ScannerTest, TokenizesVarKeyword)
 {
     // Given
@@ -678,6 +711,41 @@ TEST(ScannerTest, TokenizesMinus)
     EXPECT_EQ(tokens[0].m_lexeme, "-");
 }
 
+TEST(ScannerTest, TokenizesAttributeBrackets)
+{
+    // Given
+    Scanner scanner("#[unroll(4)]");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 8);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Hash);
+    EXPECT_EQ(tokens[1].m_type, TokenType::LBracket);
+    EXPECT_EQ(tokens[2].m_type, TokenType::Identifier);
+    EXPECT_EQ(tokens[3].m_type, TokenType::LParen);
+    EXPECT_EQ(tokens[4].m_type, TokenType::NumberLiteral);
+    EXPECT_EQ(tokens[5].m_type, TokenType::RParen);
+    EXPECT_EQ(tokens[6].m_type, TokenType::RBracket);
+}
+
+TEST(ScannerTest, TokenizesVectorTypeKeywords)
+{
+    // Given
+    Scanner scanner("f32x4 u8x32 f32x3");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_EQ(tokens[0].m_type, TokenType::VectorType);
+    EXPECT_EQ(tokens[0].m_lexeme, "f32x4");
+    EXPECT_EQ(tokens[1].m_type, TokenType::VectorType);
+    EXPECT_EQ(tokens[2].m_type, TokenType::Identifier);
+}
+
 TEST(ScannerTest, TokenizesUnknownCharacter)
 {
     // Given
@@ -803,9 +871,9 @@ TEST(ScannerTest, TracksLineNumbersAcrossNewlines)
     // Then
     ASSERT_EQ(tokens.size(), 3);
     EXPECT_EQ(tokens[0].m_type, TokenType::Var);
-    EXPECT_EQ(tokens[0].m_CurrentLine, 1);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).line, 1);
     EXPECT_EQ(tokens[1].m_type, TokenType::Fn);
-    EXPECT_EQ(tokens[1].m_CurrentLine, 3);
+    EXPECT_EQ(scanner.GetLocation(tokens[1]).line, 3);
 }
 
 TEST(ScannerTest, TracksLineNumberInMultilineString)
@@ -821,7 +889,7 @@ TEST(ScannerTest, TracksLineNumberInMultilineString)
     ASSERT_EQ(tokens.size(), 3);
     EXPECT_EQ(tokens[0].m_type, TokenType::StringLiteral);
     EXPECT_EQ(tokens[1].m_type, TokenType::Var);
-    EXPECT_EQ(tokens[1].m_CurrentLine, 3);
+    EXPECT_EQ(scanner.GetLocation(tokens[1]).line, 3);
 }
 
 // Whitespace handling
@@ -1237,3 +1305,145 @@ TEST(ScannerTest, TokenizesPlusSpaceEqualAsSeparateTokens)
     EXPECT_EQ(tokens[0].m_type, TokenType::Plus);
     EXPECT_EQ(tokens[1].m_type, TokenType::Equal);
 }
+
+TEST(ScannerTest, ScansOnlyWithinNonNullTerminatedView)
+{
+    // Given
+    std::string buffer = "var x";
+    Scanner scanner(std::string_view(buffer.data(), 3));
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Var);
+    EXPECT_EQ(tokens[1].m_type, TokenType::EndOfFile);
+}
+
+TEST(ScannerTest, ComputesColumnFromLineTable)
+{
+    // Given
+    Scanner scanner("fn main() {\n    return 0;\n}");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+    SourceLocation location = scanner.GetLocation(tokens[5]);
+
+    // Then
+    ASSERT_EQ(tokens[5].m_type, TokenType::Return);
+    EXPECT_EQ(location.line, 2);
+    EXPECT_EQ(location.column, 5);
+}
+
+TEST(ScannerTest, TracksLineNumbersAcrossBlockComments)
+{
+    // Given
+    Scanner scanner("/* one\ntwo\n*/ var");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Var);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).line, 3);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).column, 4);
+}
+
+TEST(ScannerTest, TokenLexemeViewsSourceBuffer)
+{
+    // Given
+    std::string source = "var counter";
+    Scanner scanner(source);
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 3);
+    EXPECT_EQ(tokens[1].m_lexeme, "counter");
+    EXPECT_EQ(tokens[1].m_lexeme.data(), source.data() + 4);
+    EXPECT_EQ(tokens[1].m_Offset, 4u);
+}
+
+TEST(ScannerTest, ScansIdentifierLongerThanVectorWidth)
+{
+    // Given
+    std::string name = "a_very_long_identifier_Name_with_digits_0123456789";
+    std::string source = name + "(";
+    Scanner scanner(source);
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 3);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Identifier);
+    EXPECT_EQ(tokens[0].m_lexeme, name);
+    EXPECT_EQ(tokens[1].m_type, TokenType::LParen);
+}
+
+TEST(ScannerTest, StopsIdentifierAtNonAsciiByte)
+{
+    // Given
+    Scanner scanner("abcdefghijklmnopqrstu\xC3\xA9");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_GE(tokens.size(), 2);
+    EXPECT_EQ(tokens[0].m_type, TokenType::Identifier);
+    EXPECT_EQ(tokens[0].m_lexeme, "abcdefghijklmnopqrstu");
+}
+
+TEST(ScannerTest, SkipsLongWhitespaceAndLineComments)
+{
+    // Given
+    std::string source =
+        std::string(37, ' ') + "\t\r\n// a line comment that spans several chunks\n  123456789012345678";
+    Scanner scanner(source);
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(tokens[0].m_type, TokenType::NumberLiteral);
+    EXPECT_EQ(tokens[0].m_lexeme, "123456789012345678");
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).line, 3);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).column, 3);
+}
+
+TEST(ScannerTest, FindsBlockCommentCloseAtEveryChunkOffset)
+{
+    for (size_t padding = 0; padding < 40; ++padding)
+    {
+        // Given
+        std::string source = "/*" + std::string(padding, '*') + "*/var";
+        Scanner scanner(source);
+
+        // When
+        std::vector<Token> tokens = scanner.Tokenize();
+
+        // Then
+        ASSERT_EQ(tokens.size(), 2) << "padding " << padding;
+        EXPECT_EQ(tokens[0].m_type, TokenType::Var) << "padding " << padding;
+        EXPECT_EQ(tokens[0].m_Offset, padding + 4) << "padding " << padding;
+    }
+}
+
+TEST(ScannerTest, CountsManyNewlinesWithinOneChunk)
+{
+    // Given
+    Scanner scanner("\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\nvar");
+
+    // When
+    std::vector<Token> tokens = scanner.Tokenize();
+
+    // Then
+    ASSERT_EQ(tokens.size(), 2);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).line, 21);
+    EXPECT_EQ(scanner.GetLocation(tokens[0]).column, 1);
+}
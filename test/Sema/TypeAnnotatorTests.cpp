@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+
+#include "../../src/Parser/Parser.h"
+#include "../../src/Scanner/Scanner.h"
+#include "../../src/Sema/TypeAnnotator.h"
+
+#include <string>
+
+using namespace jlang;
+
+namespace
+{
+
+// Parses and annotates a program, then hands out the value of the last return statement of the
+// last function, which is where every test puts the expression under inspection
+class TypeAnnotatorTest : public ::testing::Test
+{
+  protected:
+    Expression *AnnotateReturn(const std::string &source)
+    {
+        m_Source = source;
+        Scanner scanner(m_Source);
+        m_Tokens = scanner.Tokenize();
+
+        Parser parser(m_Tokens, m_Arena);
+        std::vector<AstNode *> program = parser.Parse();
+
+        TypeAnnotator annotator;
+        annotator.Annotate(program);
+
+        auto *function = program.empty() ? nullptr : dynamic_cast<FunctionDecl *>(program.back());
+        auto *body = function ? dynamic_cast<BlockStatement *>(function->body) : nullptr;
+        if (!body || body->statements.empty())
+        {
+            return nullptr;
+        }
+
+        auto *returnStmt = dynamic_cast<ReturnStatement *>(body->statements.back());
+        return returnStmt ? dynamic_cast<Expression *>(returnStmt->value) : nullptr;
+    }
+
+    static const TypeRef &TypeOf(AstNode *node) { return static_cast<Expression *>(node)->resolvedType; }
+
+  private:
+    std::string m_Source;
+    std::vector<Token> m_Tokens;
+    AstArena m_Arena;
+};
+
+} // namespace
+
+TEST_F(TypeAnnotatorTest, UnsignedOperandsKeepTheirType)
+{
+    // Given
+    std::string source = "fn f(a: u32, b: u32) -> u32 { return a / b; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(binary->resolvedType.name, "u32");
+    EXPECT_TRUE(binary->resolvedType.IsUnsignedInteger());
+    EXPECT_TRUE(TypeOf(binary->left).IsUnsignedInteger());
+}
+
+TEST_F(TypeAnnotatorTest, LiteralAdoptsTypeOfOtherOperand)
+{
+    // Given
+    std::string source = "fn f(a: u8) -> u8 { return 200 + a; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(TypeOf(binary->left).name, "u8");
+    EXPECT_EQ(TypeOf(binary->right).name, "u8");
+}
+
+TEST_F(TypeAnnotatorTest, ReturnedLiteralAdoptsReturnType)
+{
+    // Given
+    std::string integerSource = "fn f() -> i64 { return 1; }";
+    std::string floatSource = "fn g() -> f32 { return 2; }";
+
+    // When
+    auto *literal = AnnotateReturn(integerSource);
+    auto *floating = AnnotateReturn(floatSource);
+
+    // Then
+    ASSERT_NE(literal, nullptr);
+    EXPECT_EQ(literal->resolvedType.name, "i64");
+    ASSERT_NE(floating, nullptr);
+    EXPECT_EQ(floating->resolvedType.name, "f32");
+}
+
+TEST_F(TypeAnnotatorTest, ComparisonIsBoolWithUnifiedOperands)
+{
+    // Given
+    std::string source = "fn f(a: u64) -> bool { return a < 10; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(binary->resolvedType.name, "bool");
+    EXPECT_EQ(TypeOf(binary->right).name, "u64");
+}
+
+TEST_F(TypeAnnotatorTest, UntypedLiteralsDefaultToI32AndF64)
+{
+    // Given
+    std::string integerSource = "fn f() -> bool { return 1 + 2 == 3; }";
+    std::string floatSource = "fn g() -> bool { return 1.5 < 2.5; }";
+
+    // When
+    auto *integer = AnnotateReturn(integerSource);
+    auto *floating = AnnotateReturn(floatSource);
+
+    // Then
+    ASSERT_NE(integer, nullptr);
+    EXPECT_EQ(TypeOf(static_cast<BinaryExpr *>(integer)->left).name, "i32");
+    ASSERT_NE(floating, nullptr);
+    EXPECT_EQ(TypeOf(static_cast<BinaryExpr *>(floating)->left).name, "f64");
+}
+
+TEST_F(TypeAnnotatorTest, NullTakesPointerTypeFromComparison)
+{
+    // Given
+    std::string source = "struct Node { next: Node*?; }\n"
+                         "fn f(n: Node*?) -> bool { return n == null; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(TypeOf(binary->right).name, "Node");
+    EXPECT_TRUE(TypeOf(binary->right).isPointer);
+}
+
+TEST_F(TypeAnnotatorTest, InferredVariableTakesInitializerType)
+{
+    // Given
+    std::string source = "fn f(a: u16) -> u16 { var b := a; return b; }";
+
+    // When
+    auto *var = AnnotateReturn(source);
+
+    // Then
+    ASSERT_NE(var, nullptr);
+    EXPECT_EQ(var->resolvedType.name, "u16");
+}
+
+TEST_F(TypeAnnotatorTest, CallResultAndArgumentsUseSignature)
+{
+    // Given
+    std::string source = "fn g(x: u8) -> u32 { return 0; }\n"
+                         "fn f() -> u32 { return g(5); }";
+
+    // When
+    auto *call = dynamic_cast<CallExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(call, nullptr);
+    EXPECT_EQ(call->resolvedType.name, "u32");
+    EXPECT_EQ(TypeOf(call->arguments[0]).name, "u8");
+}
+
+TEST_F(TypeAnnotatorTest, MemberAccessUsesFieldType)
+{
+    // Given
+    std::string source = "struct Counter { hits: u64; }\n"
+                         "fn f(c: Counter*) -> u64 { return c.hits; }";
+
+    // When
+    auto *member = AnnotateReturn(source);
+
+    // Then
+    ASSERT_NE(member, nullptr);
+    EXPECT_EQ(member->resolvedType.name, "u64");
+}
+
+TEST_F(TypeAnnotatorTest, StructLiteralFieldsTakeFieldTypes)
+{
+    // Given
+    std::string source = "struct Pixel { Level: u8; Gain: f32; }\n"
+                         "fn f() -> Pixel { return Pixel{Level: 200, Gain: 2}; }";
+
+    // When
+    auto *literal = dynamic_cast<StructLiteralExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(literal, nullptr);
+    EXPECT_EQ(literal->resolvedType.name, "Pixel");
+    EXPECT_FALSE(literal->resolvedType.isPointer);
+    EXPECT_EQ(TypeOf(literal->fields[0].value).name, "u8");
+    EXPECT_EQ(TypeOf(literal->fields[1].value).name, "f32");
+}
+
+TEST_F(TypeAnnotatorTest, SoaArrayFieldIsWholeColumn)
+{
+    // Given
+    const std::string particle = "#[soa] struct Particle { X: f32; Alive: bool; }\n";
+    std::string columnSource = particle + "fn f(ps: [64]Particle) -> []f32 { return ps.X; }";
+    std::string elementSource = particle + "fn g(ps: [64]Particle) -> bool { return ps[3].Alive; }";
+
+    // When
+    auto *column = AnnotateReturn(columnSource);
+    auto *element = AnnotateReturn(elementSource);
+
+    // Then
+    ASSERT_NE(column, nullptr);
+    EXPECT_EQ(column->resolvedType.name, "f32");
+    EXPECT_EQ(column->resolvedType.arraySize, 64u);
+    ASSERT_NE(element, nullptr);
+    EXPECT_EQ(element->resolvedType.name, "bool");
+    EXPECT_FALSE(element->resolvedType.IsArray());
+}
+
+TEST_F(TypeAnnotatorTest, IndexYieldsElementType)
+{
+    // Given
+    std::string source = "fn f(values: []u16) -> u16 { return values[2]; }";
+
+    // When
+    auto *index = dynamic_cast<IndexExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->resolvedType.name, "u16");
+    EXPECT_TRUE(index->resolvedType.IsScalar());
+    EXPECT_EQ(TypeOf(index->index).name, "i64");
+}
+
+TEST_F(TypeAnnotatorTest, ArrayLengthIsU64)
+{
+    // Given
+    std::string source = "fn f() -> u64 { var a: [8]f32; return a.len; }";
+
+    // When
+    auto *length = AnnotateReturn(source);
+
+    // Then
+    ASSERT_NE(length, nullptr);
+    EXPECT_EQ(length->resolvedType.name, "u64");
+}
+
+TEST_F(TypeAnnotatorTest, LiteralInVectorContextIsSplat)
+{
+    // Given
+    std::string source = "fn f(v: f32x4) -> f32x4 { return 2 * v; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(binary->resolvedType.name, "f32x4");
+    EXPECT_EQ(TypeOf(binary->left).name, "f32x4");
+}
+
+TEST_F(TypeAnnotatorTest, ScalarTimesVectorIsVector)
+{
+    // Given
+    std::string source = "fn f(s: i32, v: i32x8) -> i32x8 { return s * v; }";
+
+    // When
+    auto *binary = dynamic_cast<BinaryExpr *>(AnnotateReturn(source));
+
+    // Then
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(binary->resolvedType.name, "i32x8");
+}
+
+TEST_F(TypeAnnotatorTest, VectorLaneHasElementType)
+{
+    // Given
+    std::string source = "fn f(v: u16x8) -> u16 { return v[3]; }";
+
+    // When
+    auto *lane = AnnotateReturn(source);
+
+    // Then
+    ASSERT_NE(lane, nullptr);
+    EXPECT_EQ(lane->resolvedType.name, "u16");
+}
+
+TEST_F(TypeAnnotatorTest, VectorLoadTakesTypeFromContext)
+{
+    // Given
+    std::string source = "fn f(data: []f64) -> f64x4 { return load(data, 4); }";
+
+    // When
+    auto *load = AnnotateReturn(source);
+
+    // Then
+    ASSERT_NE(load, nullptr);
+    EXPECT_EQ(load->resolvedType.name, "f64x4");
+    EXPECT_EQ(TypeOf(static_cast<CallExpr *>(load)->arguments[1]).name, "i64");
+}
+
+TEST_F(TypeAnnotatorTest, ShuffleAndReductionTypes)
+{
+    // Given
+    std::string shuffleSource = "fn f(a: i32x8) -> i32x4 { return shuffle(a, 0, 2, 4, 6); }";
+    std::string reductionSource = "fn g(a: u8x16) -> u8 { return reduce_max(a); }";
+
+    // When
+    auto *shuffle = AnnotateReturn(shuffleSource);
+    auto *reduction = AnnotateReturn(reductionSource);
+
+    // Then
+    ASSERT_NE(shuffle, nullptr);
+    EXPECT_EQ(shuffle->resolvedType.name, "i32x4");
+    ASSERT_NE(reduction, nullptr);
+    EXPECT_EQ(reduction->resolvedType.name, "u8");
+}